@@ -224,6 +224,38 @@ bool MP4WriteSample(
     MP4Duration    renderingOffset DEFAULT(0),
     bool           isSyncSample DEFAULT(true) );
 
+/** Write many track samples at once.
+ *
+ *  MP4WriteSamples writes the given samples at the end of the specified
+ *  track, like as many calls to MP4WriteSample() with a common duration,
+ *  no rendering offset and every sample being a sync sample. The samples'
+ *  data is contiguous; complete chunks are written straight from it in
+ *  large blocks, and the sample tables are grown once for all samples.
+ *
+ *  Typically this is used for audio, e.g. to write a whole chapter of AAC
+ *  access units.
+ *
+ *  @param hFile handle of file for operation.
+ *  @param trackId id of track for operation.
+ *  @param pBytes pointer to the samples' data.
+ *  @param pSampleSizes pointer to the length in bytes of each sample.
+ *  @param numSamples number of samples.
+ *  @param duration duration of each sample. Caveat: should be in track
+ *      timescale.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4WriteSample().
+ */
+MP4V2_EXPORT
+bool MP4WriteSamples(
+    MP4FileHandle   hFile,
+    MP4TrackId      trackId,
+    const uint8_t*  pBytes,
+    const uint32_t* pSampleSizes,
+    uint32_t        numSamples,
+    MP4Duration     duration DEFAULT(MP4_INVALID_DURATION) );
+
 /** Write a track sample and supply dependency information.
  *
  *  MP4WriteSampleDependency writes the given sample at the end of the specified track.
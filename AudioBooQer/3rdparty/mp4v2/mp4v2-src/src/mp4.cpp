@@ -3093,6 +3093,35 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         return false;
     }
 
+    bool MP4WriteSamples(
+        MP4FileHandle   hFile,
+        MP4TrackId      trackId,
+        const uint8_t*  pBytes,
+        const uint32_t* pSampleSizes,
+        uint32_t        numSamples,
+        MP4Duration     duration )
+    {
+        if( MP4_IS_VALID_FILE_HANDLE( hFile )) {
+            try {
+                ((MP4File*)hFile)->WriteSamples(
+                    trackId,
+                    pBytes,
+                    pSampleSizes,
+                    numSamples,
+                    duration );
+                return true;
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
     bool MP4WriteSampleDependency(
         MP4FileHandle  hFile,
         MP4TrackId     trackId,
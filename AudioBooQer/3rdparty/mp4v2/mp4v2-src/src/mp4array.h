@@ -99,6 +99,19 @@ protected:
                   (m_numElements - index) * sizeof(type)); \
             } \
         } \
+        void Reserve(MP4ArrayIndex newMaxSize) { \
+            if (newMaxSize <= m_maxNumElements) \
+                return; \
+            /* grow geometrically, to amortize repeated reservations */ \
+            if (m_maxNumElements < 0x80000000 && newMaxSize < m_maxNumElements * 2) \
+                newMaxSize = m_maxNumElements * 2; \
+            if ( (uint64_t) newMaxSize * sizeof(type) > 0xFFFFFFFF ) \
+               throw new PlatformException("requested array size exceeds 4GB", ERANGE, __FILE__, __LINE__, __FUNCTION__); /* prevent overflow */ \
+            m_elements = (type*)MP4Realloc(m_elements, \
+                newMaxSize * sizeof(type)); \
+            m_maxNumElements = newMaxSize; \
+        } \
+        \
         void Resize(MP4ArrayIndex newSize) { \
             m_numElements = newSize; \
             m_maxNumElements = newSize; \
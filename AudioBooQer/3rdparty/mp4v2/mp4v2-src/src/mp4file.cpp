@@ -3082,6 +3082,19 @@ void MP4File::WriteSampleDependency(
     m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
 }
 
+void MP4File::WriteSamples(
+    MP4TrackId      trackId,
+    const uint8_t*  pBytes,
+    const uint32_t* pSampleSizes,
+    uint32_t        numSamples,
+    MP4Duration     duration )
+{
+    ProtectWriteOperation(__FILE__, __LINE__, __FUNCTION__);
+    m_pTracks[FindTrackIndex(trackId)]->WriteSamples(
+        pBytes, pSampleSizes, numSamples, duration );
+    m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
+}
+
 void MP4File::SetSampleRenderingOffset(MP4TrackId trackId,
                                        MP4SampleId sampleId, MP4Duration renderingOffset)
 {
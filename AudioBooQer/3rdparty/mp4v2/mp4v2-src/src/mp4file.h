@@ -230,6 +230,13 @@ public:
         bool           isSyncSample,
         uint32_t       dependencyFlags );
 
+    void WriteSamples(
+        MP4TrackId      trackId,
+        const uint8_t*  pBytes,
+        const uint32_t* pSampleSizes,
+        uint32_t        numSamples,
+        MP4Duration     duration = 0 );
+
     void SetSampleRenderingOffset(
         MP4TrackId  trackId,
         MP4SampleId sampleId,
@@ -145,6 +145,29 @@ void MP4IntegerProperty::IncrementValue(int32_t increment, uint32_t index)
     SetValue(GetValue() + increment);
 }
 
+void MP4IntegerProperty::ReserveValues(uint32_t count)
+{
+    switch (this->GetType()) {
+    case Integer8Property:
+        ((MP4Integer8Property*)this)->ReserveValues(count);
+        break;
+    case Integer16Property:
+        ((MP4Integer16Property*)this)->ReserveValues(count);
+        break;
+    case Integer24Property:
+        ((MP4Integer24Property*)this)->ReserveValues(count);
+        break;
+    case Integer32Property:
+        ((MP4Integer32Property*)this)->ReserveValues(count);
+        break;
+    case Integer64Property:
+        ((MP4Integer64Property*)this)->ReserveValues(count);
+        break;
+    default:
+        ASSERT(false);
+    }
+}
+
 void MP4Integer8Property::Dump(uint8_t indent,
                                bool dumpImplicits, uint32_t index)
 {
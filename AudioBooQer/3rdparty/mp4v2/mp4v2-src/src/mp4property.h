@@ -122,6 +122,8 @@ public:
 
     void IncrementValue(int32_t increment = 1, uint32_t index = 0);
 
+    void ReserveValues(uint32_t count);
+
 private:
     MP4IntegerProperty();
     MP4IntegerProperty ( const MP4IntegerProperty &src );
@@ -172,6 +174,9 @@ private:
         void IncrementValue(int32_t increment = 1, uint32_t index = 0) { \
             m_values[index] += increment; \
         } \
+        void ReserveValues(uint32_t count) { \
+            m_values.Reserve(count); \
+        } \
         void Read(MP4File& file, uint32_t index = 0) { \
             if (m_implicit) { \
                 return; \
@@ -441,13 +441,14 @@ void MP4Track::WriteSample(
         m_curMode = curMode;
     }
 
-    // append sample bytes to chunk buffer
+    // append sample bytes to chunk buffer; grow geometrically
     if( m_sizeOfDataInChunkBuffer + numBytes > m_chunkBufferSize ) {
-        m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, m_chunkBufferSize + numBytes);
+        uint32_t chunkBufferSize = max(m_chunkBufferSize + numBytes, 2 * m_chunkBufferSize);
+        m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, chunkBufferSize);
         if (m_pChunkBuffer == NULL) 
             return;	
         
-        m_chunkBufferSize += numBytes;
+        m_chunkBufferSize = chunkBufferSize;
     }
 
     memcpy(&m_pChunkBuffer[m_sizeOfDataInChunkBuffer], pBytes, numBytes);
@@ -487,6 +488,133 @@ void MP4Track::WriteSampleDependency(
     WriteSample( pBytes, numBytes, duration, renderingOffset, isSyncSample );
 }
 
+void MP4Track::WriteSamples(
+    const uint8_t*  pBytes,
+    const uint32_t* pSampleSizes,
+    uint32_t        numSamples,
+    MP4Duration     duration )
+{
+    log.verbose3f("\"%s\": WriteSamples: track %u id %u numSamples %u",
+                  GetFile().GetFilename().c_str(),
+                  m_trackId, m_writeSampleId, numSamples);
+
+    if (numSamples == 0) {
+        return;
+    }
+
+    if (pBytes == NULL || pSampleSizes == NULL) {
+        throw new Exception("no sample data", __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    if (duration == MP4_INVALID_DURATION) {
+        duration = GetFixedSampleDuration();
+    }
+
+    // the first sample determines, whether this is an AMR track;
+    // AMR tracks, rendering offsets and variable durations need
+    // per-sample bookkeeping
+    bool isBulk = duration != MP4_INVALID_DURATION && duration > 0 &&
+                  m_pCttsCountProperty == NULL;
+
+    ReserveSamples(numSamples);
+
+    // (1) complete any pending chunk sample by sample
+    while (numSamples > 0 &&
+            (!isBulk || m_isAmr != AMR_FALSE || m_chunkSamples > 0)) {
+        WriteSample(pBytes, *pSampleSizes, duration);
+        pBytes += *pSampleSizes++;
+        numSamples--;
+
+        isBulk = isBulk && m_isAmr == AMR_FALSE;
+    }
+
+    if (numSamples == 0) {
+        return;
+    }
+
+    // (2) write all complete chunks straight from the caller's buffer;
+    // consecutive chunks are contiguous in the buffer and in the file
+    uint32_t samplesPerChunk = GetChunkSampleCount(duration);
+    uint32_t numChunkedSamples = numSamples - numSamples % samplesPerChunk;
+
+    uint64_t chunkedBytes = 0;
+    for (uint32_t i = 0; i < numChunkedSamples; i++) {
+        chunkedBytes += pSampleSizes[i];
+    }
+
+    uint64_t chunkOffset = m_File.GetPosition();
+    for (uint64_t written = 0; written < chunkedBytes; ) {
+        uint32_t blockSize = (uint32_t)min(chunkedBytes - written, (uint64_t)0x40000000);
+        m_File.WriteBytes((uint8_t*)&pBytes[written], blockSize);
+        written += blockSize;
+    }
+
+    log.verbose3f("\"%s\": WriteChunks: track %u offset 0x%" PRIx64 " size %" PRIu64 " numSamples %u",
+                  GetFile().GetFilename().c_str(),
+                  m_trackId, chunkOffset, chunkedBytes, numChunkedSamples);
+
+    for (uint32_t i = 0; i < numChunkedSamples; i += samplesPerChunk) {
+        uint64_t chunkSize = 0;
+        for (uint32_t j = i; j < i + samplesPerChunk; j++) {
+            UpdateSampleSizes(m_writeSampleId, pSampleSizes[j]);
+            UpdateSyncSamples(m_writeSampleId, true);
+            chunkSize += pSampleSizes[j];
+            m_writeSampleId++;
+        }
+
+        UpdateSampleToChunk(m_writeSampleId - 1,
+                            m_pChunkCountProperty->GetValue() + 1,
+                            samplesPerChunk);
+
+        UpdateChunkOffsets(chunkOffset);
+        chunkOffset += chunkSize;
+    }
+
+    // (3) keep the remaining samples as the pending chunk
+    uint32_t numPendingBytes = 0;
+    for (uint32_t i = numChunkedSamples; i < numSamples; i++) {
+        numPendingBytes += pSampleSizes[i];
+    }
+
+    if (numPendingBytes > m_chunkBufferSize) {
+        m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, numPendingBytes);
+        m_chunkBufferSize = numPendingBytes;
+    }
+
+    if (numPendingBytes > 0) {
+        memcpy(m_pChunkBuffer, &pBytes[chunkedBytes], numPendingBytes);
+    }
+    m_sizeOfDataInChunkBuffer = numPendingBytes;
+
+    for (uint32_t i = numChunkedSamples; i < numSamples; i++) {
+        UpdateSampleSizes(m_writeSampleId, pSampleSizes[i]);
+        UpdateSyncSamples(m_writeSampleId, true);
+        m_chunkSamples++;
+        m_chunkDuration += duration;
+        m_writeSampleId++;
+    }
+
+    UpdateSampleTimes(duration, numSamples);
+
+    UpdateDurations(duration * numSamples);
+
+    UpdateModificationTimes();
+}
+
+void MP4Track::ReserveSamples(uint32_t numSamples)
+{
+    // sample sizes
+    m_pStszSampleSizeProperty->ReserveValues(
+        m_pStszSampleSizeProperty->GetCount() + numSamples);
+
+    // chunk offsets
+    uint32_t samplesPerChunk = GetChunkSampleCount(GetFixedSampleDuration());
+    if (samplesPerChunk > 0) {
+        m_pChunkOffsetProperty->ReserveValues(
+            m_pChunkOffsetProperty->GetCount() + numSamples / samplesPerChunk + 1);
+    }
+}
+
 void MP4Track::WriteChunkBuffer()
 {
     if (m_sizeOfDataInChunkBuffer == 0) {
@@ -621,6 +749,20 @@ bool MP4Track::IsChunkFull(MP4SampleId sampleId)
     return m_chunkDuration >= m_durationPerChunk;
 }
 
+uint32_t MP4Track::GetChunkSampleCount(MP4Duration duration)
+{
+    if (m_samplesPerChunk) {
+        return m_samplesPerChunk;
+    }
+
+    if (duration == 0 || duration == MP4_INVALID_DURATION) {
+        return 0;
+    }
+
+    // number of samples, after which IsChunkFull() holds
+    return (uint32_t)max((m_durationPerChunk + duration - 1) / duration, (MP4Duration)1);
+}
+
 uint32_t MP4Track::GetNumberOfSamples()
 {
     return m_pStszSampleCountProperty->GetValue();
@@ -1143,7 +1285,7 @@ MP4SampleId MP4Track::GetSampleIdFromTime(
     return 0; // satisfy MS compiler
 }
 
-void MP4Track::UpdateSampleTimes(MP4Duration duration)
+void MP4Track::UpdateSampleTimes(MP4Duration duration, uint32_t numSamples)
 {
     uint32_t numStts = m_pSttsCountProperty->GetValue();
 
@@ -1151,11 +1293,11 @@ void MP4Track::UpdateSampleTimes(MP4Duration duration)
     if (numStts
             && duration == m_pSttsSampleDeltaProperty->GetValue(numStts-1)) {
         // increment last entry sampleCount
-        m_pSttsSampleCountProperty->IncrementValue(1, numStts-1);
+        m_pSttsSampleCountProperty->IncrementValue(numSamples, numStts-1);
 
     } else {
-        // add stts entry, sampleCount = 1, sampleDuration = duration
-        m_pSttsSampleCountProperty->AddValue(1);
+        // add stts entry, sampleCount = numSamples, sampleDuration = duration
+        m_pSttsSampleCountProperty->AddValue(numSamples);
         m_pSttsSampleDeltaProperty->AddValue(duration);
         m_pSttsCountProperty->IncrementValue();;
     }
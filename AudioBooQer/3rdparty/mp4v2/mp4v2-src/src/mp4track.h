@@ -97,6 +97,14 @@ public:
         bool           isSyncSample,
         uint32_t       dependencyFlags );
 
+    void WriteSamples(
+        const uint8_t*  pBytes,
+        const uint32_t* pSampleSizes,
+        uint32_t        numSamples,
+        MP4Duration     duration = 0 );
+
+    void ReserveSamples(uint32_t numSamples);
+
     virtual void FinishWrite(uint32_t options = 0);
 
     uint64_t    GetDuration();      // in track timeScale units
@@ -179,10 +187,11 @@ protected:
     void UpdateSampleSizes(MP4SampleId sampleId,
                            uint32_t numBytes);
     bool IsChunkFull(MP4SampleId sampleId);
+    uint32_t GetChunkSampleCount(MP4Duration duration);
     void UpdateSampleToChunk(MP4SampleId sampleId,
                              MP4ChunkId chunkId, uint32_t samplesPerChunk);
     void UpdateChunkOffsets(uint64_t chunkOffset);
-    void UpdateSampleTimes(MP4Duration duration);
+    void UpdateSampleTimes(MP4Duration duration, uint32_t numSamples = 1);
     void UpdateRenderingOffsets(MP4SampleId sampleId,
                                 MP4Duration renderingOffset);
     void UpdateSyncSamples(MP4SampleId sampleId,
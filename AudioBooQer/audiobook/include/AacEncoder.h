@@ -31,13 +31,32 @@
 
 #pragma once
 
+#include "BufferedFileWriter.h"
 #include "IAudioEncoder.h"
 
 class AacEncoderImpl;
 
+/*
+ * NOTE:
+ * Destroyed encoders return their FDK AAC handle to a process-wide pool;
+ * initialize() re-parameterizes and resets a pooled handle instead of
+ * opening a new one.
+ */
+
+struct AacEncoderPoolStatistics {
+  AacEncoderPoolStatistics() noexcept = default;
+
+  double numSecondsSaved() const;
+
+  uint64_t numCreated{};
+  uint64_t numReused{};
+  double   secondsCreate{};
+  double   secondsReuse{};
+};
+
 class AacEncoder : public IAudioEncoder {
 public:
-  AacEncoder();
+  AacEncoder(const std::size_t outputBufferSize = BufferedFileWriter::defaultBufferSize);
   ~AacEncoder();
 
   bool isNull() const;
@@ -46,11 +65,19 @@ public:
   bool flush();
   bool initialize(const AacFormat& format,
                   const std::filesystem::path& outputFileName);
+  bool initialize(const AacFormat& format, IAccessUnitSink *sink);
   uint64_t numPcmFrames() const;
   std::filesystem::path outputSuffix(const AacFormat&) const;
+  std::string settings() const;
+
+  static void clearPool();
+  static std::string encoderSettings();
+  static AacEncoderPoolStatistics poolStatistics();
+  static void resetPoolStatistics();
 
 private:
   bool encodeBlock(const uint8_t *data, int size, bool *eof = nullptr);
 
   std::unique_ptr<AacEncoderImpl> impl{};
+  std::size_t _outputBufferSize{};
 };
@@ -37,11 +37,34 @@
  * (cf. INT_PCM, libSYS/include/machine_type.h)
  */
 
+/*
+ * NOTE:
+ * - The profile's value is the MPEG-4 Audio Object Type, cf. Mpeg4Audio.h.
+ * - HE-AAC (SBR) encodes its AAC core at half the sampling rate; one access
+ *   unit then spans 2048 PCM frames.
+ * - HE-AACv2 (SBR+PS) requires Stereo input.
+ * - 'bitRateMode' is FDK AAC's AACENC_BITRATEMODE: 0 is CBR at 'bitRate';
+ *   1 (lowest) to 5 (highest) select a VBR quality and ignore 'bitRate'.
+ * - isValidPcm() accepts any sampling rate, e.g. of an input to resample;
+ *   isValid() additionally requires an encodable format.
+ */
+
+enum class AacProfile : unsigned int {
+  AAC_LC = 2,
+  HE_AAC = 5,
+  HE_AACv2 = 29
+};
+
 struct AacFormat {
+  static constexpr unsigned int defaultBitRate = 64000;
+  static constexpr unsigned int maxBitRateMode = 5;
+
   AacFormat() noexcept = default;
 
+  bool isSamePcmFormat(const AacFormat& other) const;
   bool isSupportedRate(const unsigned int rate) const;
   bool isValid() const;
+  bool isValidPcm() const;
 
   unsigned int numBytesPerChannel() const;
   unsigned int numBytesPerPcmFrame() const;
@@ -50,6 +73,10 @@ struct AacFormat {
   unsigned int numChannels{};
   unsigned int numSamplesPerSecond{};
 
+  unsigned int bitRate{defaultBitRate};
+  unsigned int bitRateMode{};
+  AacProfile   profile{AacProfile::AAC_LC};
+
   static constexpr unsigned int supportedRates[] = {
     8000,
     11025,
@@ -64,4 +91,7 @@ struct AacFormat {
   {
     return sizeof(supportedRates)/sizeof(unsigned int);
   }
+
+  static constexpr unsigned int minSbrRate = 16000;
+  static constexpr unsigned int maxSbrRate = 48000;
 };
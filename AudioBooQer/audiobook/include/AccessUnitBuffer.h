@@ -0,0 +1,72 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <vector>
+
+#include "IAccessUnitSink.h"
+
+/*
+ * NOTE:
+ * AccessUnitBuffer keeps encoded access units contiguously in memory, e.g. a
+ * batch of Mp4Muxer or a segment of ParallelAacEncoder; writeTo() passes
+ * them on to a sink in one writeAccessUnits() call.
+ */
+
+class AccessUnitBuffer : public IAccessUnitSink {
+public:
+  AccessUnitBuffer() noexcept = default;
+  ~AccessUnitBuffer() noexcept = default;
+
+  AccessUnitBuffer(AccessUnitBuffer&&) noexcept = default;
+  AccessUnitBuffer& operator=(AccessUnitBuffer&&) noexcept = default;
+
+  const std::vector<uint8_t>& audioSpecificConfig() const;
+  void clear();
+  bool isEmpty() const;
+  std::size_t numAccessUnits() const;
+  bool writeTo(IAccessUnitSink *sink, const std::size_t first = 0,
+               const std::size_t count = SIZE_MAX) const;
+
+  bool setAudioSpecificConfig(const uint8_t *asc, const std::size_t size);
+  bool writeAccessUnit(const uint8_t *data, const std::size_t size);
+
+private:
+  AccessUnitBuffer(const AccessUnitBuffer&) noexcept = delete;
+  AccessUnitBuffer& operator=(const AccessUnitBuffer&) noexcept = delete;
+
+  std::vector<uint8_t>  _asc;
+  std::vector<uint8_t>  _payload;
+  std::vector<uint32_t> _sizes;
+};
@@ -0,0 +1,68 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <filesystem>
+
+#include "BufferedFileWriter.h"
+#include "IAccessUnitSink.h"
+
+/*
+ * NOTE:
+ * AdtsFileSink writes raw access units as an ADTS stream; every access unit
+ * is prefixed by an ADTS header derived from the AudioSpecificConfig.
+ */
+
+class AdtsFileSink : public IAccessUnitSink {
+public:
+  AdtsFileSink(const std::size_t bufferSize = BufferedFileWriter::defaultBufferSize) noexcept;
+  ~AdtsFileSink() noexcept;
+
+  bool close();
+  bool flush();
+  bool isOpen() const;
+  bool open(const std::filesystem::path& filename);
+  bool setBufferSize(const std::size_t size);
+
+  bool setAudioSpecificConfig(const uint8_t *asc, const std::size_t size);
+  bool writeAccessUnit(const uint8_t *data, const std::size_t size);
+
+private:
+  AdtsFileSink(const AdtsFileSink&) noexcept = delete;
+  AdtsFileSink& operator=(const AdtsFileSink&) noexcept = delete;
+
+  AdtsFileSink(AdtsFileSink&&) noexcept = delete;
+  AdtsFileSink& operator=(AdtsFileSink&&) noexcept = delete;
+
+  uint16_t           _asc{};
+  BufferedFileWriter _file;
+};
@@ -0,0 +1,111 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace cs {
+  class OutputContext;
+}
+
+/*
+ * NOTE:
+ * - AdtsIndex summarizes an ADTS file: the AudioSpecificConfig of its AAC
+ *   core (cf. AdtsParser::mpeg4AudioSpecificConfig()), the offset and length
+ *   of each frame, and the ranges of bytes skipped by AdtsParser::resync().
+ * - build() scans the ADTS file once; only files with a constant ASC and
+ *   one AAC frame per ADTS frame are indexed.
+ * - The index is persisted to a sidecar "<file>.idx" next to the ADTS file;
+ *   it is guarded by the ADTS file's size and time of last modification,
+ *   and protected by a XXH64 checksum. load() fails on a stale or damaged
+ *   sidecar, i.e. the ADTS file needs to be scanned again.
+ * - The frame table locates the access units without scanning the ADTS file
+ *   again (cf. accessUnit(), outputAdtsBinder(), EncodeCache); load() may
+ *   skip it, e.g. when only counting frames.
+ * - numPcmFrames() is the number of PCM frames encoded, if known (e.g. for
+ *   an EncodeCache entry); otherwise, it is 0.
+ * - The sidecar is replaced atomically, cf. fileutil::writeFile().
+ */
+
+class AdtsIndex {
+public:
+  struct Frame {
+    Frame() noexcept = default;
+
+    uint64_t offset{}; // of the ADTS header
+    uint16_t length{}; // including the ADTS header
+  };
+
+  using Range = std::pair<uint64_t,uint64_t>; // offset, size
+
+  AdtsIndex() noexcept = default;
+  ~AdtsIndex() noexcept = default;
+
+  uint16_t audioSpecificConfig() const;
+  void clear();
+  const std::vector<Frame>& frames() const;
+  bool isEmpty() const;
+  uint64_t numFrames() const;
+  uint64_t numPcmFrames() const;
+  void setNumPcmFrames(const uint64_t numPcmFrames);
+  const std::vector<Range>& skippedRanges() const;
+
+  bool build(const std::filesystem::path& adtsFileName, const cs::OutputContext& ctx);
+  bool load(const std::filesystem::path& adtsFileName, const bool withFrames = true);
+  bool save(const std::filesystem::path& adtsFileName) const;
+
+  static std::span<const uint8_t> accessUnit(const std::span<const uint8_t>& adts,
+                                             const Frame& frame);
+  static std::filesystem::path sidecarName(const std::filesystem::path& adtsFileName);
+
+private:
+  AdtsIndex(const AdtsIndex&) noexcept = delete;
+  AdtsIndex& operator=(const AdtsIndex&) noexcept = delete;
+
+  AdtsIndex(AdtsIndex&&) noexcept = delete;
+  AdtsIndex& operator=(AdtsIndex&&) noexcept = delete;
+
+  static bool guard(const std::filesystem::path& adtsFileName, uint64_t *size, int64_t *time);
+
+  uint16_t           _asc{};
+  uint64_t           _fileSize{};
+  int64_t            _fileTime{};
+  std::vector<Frame> _frames{};
+  uint64_t           _numFrames{};
+  uint64_t           _numPcmFrames{};
+  std::vector<Range> _skipped{};
+};
@@ -31,13 +31,35 @@
 
 #pragma once
 
+#include <span>
+
 #include <cs/Core/Buffer.h>
 
+/*
+ * NOTE:
+ * - Constructed from a pointer or span, the parser does not own the data;
+ *   e.g. of a MappedFile, frameData() then points into the mapping.
+ * - A header requires the sync word (0xFFF), layer 0, a valid sampling
+ *   frequency index and a length exceeding the header's size; otherwise,
+ *   hasFrame() is false and resync() skips it.
+ * - resync() skips data up to the next valid frame, if there is no frame at
+ *   the current offset (e.g. corrupted data). A candidate's header needs to
+ *   be followed by the same fixed header at the offset given by its length,
+ *   unless the candidate ends at or near the end of data. If more data is
+ *   to follow (i.e. !isEndOfData), a truncated candidate is kept, otherwise
+ *   it is skipped; cf. AdtsReader.
+ * - Sync words are searched for 16 (SSE2) or 32 (AVX2) bytes at a time; AVX2
+ *   requires GCC or Clang and is selected at runtime, unless
+ *   ADTSPARSER_NO_AVX2 is defined (cf. test_resync_sse2).
+ */
+
 class AdtsParser {
 public:
   using size_type = cs::Buffer::size_type;
 
   AdtsParser(cs::Buffer&& buffer);
+  AdtsParser(const uint8_t *data, const size_type size);
+  AdtsParser(const std::span<const uint8_t>& data);
   ~AdtsParser() noexcept = default;
 
   size_type aacFrameCount() const;
@@ -48,7 +70,9 @@ public:
   bool isMpeg4Frame() const;
   uint16_t mpeg4AudioSpecificConfig() const;
   bool nextFrame();
+  size_type offset() const;
   bool reset();
+  bool resync(size_type *numSkipped = nullptr, const bool isEndOfData = true);
 
 private:
   AdtsParser() noexcept = delete;
@@ -62,25 +86,32 @@ private:
   enum HeaderBits : uint64_t {
     Sync            = 0xFFF0000000000000,
     Mpeg2           = 0x0008000000000000,
+    Layer           = 0x0006000000000000,
     NoProtection    = 0x0001000000000000,
     Mpeg4AudioType  = 0x0000C00000000000,
     Mpeg4Frequency  = 0x00003C0000000000,
     Mpeg4Channels   = 0x000001C000000000,
     AdtsLength      = 0x00000003FFE00000,
-    NumberAacFrames = 0x0000000000000300
+    NumberAacFrames = 0x0000000000000300,
+    FixedHeader     = 0xFFFFFDC000000000 // w/o private bit
   };
 
   size_type adtsLength() const;
+  uint64_t headerAt(const size_type offset) const;
   size_type headerSize() const;
+  bool isCandidate(const size_type offset, const bool isEndOfData) const;
   bool isHeader() const;
   bool isNoProtection() const;
+  static bool isValidHeader(const uint64_t header);
   uint16_t mpeg4AudioType() const;
   uint16_t mpeg4Channels() const;
   uint16_t mpeg4Frequency() const;
   size_type numberFrames() const;
   bool readHeader();
 
-  cs::Buffer _buffer;
-  uint64_t   _header{};
-  size_type  _offset{};
+  cs::Buffer     _buffer;
+  const uint8_t *_data{nullptr};
+  uint64_t       _header{};
+  size_type      _offset{};
+  size_type      _size{};
 };
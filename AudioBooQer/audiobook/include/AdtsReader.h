@@ -0,0 +1,87 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include <cs/IO/File.h>
+
+#include "AdtsParser.h"
+
+/*
+ * NOTE:
+ * AdtsReader streams an ADTS file through a window of bounded size;
+ * each byte of the file is read exactly once.
+ * resync() continues across windows, cf. AdtsParser::resync(); offset()
+ * is relative to the start of the file.
+ */
+
+class AdtsReader {
+public:
+  using size_type = AdtsParser::size_type;
+
+  AdtsReader(const size_type windowSize = 256*1024);
+  ~AdtsReader() noexcept = default;
+
+  void close();
+  bool isOpen() const;
+  bool open(const std::filesystem::path& filename);
+
+  size_type aacFrameCount() const;
+  const uint8_t *frameData() const;
+  size_type frameSize() const;
+  bool hasFrame() const;
+  bool isEndOfFile() const;
+  uint16_t mpeg4AudioSpecificConfig() const;
+  bool nextFrame();
+  size_type offset() const;
+  bool resync(size_type *numSkipped = nullptr);
+
+  static constexpr size_type maxAdtsLength = 0x1FFF; // 13bits
+
+private:
+  AdtsReader(const AdtsReader&) noexcept = delete;
+  AdtsReader& operator=(const AdtsReader&) noexcept = delete;
+
+  AdtsReader(AdtsReader&&) noexcept = delete;
+  AdtsReader& operator=(AdtsReader&&) noexcept = delete;
+
+  bool fill(const size_type offset);
+
+  size_type                 _base{};
+  bool                      _eof{false};
+  cs::File                  _file;
+  std::optional<AdtsParser> _parser;
+  size_type                 _size{};
+  cs::Buffer                _window;
+};
@@ -0,0 +1,104 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <future>
+#include <memory>
+
+#include <cs/IO/File.h>
+
+/*
+ * NOTE:
+ * - BufferedFileWriter coalesces many small writes (e.g. AAC access units)
+ *   into few large, sequential writes of up to bufferSize() bytes. The number
+ *   of writes and bytes actually passed to the file is counted per instance
+ *   and process-wide.
+ * - Full buffers are written on the IoThread while a second buffer is being
+ *   filled; write() only blocks, if both buffers are in use.
+ * - flush() and close() wait until all data is written.
+ * - The buffers are allocated by open() and released by close(); thus, an
+ *   idle writer (e.g. of a pooled AacEncoder) holds no buffers.
+ */
+
+class BufferedFileWriter {
+public:
+  static constexpr std::size_t alignment = 4096;
+  static constexpr std::size_t defaultBufferSize = 1024*1024;
+
+  BufferedFileWriter(const std::size_t bufferSize = defaultBufferSize) noexcept;
+  ~BufferedFileWriter() noexcept;
+
+  std::size_t bufferSize() const;
+  bool close();
+  bool flush();
+  bool isOpen() const;
+  uint64_t numBytes() const;
+  uint64_t numWrites() const;
+  bool open(const std::filesystem::path& filename);
+  bool setBufferSize(const std::size_t size);
+  bool write(const void *data, const std::size_t size);
+
+  static void resetTotals();
+  static uint64_t totalNumBytes();
+  static uint64_t totalNumWrites();
+
+private:
+  BufferedFileWriter(const BufferedFileWriter&) noexcept = delete;
+  BufferedFileWriter& operator=(const BufferedFileWriter&) noexcept = delete;
+
+  BufferedFileWriter(BufferedFileWriter&&) noexcept = delete;
+  BufferedFileWriter& operator=(BufferedFileWriter&&) noexcept = delete;
+
+  struct AlignedDelete {
+    void operator()(uint8_t *p) const;
+  };
+
+  using BufferPtr = std::unique_ptr<uint8_t[],AlignedDelete>;
+
+  bool allocate(BufferPtr& buffer) const;
+  void count(const std::size_t size);
+  bool submit();
+  bool wait();
+
+  BufferPtr         _buffer{};
+  std::size_t       _bufferSize{};
+  cs::File          _file{};
+  std::size_t       _fill{};
+  BufferPtr         _inFlight{};
+  uint64_t          _numBytes{};
+  uint64_t          _numWrites{};
+  std::future<bool> _pending{};
+};
@@ -0,0 +1,108 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AacFormat.h"
+
+class AdtsIndex;
+class IAccessUnitSink;
+
+/*
+ * NOTE:
+ * - EncodeCache stores encoded chapters as ADTS files, which are addressed by
+ *   a key computed from the content of the input files, the PCM format and
+ *   the encoder's settings (cf. IAudioEncoder::settings()).
+ * - An entry consists of "<key>.aac" and its AdtsIndex sidecar, which also
+ *   records the number of encoded PCM frames; the sidecar is written last
+ *   and completes the entry. Only ADTS files indexed without skipping any
+ *   data are stored.
+ * - Entries are restored to a file by a hard link, or a copy if linking
+ *   fails; thus, never modify a restored file in place! The sidecar is
+ *   linked alongside a stored or restored file, i.e. binding the file does
+ *   not scan it (cf. isAdtsBinderIndexed()).
+ * - Restoring access units requires the entry's AacProfile, as ADTS does
+ *   not signal SBR/PS explicitly; the access units are located by the
+ *   sidecar's frame table and all of them are checked, before any is
+ *   passed to the sink.
+ * - The ADTS files are limited to maxSize() bytes; store() evicts the least
+ *   recently used entries beyond it. A successful lookup() marks an entry
+ *   as used by touching its sidecar.
+ * - All methods may be called concurrently.
+ */
+
+class EncodeCache {
+public:
+  using Key = uint64_t;
+
+  static constexpr uint64_t defaultMaxSize = uint64_t(2) << 30;
+
+  EncodeCache() noexcept = default;
+  ~EncodeCache() noexcept = default;
+
+  std::filesystem::path directory() const;
+  bool isOpen() const;
+  uint64_t maxSize() const;
+  bool open(const std::filesystem::path& directory,
+            const uint64_t maxSize = defaultMaxSize);
+
+  bool lookup(const Key key, uint64_t *numPcmFrames) const;
+  bool restore(const Key key, const std::filesystem::path& outputFileName) const;
+  bool restore(const Key key, IAccessUnitSink *sink,
+               const AacProfile profile = AacProfile::AAC_LC) const;
+  bool store(const Key key, const std::filesystem::path& encodedFileName,
+             const uint64_t numPcmFrames) const;
+
+  static bool computeKey(Key *key, const std::vector<std::filesystem::path>& inputFileNames,
+                         const AacFormat& format, const std::string& settings);
+
+private:
+  EncodeCache(const EncodeCache&) noexcept = delete;
+  EncodeCache& operator=(const EncodeCache&) noexcept = delete;
+
+  EncodeCache(EncodeCache&&) noexcept = delete;
+  EncodeCache& operator=(EncodeCache&&) noexcept = delete;
+
+  std::filesystem::path entryName(const Key key) const;
+  void evict() const;
+  bool load(const Key key, AdtsIndex *index, const bool withFrames) const;
+
+  std::filesystem::path _directory;
+  mutable std::mutex    _evictMutex;
+  uint64_t              _maxSize{defaultMaxSize};
+};
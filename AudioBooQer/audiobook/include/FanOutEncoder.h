@@ -0,0 +1,73 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include "IAudioEncoder.h"
+
+class FanOutEncoderImpl;
+
+/*
+ * NOTE:
+ * - One PCM stream is passed to several encoders (i.e. variants); thus,
+ *   decoding is performed only once for all variants.
+ * - A variant may differ in its number of channels (Mono/Stereo); PCM is
+ *   then up- or downmixed; this requires 16bit PCM.
+ * - A variant's AacFormat provides its number of channels, profile and
+ *   bitrate; sample size and rate are those passed to initialize().
+ * - Each variant's output is written to a sub-directory named after the
+ *   variant, cf. variantFileName().
+ * - settings() is empty; the outputs cannot be cached as one file.
+ */
+
+class FanOutEncoder : public IAudioEncoder {
+public:
+  FanOutEncoder();
+  ~FanOutEncoder();
+
+  bool addVariant(AudioEncoderPtr encoder, const AacFormat& format,
+                  const std::filesystem::path& name);
+  std::size_t numVariants() const;
+  std::filesystem::path outputFileName(const std::size_t index) const;
+
+  bool encode(const void *data, const std::size_t size);
+  bool flush();
+  bool initialize(const AacFormat& format,
+                  const std::filesystem::path& outputFileName);
+  uint64_t numPcmFrames() const;
+  std::filesystem::path outputSuffix(const AacFormat& format) const;
+
+  static std::filesystem::path variantFileName(const std::filesystem::path& outputFileName,
+                                               const std::filesystem::path& name);
+
+private:
+  std::unique_ptr<FanOutEncoderImpl> impl{};
+};
@@ -0,0 +1,62 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+#include <filesystem>
+
+/*
+ * NOTE:
+ * - Files are replaced atomically: the data is written to tempFileName(),
+ *   i.e. "<file>.<pid>.<n>.tmp" with a per-process unique <n>, which is
+ *   renamed onto the file by replaceFile(); a failed replacement removes the
+ *   temporary file. Thus, concurrent writers (also of different processes)
+ *   never observe partial files.
+ * - writeFile() flushes the data to the storage device before renaming;
+ *   thus, a crash leaves either the old or the new file.
+ * - linkFile() creates a hard link, or a copy if linking fails (e.g. across
+ *   file systems); an existing target is removed beforehand.
+ * - Errors are reported by the return value only; removeFile() ignores them.
+ */
+
+namespace fileutil {
+
+  bool linkFile(const std::filesystem::path& from, const std::filesystem::path& to);
+  void removeFile(const std::filesystem::path& filename);
+  bool replaceFile(const std::filesystem::path& tempFileName,
+                   const std::filesystem::path& filename);
+  std::filesystem::path tempFileName(const std::filesystem::path& filename);
+  bool writeFile(const std::filesystem::path& filename,
+                 const void *data, const std::size_t size);
+
+} // namespace fileutil
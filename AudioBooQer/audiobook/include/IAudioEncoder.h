@@ -33,9 +33,18 @@
 
 #include <filesystem>
 #include <memory>
+#include <string>
 
 #include "AacFormat.h"
 
+class IAccessUnitSink;
+
+/*
+ * NOTE:
+ * settings() identifies the encoder and all of its parameters, which affect
+ * the encoded stream (cf. EncodeCache); an empty string disables caching.
+ */
+
 class IAudioEncoder {
 public:
   virtual ~IAudioEncoder();
@@ -44,8 +53,10 @@ public:
   virtual bool flush();
   virtual bool initialize(const AacFormat& format,
                           const std::filesystem::path& outputFileName) = 0;
+  virtual bool initialize(const AacFormat& format, IAccessUnitSink *sink);
   virtual uint64_t numPcmFrames() const = 0;
   virtual std::filesystem::path outputSuffix(const AacFormat& format) const = 0;
+  virtual std::string settings() const;
 
 protected:
   bool isValidData(const void *data, const std::size_t size) const;
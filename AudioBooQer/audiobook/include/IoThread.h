@@ -0,0 +1,83 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * NOTE:
+ * - IoThread executes (blocking) I/O tasks on a small, process-wide pool of
+ *   dedicated threads; thus CPU-bound threads never stall on slow storage.
+ * - Tasks are started in submission order, but several tasks (e.g. of
+ *   parallel jobs) are in flight at once, keeping slow or network storage
+ *   busy. Thus, tasks of the same file must not overlap: each caller waits
+ *   on its returned future before submitting its next task, which also
+ *   bounds its number of tasks in flight (cf. BufferedFileWriter, Mp4Muxer).
+ */
+
+class IoThread {
+public:
+  ~IoThread() noexcept;
+
+  template<typename FuncT>
+  std::future<bool> submit(FuncT&& func)
+  {
+    return enqueue(std::packaged_task<bool()>(std::forward<FuncT>(func)));
+  }
+
+  static IoThread& instance();
+
+  static constexpr unsigned int maxThreads = 4;
+
+private:
+  IoThread() noexcept;
+
+  IoThread(const IoThread&) noexcept = delete;
+  IoThread& operator=(const IoThread&) noexcept = delete;
+
+  IoThread(IoThread&&) noexcept = delete;
+  IoThread& operator=(IoThread&&) noexcept = delete;
+
+  std::future<bool> enqueue(std::packaged_task<bool()>&& task);
+  void run();
+
+  std::condition_variable                 _cond;
+  std::mutex                              _mutex;
+  bool                                    _quit{false};
+  std::deque<std::packaged_task<bool()>>  _tasks;
+  std::vector<std::thread>                _threads;
+};
@@ -0,0 +1,77 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <span>
+
+/*
+ * NOTE:
+ * - MappedFile maps a whole file read-only into memory; the mapping is
+ *   advised for sequential access.
+ * - prefetch() asks the operating system to read the file into its cache
+ *   without blocking; prefetchAsync() additionally opens the file on the
+ *   IoThread, hiding the latency of e.g. network storage.
+ */
+
+class MappedFile {
+public:
+  using size_type = std::size_t;
+
+  MappedFile() noexcept = default;
+  ~MappedFile() noexcept;
+
+  void close();
+  bool isOpen() const;
+  bool open(const std::filesystem::path& filename);
+
+  const uint8_t *data() const;
+  bool prefetch() const;
+  size_type size() const;
+  std::span<const uint8_t> span() const;
+
+  static void prefetchAsync(const std::filesystem::path& filename);
+
+private:
+  MappedFile(const MappedFile&) noexcept = delete;
+  MappedFile& operator=(const MappedFile&) noexcept = delete;
+
+  MappedFile(MappedFile&&) noexcept = delete;
+  MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+  const uint8_t *_data{nullptr};
+  void          *_handle{nullptr};
+  size_type      _size{};
+};
@@ -0,0 +1,107 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Mp4Muxer.h"
+
+class IAccessUnitSink;
+class Mp4ChapterSink;
+
+/*
+ * NOTE:
+ * Mp4ChapterWriter binds chapters, which are encoded concurrently, to a single
+ * M4B file. Each chapter writes its access units to its own sink() from any
+ * thread and is completed by commit(); chapters are written to the file
+ * strictly in ascending order of their position:
+ * - The access units of the first incomplete chapter are passed through to
+ *   the muxer as they arrive.
+ * - The access units of all later chapters are spilled to temporary ADTS
+ *   files next to the output file; a spilled chapter is copied to the muxer
+ *   and its file removed, once all preceding chapters are complete.
+ * Thus, memory usage does not depend on the length of the chapters.
+ */
+
+class Mp4ChapterWriter {
+public:
+  static constexpr std::size_t spillBufferSize = 256*1024;
+
+  Mp4ChapterWriter(const cs::OutputContext& ctx);
+  ~Mp4ChapterWriter();
+
+  bool close(const std::u8string& language);
+  bool commit(const int position, const std::u8string& title, const bool isEncoded);
+  std::filesystem::path filename() const;
+  bool open(const std::filesystem::path& filename, const uint32_t timeScale,
+            const int firstPosition, const int numChapters);
+  IAccessUnitSink *sink(const int position) const;
+
+private:
+  friend class Mp4ChapterSink;
+
+  Mp4ChapterWriter() noexcept = delete;
+
+  Mp4ChapterWriter(const Mp4ChapterWriter&) noexcept = delete;
+  Mp4ChapterWriter& operator=(const Mp4ChapterWriter&) noexcept = delete;
+
+  Mp4ChapterWriter(Mp4ChapterWriter&&) noexcept = delete;
+  Mp4ChapterWriter& operator=(Mp4ChapterWriter&&) noexcept = delete;
+
+  using ChapterPtr = std::unique_ptr<Mp4ChapterSink>;
+
+  bool advance();
+  Mp4ChapterSink *chapter(const int position) const;
+  void discard();
+  bool promote(Mp4ChapterSink *chapter);
+  bool setAudioSpecificConfig(Mp4ChapterSink *chapter, const uint8_t *asc, const std::size_t size);
+  bool writeAccessUnit(Mp4ChapterSink *chapter, const uint8_t *data, const std::size_t size);
+  bool writeConfig(const Mp4ChapterSink *chapter);
+
+  std::vector<uint8_t>     _asc;
+  std::vector<ChapterPtr>  _chapters;
+  const cs::OutputContext& _ctx;
+  int                      _endPosition{};
+  bool                     _error{false};
+  std::filesystem::path    _filename;
+  int                      _firstPosition{};
+  Mp4Muxer                 _muxer;
+  mutable std::mutex       _mutex;
+  int                      _nextPosition{};
+};
@@ -0,0 +1,81 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cs {
+  class OutputContext;
+}
+
+class Mp4MuxerImpl;
+
+/*
+ * NOTE:
+ * Mp4Muxer writes AAC access units to the audio track of an M4B file.
+ * Each access unit represents one sample, whose duration is derived from the
+ * AudioSpecificConfig (e.g. 2048 PCM frames with SBR); the duration of a
+ * chapter is derived from the samples actually written.
+ * Samples are written asynchronously on the IoThread; errors are reported by
+ * subsequent calls and by close().
+ */
+
+class Mp4Muxer {
+public:
+  Mp4Muxer();
+  ~Mp4Muxer();
+
+  bool isOpen() const;
+
+  bool close(const std::u8string& language, const cs::OutputContext& ctx);
+  bool open(const std::filesystem::path& filename, const uint32_t timeScale,
+            const cs::OutputContext& ctx);
+
+  bool addChapter(const std::u8string& title);
+  const std::vector<uint64_t>& chapterDurations() const;
+  bool setAudioSpecificConfig(const uint8_t *asc, const std::size_t size,
+                              const cs::OutputContext& ctx);
+  uint32_t timeScale() const;
+  bool writeSample(const uint8_t *data, const std::size_t size);
+
+private:
+  Mp4Muxer(const Mp4Muxer&) noexcept = delete;
+  Mp4Muxer& operator=(const Mp4Muxer&) noexcept = delete;
+
+  Mp4Muxer(Mp4Muxer&&) noexcept = delete;
+  Mp4Muxer& operator=(Mp4Muxer&&) noexcept = delete;
+
+  std::unique_ptr<Mp4MuxerImpl> impl{};
+};
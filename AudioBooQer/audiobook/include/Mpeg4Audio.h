@@ -31,6 +31,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include <array>
@@ -49,7 +50,9 @@ namespace mpeg4 {
     AAC_Main,
     AAC_LC,   // Low Complexity
     AAC_SSR,  // Scalable Sample Rate
-    AAC_LTP   // Long Term Prediction
+    AAC_LTP,  // Long Term Prediction
+    SBR,      // Spectral Band Replication (HE-AAC)
+    PS = 29   // Parametric Stereo (HE-AACv2)
   };
 
   // ChannelConfiguration: 4bits
@@ -102,11 +105,58 @@ namespace mpeg4 {
     Index_Escape // cf. AudioSpecificConfig
   };
 
+  inline constexpr std::size_t numAdtsHeaderBytes = 7;
+
+  /*
+   * NOTE:
+   * A parsed AudioSpecificConfig of arbitrary length, i.e. as stored in an
+   * MP4 file. SBR/PS are either signaled explicitly (hierarchical or
+   * backward compatible) or implicitly; in the latter case only the AAC core
+   * is known here (e.g. for ADTS).
+   */
+  struct AudioSpecificConfig {
+    AudioSpecificConfig() noexcept = default;
+
+    bool isSbr() const;
+    uint32_t numSamplesPerFrame() const;
+    uint32_t outputSamplingFrequency() const;
+
+    uint16_t audioObjectType{};            // AAC core
+    uint16_t channelConfiguration{};
+    uint16_t extensionObjectType{};        // SBR, PS or Null
+    uint32_t extensionSamplingFrequency{}; // SBR output
+    uint32_t numCoreSamplesPerFrame{numSamplesPerAacFrame};
+    uint32_t samplingFrequency{};          // AAC core
+  };
+
+  bool parseAudioSpecificConfig(AudioSpecificConfig *config,
+                                const uint8_t *data, const std::size_t size);
+
   uint16_t createAudioSpecificConfig(const uint16_t aot, const uint16_t channels, const uint32_t freq);
 
+  inline constexpr std::size_t numExplicitSbrConfigBytes = 4;
+
+  /*
+   * NOTE:
+   * Creates an AudioSpecificConfig with explicit hierarchical signaling of
+   * SBR/PS at twice the core's sampling frequency from the 2 byte core
+   * 'asc'; returns an all-zero config on invalid input.
+   */
+  std::array<uint8_t,numExplicitSbrConfigBytes> createExplicitSbrConfig(const uint16_t asc,
+                                                                      const uint16_t extensionAot);
+
+  /*
+   * NOTE:
+   * Creates a MPEG-4 ADTS header without CRC for one raw access unit of
+   * 'frameSize' bytes; returns an all-zero header on invalid input.
+   */
+  std::array<uint8_t,numAdtsHeaderBytes> createAdtsHeader(const uint16_t asc, const std::size_t frameSize);
+
   uint16_t audioObjectTypeFromASC(const uint16_t asc);
   uint16_t channelConfigurationFromASC(const uint16_t asc);
   uint16_t samplingFrequencyIndexFromASC(const uint16_t asc);
   uint32_t samplingFrequencyFromASC(const uint16_t asc);
 
+  uint16_t coreAscFromConfig(const AudioSpecificConfig& config);
+
 } // namespace mpeg4
@@ -31,12 +31,35 @@
 
 #pragma once
 
+#include "AacFormat.h"
 #include "BookBinder.h"
 
 namespace cs {
   class OutputContext;
 }
 
+/*
+ * NOTE:
+ * - 'profile' is the AacProfile the ADTS files were encoded with; ADTS signals
+ *   SBR/PS implicitly, thus it cannot be detected from the files themselves.
+ * - outputAdtsBinder() validates the chapters concurrently by their AdtsIndex
+ *   and writes the frames located by its frame table. A chapter without an
+ *   up-to-date sidecar is scanned (and its sidecar written) beforehand.
+ * - outputAdtsBinderStreaming() reads each chapter once through a bounded
+ *   window and validates the frames while writing them.
+ * - isAdtsBinderIndexed() is true, if every chapter has an up-to-date
+ *   sidecar (e.g. an EncodeCache entry); outputAdtsBinder() then does not
+ *   scan any chapter.
+ */
+
 bool outputAdtsBinder(const std::filesystem::path& filename, const BookBinder& binder,
                       const cs::OutputContext& ctx,
-                      const std::u8string& language = std::u8string());
+                      const std::u8string& language = std::u8string(),
+                      const AacProfile profile = AacProfile::AAC_LC);
+
+bool outputAdtsBinderStreaming(const std::filesystem::path& filename, const BookBinder& binder,
+                               const cs::OutputContext& ctx,
+                               const std::u8string& language = std::u8string(),
+                               const AacProfile profile = AacProfile::AAC_LC);
+
+bool isAdtsBinderIndexed(const BookBinder& binder);
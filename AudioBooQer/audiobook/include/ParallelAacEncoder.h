@@ -0,0 +1,78 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include "BufferedFileWriter.h"
+#include "IAudioEncoder.h"
+
+class ParallelAacEncoderImpl;
+
+/*
+ * NOTE:
+ * - PCM is split into segments of 'numSegmentFrames' AAC frames; each segment
+ *   is encoded by its own AacEncoder on a process-wide TaskScheduler.
+ * - Every segment is encoded with 'numOverlapFrames' AAC frames of its
+ *   neighbours prepended and appended, hiding encoder priming and MDCT
+ *   overlap; the access units of the overlap are dropped when stitching.
+ * - The number of concurrently running segment encoders is limited
+ *   process-wide by maxThreadCount(); encode() and flush() block until a
+ *   segment may be dispatched.
+ */
+
+class ParallelAacEncoder : public IAudioEncoder {
+public:
+  ParallelAacEncoder(const std::size_t numSegmentFrames = 2048,
+                     const std::size_t numOverlapFrames = 4,
+                     const std::size_t outputBufferSize = BufferedFileWriter::defaultBufferSize);
+  ~ParallelAacEncoder();
+
+  bool encode(const void *data, const std::size_t size);
+  bool flush();
+  bool initialize(const AacFormat& format,
+                  const std::filesystem::path& outputFileName);
+  bool initialize(const AacFormat& format, IAccessUnitSink *sink);
+  uint64_t numPcmFrames() const;
+  std::filesystem::path outputSuffix(const AacFormat&) const;
+  std::string settings() const;
+
+  static std::size_t maxThreadCount();
+  static void setMaxThreadCount(const std::size_t count);
+
+private:
+  bool dispatch(const bool is_last);
+  bool stitch();
+
+  std::unique_ptr<ParallelAacEncoderImpl> impl{};
+  std::size_t _numOverlapFrames{};
+  std::size_t _numSegmentFrames{};
+  std::size_t _outputBufferSize{};
+};
@@ -0,0 +1,100 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * NOTE:
+ * - Operations on interleaved 16bit PCM; SSE2 is used where available, the
+ *   results are identical to the scalar code.
+ * - StereoStatistics accumulates the energies of the left and right channel
+ *   and their cross product; these yield the energies of the mid (L+R) and
+ *   side (L-R) signals. Samples are halved before squaring, which keeps the
+ *   SIMD lanes from overflowing.
+ * - sideLevel() is the level of the side relative to the mid signal [dB];
+ *   it is -inf for identical channels (i.e. dual-mono).
+ */
+
+/*
+ * NOTE:
+ * - convertToInt16() requantizes samples of any SampleFormat to signed
+ *   16bit, rounding to nearest and saturating; 'swapBytes' reads the
+ *   opposite of the native byte order. Floating point samples are full
+ *   scale at +/-1.0. 'dest' may equal 'src', i.e. convert in place.
+ * - Dither adds triangular (TPDF) noise of +/-1 LSB before rounding; its
+ *   four xorshift generators are interleaved across samples, and 'lane'
+ *   continues the interleaving with the next block. Thus, dithered output
+ *   is deterministic for a given seed, regardless of the block sizes.
+ * - Int16 is only byte swapped, if requested; it is never dithered.
+ */
+
+namespace pcm {
+
+  enum class SampleFormat : unsigned int {
+    Int16 = 0,
+    Int24,
+    Int32,
+    Float32
+  };
+
+  struct Dither {
+    Dither(const uint32_t seed = 1) noexcept;
+
+    uint32_t lane{}; // of the next sample
+    uint32_t state[4];
+  };
+
+  struct StereoStatistics {
+    StereoStatistics() noexcept = default;
+
+    void accumulate(const int16_t *pcm, const std::size_t numFrames);
+    bool isDualMono(const int threshold) const;
+    double sideLevel() const;
+
+    int64_t  sumCross{};
+    uint64_t sumLeft{};
+    uint64_t sumRight{};
+    uint64_t numFrames{};
+  };
+
+  void convertToInt16(void *dest, const void *src, const std::size_t numSamples,
+                      const SampleFormat format, const bool swapBytes = false,
+                      Dither *dither = nullptr);
+
+  // NOTE: Stereo -> Mono averages the channels.
+  void downmixStereo(int16_t *dest, const int16_t *src, const std::size_t numFrames);
+
+  std::size_t sampleSize(const SampleFormat format);
+
+} // namespace pcm
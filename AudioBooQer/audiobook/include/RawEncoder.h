@@ -45,6 +45,7 @@ public:
                   const std::filesystem::path& outputFileName);
   uint64_t numPcmFrames() const;
   std::filesystem::path outputSuffix(const AacFormat& format) const;
+  std::string settings() const;
 
 private:
   uint64_t     _bytesPerPcmFrame{0};
@@ -0,0 +1,112 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+/*
+ * NOTE:
+ * - Resampler converts interleaved 16bit PCM between arbitrary rates using
+ *   a polyphase, Kaiser windowed sinc filter; the rates' ratio is reduced
+ *   to L/M, i.e. L phases are used.
+ * - With more than 'maxNumPhases' phases, the nearest phase is used.
+ * - When downsampling, the cutoff is lowered and the number of taps is
+ *   raised accordingly (up to 'maxNumTaps').
+ * - process() consumes PCM in streaming fashion; the filter is centered,
+ *   i.e. the output is not delayed. flush() emits the remaining output and
+ *   resets the filter's state.
+ * - The filter's kernel is selected at runtime: AVX2 (with FMA), SSE2 or
+ *   scalar; the kernels' results may differ in rounding. AVX2 requires
+ *   GCC or Clang (i.e. function multiversioning by 'target' attribute).
+ */
+
+enum class ResamplerKernel : unsigned int {
+  Auto = 0,
+  Scalar,
+  SSE2,
+  AVX2
+};
+
+class Resampler {
+public:
+  static constexpr std::size_t baseNumTaps  = 32;
+  static constexpr std::size_t maxNumPhases = 4096;
+  static constexpr std::size_t maxNumTaps   = 256;
+
+  Resampler() noexcept = default;
+  ~Resampler() noexcept = default;
+
+  bool initialize(const unsigned int numChannels,
+                  const unsigned int inputRate, const unsigned int outputRate,
+                  const ResamplerKernel kernel = ResamplerKernel::Auto);
+  unsigned int inputRate() const;
+  bool isPassThrough() const;
+  ResamplerKernel kernel() const;
+  std::size_t numTaps() const;
+  unsigned int outputRate() const;
+
+  bool flush(std::vector<int16_t>& output);
+  bool process(std::vector<int16_t>& output,
+               const int16_t *input, const std::size_t numFrames);
+
+private:
+  Resampler(const Resampler&) noexcept = delete;
+  Resampler& operator=(const Resampler&) noexcept = delete;
+
+  Resampler(Resampler&&) noexcept = delete;
+  Resampler& operator=(Resampler&&) noexcept = delete;
+
+  using DotFunc = float (*)(const float *a, const float *b, const std::size_t size);
+
+  bool filter(std::vector<int16_t>& output, const uint64_t maxNumOutputFrames);
+  void reset();
+
+  static bool isSupported(const ResamplerKernel kernel);
+
+  std::vector<std::vector<float>> _channels{};
+  std::vector<float> _coefficients{}; // _numPhases x _numTaps
+  DotFunc      _dot{nullptr};
+  uint64_t     _down{1};
+  unsigned int _inputRate{};
+  ResamplerKernel _kernel{ResamplerKernel::Scalar};
+  uint64_t     _numInputFrames{};
+  uint64_t     _numOutputFrames{};
+  std::size_t  _numPhases{1};
+  std::size_t  _numTaps{};
+  unsigned int _outputRate{};
+  uint64_t     _phase{};
+  std::size_t  _start{};
+  uint64_t     _up{1};
+};
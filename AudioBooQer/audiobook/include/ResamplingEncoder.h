@@ -0,0 +1,74 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "IAudioEncoder.h"
+#include "Resampler.h"
+
+/*
+ * NOTE:
+ * - ResamplingEncoder converts PCM of the current input rate to the rate of
+ *   the format passed to initialize(); initially, both rates are the same,
+ *   i.e. PCM is passed through.
+ * - setInputRate() may be called between inputs; a change of the rate
+ *   flushes the Resampler, a repeated rate keeps the stream continuous.
+ */
+
+class ResamplingEncoder : public IAudioEncoder {
+public:
+  ResamplingEncoder(AudioEncoderPtr encoder);
+  ~ResamplingEncoder();
+
+  unsigned int inputRate() const;
+  bool setInputRate(const unsigned int rate);
+
+  bool encode(const void *data, const std::size_t size);
+  bool flush();
+  bool initialize(const AacFormat& format,
+                  const std::filesystem::path& outputFileName);
+  bool initialize(const AacFormat& format, IAccessUnitSink *sink);
+  uint64_t numPcmFrames() const;
+  std::filesystem::path outputSuffix(const AacFormat& format) const;
+  std::string settings() const;
+
+private:
+  bool drain();
+  bool prepare(const AacFormat& format);
+
+  AudioEncoderPtr      _encoder{};
+  AacFormat            _format{};
+  bool                 _is_initialized{false};
+  std::vector<int16_t> _output{};
+  Resampler            _resampler{};
+};
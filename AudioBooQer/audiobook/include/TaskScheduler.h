@@ -0,0 +1,105 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * NOTE:
+ * TaskScheduler executes (CPU-bound) tasks on a fixed set of worker threads.
+ * Every worker owns a queue: a worker executes its own tasks in LIFO order
+ * and steals the oldest task of another worker, when running out of work.
+ * Tasks submitted by a worker are queued locally; tasks submitted by other
+ * threads are distributed round-robin.
+ *
+ * Tasks must never block on other tasks of the same scheduler; dependent
+ * tasks are executed in order by a TaskStrand.
+ */
+
+class TaskScheduler {
+public:
+  using Task = std::function<void()>;
+
+  TaskScheduler(const std::size_t numThreads = 0) noexcept;
+  ~TaskScheduler() noexcept;
+
+  bool isWorkerThread() const;
+  std::size_t numThreads() const;
+  uint64_t numSteals() const;
+
+  bool submit(Task&& task);
+  void wait();
+
+private:
+  struct Worker {
+    Worker() noexcept = default;
+
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+    std::thread      thread;
+  };
+
+  using WorkerPtr = std::unique_ptr<Worker>;
+
+  TaskScheduler(const TaskScheduler&) noexcept = delete;
+  TaskScheduler& operator=(const TaskScheduler&) noexcept = delete;
+
+  TaskScheduler(TaskScheduler&&) noexcept = delete;
+  TaskScheduler& operator=(TaskScheduler&&) noexcept = delete;
+
+  void execute(Task& task);
+  bool pop(const std::size_t index, Task *task);
+  void run(const std::size_t index);
+  bool steal(const std::size_t index, Task *task);
+
+  std::condition_variable  _idleCond;
+  std::mutex               _idleMutex;
+  std::atomic<std::size_t> _nextWorker{0};
+  std::atomic<std::size_t> _numPending{0}; // queued or running
+  std::atomic<std::size_t> _numQueued{0};
+  std::atomic<uint64_t>    _numSteals{0};
+  std::size_t              _numThreads{0};
+  bool                     _quit{false};
+  std::condition_variable  _sleepCond;
+  std::mutex               _sleepMutex;
+  std::vector<WorkerPtr>   _workers;
+};
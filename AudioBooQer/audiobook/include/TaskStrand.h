@@ -0,0 +1,75 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "TaskScheduler.h"
+
+/*
+ * NOTE:
+ * TaskStrand executes its tasks one at a time and in posting order on a
+ * TaskScheduler; no worker thread is occupied, while the strand is empty.
+ * Thus, the stages of one job (i.e. encode, flush, mux) are serialized,
+ * while any number of jobs share the scheduler's workers.
+ */
+
+class TaskStrand {
+public:
+  using Task = TaskScheduler::Task;
+
+  TaskStrand(TaskScheduler *scheduler) noexcept;
+  ~TaskStrand() noexcept;
+
+  bool isIdle() const;
+  std::size_t numQueued() const;
+
+  bool post(Task&& task);
+  void wait();
+
+private:
+  TaskStrand(const TaskStrand&) noexcept = delete;
+  TaskStrand& operator=(const TaskStrand&) noexcept = delete;
+
+  TaskStrand(TaskStrand&&) noexcept = delete;
+  TaskStrand& operator=(TaskStrand&&) noexcept = delete;
+
+  void drain();
+
+  std::condition_variable _cond;
+  bool                    _isRunning{false};
+  mutable std::mutex      _mutex;
+  TaskScheduler          *_scheduler{nullptr};
+  std::deque<Task>        _tasks;
+};
@@ -0,0 +1,79 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "IAudioDecoder.h"
+#include "MappedFile.h"
+#include "PcmUtil.h"
+
+/*
+ * NOTE:
+ * - WaveDecoder provides the PCM samples of a RIFF/WAVE file without copying;
+ *   the returned spans point directly into the file's memory mapping.
+ * - Only uncompressed PCM is supported: signed 16bit, 24bit and 32bit, or
+ *   32bit floating point. Anything but native endian, signed 16bit PCM is
+ *   converted to it, cf. pcm::convertToInt16(); then, read() returns a span
+ *   into an internal buffer, which remains valid until the next call.
+ * - format() always describes the 16bit output, as does read()'s 'maxSize'.
+ *   setDither() applies to subsequent conversions.
+ * - The sampling rate is not restricted, cf. AacFormat::isValidPcm().
+ */
+
+class WaveDecoder : public IAudioDecoder {
+public:
+  WaveDecoder();
+  ~WaveDecoder();
+
+  void close();
+  AacFormat format() const;
+  bool isAtEnd() const;
+  bool open(const std::filesystem::path& inputFileName);
+  std::span<const uint8_t> read(const std::size_t maxSize);
+
+  bool isConverting() const;
+  void setDither(const bool on);
+
+private:
+  bool parse();
+
+  std::vector<uint8_t> _buffer{};
+  pcm::Dither _dither{};
+  MappedFile  _file;
+  AacFormat   _format{};
+  bool        _isDithered{false};
+  bool        _isSwapped{false};
+  std::size_t _offset{};
+  pcm::SampleFormat _sampleFormat{pcm::SampleFormat::Int16};
+  std::span<const uint8_t> _samples{};
+};
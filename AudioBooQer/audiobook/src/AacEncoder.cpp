@@ -32,30 +32,50 @@
 #include <cstdint>
 #include <cstring>
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <aacenc_lib.h>
 
-#include <cs/IO/File.h>
+#include <cs/Text/PrintUtil.h>
 
 #include "AacEncoder.h"
 
+#include "BufferedFileWriter.h"
+#include "IAccessUnitSink.h"
 #include "Mpeg4Audio.h"
 
 ////// Implementation ////////////////////////////////////////////////////////
 
 inline constexpr int numBytesPerSample = 2;
 
+// NOTE: Stereo & SBR, i.e. 2048 samples per frame
+inline constexpr std::size_t maxNumFrameBytes = 2*2*mpeg4::numSamplesPerAacFrame*numBytesPerSample;
+
 static_assert(numBytesPerSample == sizeof(INT_PCM));
 
 static_assert(mpeg4::numSamplesPerAacFrame == 1024);
 
+static_assert(AacProfile::AAC_LC   == static_cast<AacProfile>(AOT_AAC_LC));
+static_assert(AacProfile::HE_AAC   == static_cast<AacProfile>(AOT_SBR));
+static_assert(AacProfile::HE_AACv2 == static_cast<AacProfile>(AOT_PS));
+
 /*
  * NOTE:
  * - FDK AAC seems to operate on native endian, signed 16bit integers ONLY!
  *   (cf. INT_PCM, libSYS/include/machine_type.h)
  * - We support only Mono & Stereo.
- * - The bitrate is fixed to 64k.
+ * - Profile, bitrate and bitrate mode are taken from AacFormat.
+ * - Output is either an ADTS stream written to a file, or raw access units
+ *   passed to an IAccessUnitSink (one AU per call).
+ * - ADTS signals SBR/PS implicitly; raw access units come with an explicit
+ *   hierarchical AudioSpecificConfig.
+ * - Only whole frames are passed to FDK AAC; a partial frame is kept until
+ *   the next call to encode() or flush(). FDK AAC v2.0.0 overflows its input
+ *   buffer otherwise when encoding PS (cf. aacEncEncode(), 'pIn').
  */
 
 class BufferDesc {
@@ -104,38 +124,278 @@ BufferDesc::operator AACENC_BufDesc*()
 class AacEncoderImpl {
 public:
   AacEncoderImpl() = default;
-  ~AacEncoderImpl() = default;
+  ~AacEncoderImpl();
 
   bool setParam(const AACENC_PARAM param, const UINT value);
-
-  uint8_t           bitstream[64*1024];
-  cs::File          file;
-  AacFormat         format{};
-  HANDLE_AACENCODER handle{};
-  BufferDesc        inDesc{};
-  AACENC_InfoStruct info{};
-  uint64_t          numDataSamples{};
-  BufferDesc        outDesc{};
-  uint8_t           zeros[64*1024];
+  bool write(const uint8_t *data, const int size);
+
+  uint8_t            bitstream[64*1024];
+  BufferedFileWriter file;
+  AacFormat          format{};
+  HANDLE_AACENCODER  handle{};
+  BufferDesc         inDesc{};
+  AACENC_InfoStruct  info{};
+  unsigned int       numChannelsOpen{};
+  uint64_t           numDataSamples{};
+  std::size_t        numPending{};
+  BufferDesc         outDesc{};
+  uint8_t            pending[maxNumFrameBytes];
+  IAccessUnitSink   *sink{nullptr};
+  uint8_t            zeros[64*1024];
 };
 
+AacEncoderImpl::~AacEncoderImpl()
+{
+  file.close();
+  aacEncClose(&handle);
+}
+
 bool AacEncoderImpl::setParam(const AACENC_PARAM param, const UINT value)
 {
   return aacEncoder_SetParam(handle, param, value) == AACENC_OK;
 }
 
+bool AacEncoderImpl::write(const uint8_t *data, const int size)
+{
+  if( sink != nullptr ) {
+    return sink->writeAccessUnit(data, std::size_t(size));
+  }
+  return file.write(data, std::size_t(size));
+}
+
+namespace priv {
+
+  // NOTE: Parameters affecting the encoded stream; cf. AacEncoder::settings()
+  inline constexpr UINT afterburner = 1;
+
+  // cf. AACENC_SIGNALING_MODE
+  inline constexpr UINT implicitSignaling     = 0;
+  inline constexpr UINT hierarchicalSignaling = 2;
+
+  class Pool {
+  public:
+    Pool() noexcept
+      : _idle()
+      , _maxIdle(2*std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+      , _mutex()
+      , _stats()
+    {
+    }
+
+    ~Pool() noexcept = default;
+
+    std::unique_ptr<AacEncoderImpl> acquire(const unsigned int numChannels)
+    {
+      const std::lock_guard<std::mutex> lock(_mutex);
+      for(auto it = _idle.begin(); it != _idle.end(); ++it) {
+        if( (*it)->numChannelsOpen == numChannels ) {
+          std::unique_ptr<AacEncoderImpl> result = std::move(*it);
+          _idle.erase(it);
+          return result;
+        }
+      }
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    void account(const bool is_reused, const double seconds)
+    {
+      const std::lock_guard<std::mutex> lock(_mutex);
+      if( is_reused ) {
+        _stats.numReused++;
+        _stats.secondsReuse += seconds;
+      } else {
+        _stats.numCreated++;
+        _stats.secondsCreate += seconds;
+      }
+    }
+
+    void clear()
+    {
+      const std::lock_guard<std::mutex> lock(_mutex);
+      _idle.clear();
+    }
+
+    void release(std::unique_ptr<AacEncoderImpl> impl)
+    {
+      // NOTE: Releases the writer's buffers; an idle encoder keeps its handle.
+      impl->file.close();
+      impl->sink = nullptr;
+      impl->numDataSamples = 0;
+      impl->numPending = 0;
+
+      const std::lock_guard<std::mutex> lock(_mutex);
+      if( _idle.size() < _maxIdle ) {
+        try {
+          _idle.push_back(std::move(impl));
+        } catch(...) {
+        }
+      }
+    }
+
+    void resetStatistics()
+    {
+      const std::lock_guard<std::mutex> lock(_mutex);
+      _stats = AacEncoderPoolStatistics();
+    }
+
+    AacEncoderPoolStatistics statistics() const
+    {
+      const std::lock_guard<std::mutex> lock(_mutex);
+      return _stats;
+    }
+
+  private:
+    std::vector<std::unique_ptr<AacEncoderImpl>> _idle;
+    std::size_t                                  _maxIdle;
+    mutable std::mutex                           _mutex;
+    AacEncoderPoolStatistics                     _stats;
+  };
+
+  Pool& pool()
+  {
+    static Pool instance;
+    return instance;
+  }
+
+  std::unique_ptr<AacEncoderImpl> open(const AacFormat& format, const TRANSPORT_TYPE transmux)
+  {
+    // (0) Sanity check //////////////////////////////////////////////////////
+
+    CHANNEL_MODE mode = MODE_INVALID;
+    if(        format.numChannels == 1 ) {
+      mode = MODE_1;
+    } else if( format.numChannels == 2 ) {
+      mode = MODE_2;
+    }
+
+    if( !format.isValid()    ||  // proper audio format passed in
+        mode == MODE_INVALID ) { // support Mono/Stereo only
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // (1) Reuse pooled encoder or open a new one ////////////////////////////
+
+    std::unique_ptr<AacEncoderImpl> result = pool().acquire(format.numChannels);
+    const bool is_reused = bool(result);
+
+    if( !is_reused ) {
+      try {
+        result = std::make_unique<AacEncoderImpl>();
+      } catch(...) {
+        return std::unique_ptr<AacEncoderImpl>();
+      }
+
+      if( aacEncOpen(&result->handle, 0, UINT(format.numChannels)) != AACENC_OK ) {
+        return std::unique_ptr<AacEncoderImpl>();
+      }
+      result->numChannelsOpen = format.numChannels;
+
+      result->inDesc.initialize(IN_AUDIO_DATA, numBytesPerSample);
+      result->outDesc.initialize(OUT_BITSTREAM_DATA, 1);
+      std::memset(result->zeros, 0, sizeof(result->zeros));
+    }
+
+    result->format = format;
+
+    // (2) Configure encoder /////////////////////////////////////////////////
+
+    if( !result->setParam(AACENC_AOT, UINT(format.profile)) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( format.bitRateMode == 0  &&  !result->setParam(AACENC_BITRATE, UINT(format.bitRate)) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_BITRATEMODE, UINT(format.bitRateMode)) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_SAMPLERATE, UINT(format.numSamplesPerSecond)) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_CHANNELMODE, UINT(mode)) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_CHANNELORDER, 1) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_AFTERBURNER, afterburner) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_GRANULE_LENGTH, UINT(mpeg4::numSamplesPerAacFrame)) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_TRANSMUX, UINT(transmux)) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    const UINT signaling = transmux == TT_MP4_RAW  &&  format.profile != AacProfile::AAC_LC
+        ? hierarchicalSignaling
+        : implicitSignaling;
+    if( !result->setParam(AACENC_SIGNALING_MODE, signaling) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_HEADER_PERIOD, 0) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( !result->setParam(AACENC_TPSUBFRAMES, 1) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    // NOTE: Discard any state (e.g. EOF, buffered input) of a pooled encoder!
+    if( is_reused  &&  !result->setParam(AACENC_CONTROL_STATE, AACENC_INIT_ALL) ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( aacEncEncode(result->handle, nullptr, nullptr, nullptr, nullptr) != AACENC_OK ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    if( aacEncInfo(result->handle, &result->info) != AACENC_OK  ||
+        result->info.frameLength*result->info.inputChannels*numBytesPerSample > maxNumFrameBytes ) {
+      return std::unique_ptr<AacEncoderImpl>();
+    }
+
+    // (3) Account setup time ////////////////////////////////////////////////
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    pool().account(is_reused, elapsed.count());
+
+    return result;
+  }
+
+} // namespace priv
+
 ////// public ////////////////////////////////////////////////////////////////
 
-AacEncoder::AacEncoder()
+double AacEncoderPoolStatistics::numSecondsSaved() const
+{
+  if( numCreated < 1 ) {
+    return 0;
+  }
+  return std::max<double>(0, double(numReused)*secondsCreate/double(numCreated) - secondsReuse);
+}
+
+AacEncoder::AacEncoder(const std::size_t outputBufferSize)
   : impl()
+  , _outputBufferSize(outputBufferSize)
 {
 }
 
 AacEncoder::~AacEncoder()
 {
   if( impl ) {
-    impl->file.close();
-    aacEncClose(&impl->handle);
+    priv::pool().release(std::move(impl));
   }
 }
 
@@ -149,14 +409,54 @@ bool AacEncoder::encode(const void *data, const std::size_t size)
   if( !isValidData(data, size) ) {
     return false;
   }
-  return encodeBlock(reinterpret_cast<const uint8_t*>(data), int(size));
+
+  const std::size_t frameSize =
+      std::size_t(impl->info.frameLength*impl->info.inputChannels)*numBytesPerSample;
+
+  const uint8_t *src = reinterpret_cast<const uint8_t*>(data);
+  std::size_t remain = size;
+
+  // (1) Complete pending frame //////////////////////////////////////////////
+
+  if( impl->numPending > 0 ) {
+    const std::size_t numTake = std::min<std::size_t>(remain, frameSize - impl->numPending);
+    std::memcpy(impl->pending + impl->numPending, src, numTake);
+    impl->numPending += numTake;
+
+    src    += numTake;
+    remain -= numTake;
+
+    if( impl->numPending < frameSize ) {
+      return true;
+    }
+
+    if( !encodeBlock(impl->pending, int(frameSize)) ) {
+      return false;
+    }
+    impl->numPending = 0;
+  }
+
+  // (2) Encode whole frames /////////////////////////////////////////////////
+
+  const std::size_t numWhole = remain/frameSize*frameSize;
+  if( numWhole > 0  &&  !encodeBlock(src, int(numWhole)) ) {
+    return false;
+  }
+
+  // (3) Keep partial frame //////////////////////////////////////////////////
+
+  std::memcpy(impl->pending, src + numWhole, remain - numWhole);
+  impl->numPending = remain - numWhole;
+
+  return true;
 }
 
 bool AacEncoder::flush()
 {
   // (1) Compute number of samples to fill ///////////////////////////////////
 
-  const unsigned int frameLength = mpeg4::numSamplesPerAacFrame;
+  // NOTE: With SBR, one frame comprises 2048 samples; cf. AACENC_InfoStruct
+  const unsigned int frameLength = impl->info.frameLength;
   const unsigned int  mod = static_cast<unsigned int>(numPcmFrames())%frameLength;
   const unsigned int fill = mod > 0
       ? frameLength - mod
@@ -164,8 +464,8 @@ bool AacEncoder::flush()
 
   // (2) Fill remaining frame with zeros /////////////////////////////////////
 
-  if( 0 < fill  &&  fill < mpeg4::numSamplesPerAacFrame  &&
-      !encodeBlock(impl->zeros, int(fill*impl->info.inputChannels)*numBytesPerSample) ) {
+  if( 0 < fill  &&  fill < frameLength  &&
+      !encode(impl->zeros, std::size_t(fill*impl->info.inputChannels)*numBytesPerSample) ) {
     return false;
   }
 
@@ -177,110 +477,66 @@ bool AacEncoder::flush()
       return false;
     }
   }
-  return true;
+  return impl->file.flush();
 }
 
 bool AacEncoder::initialize(const AacFormat& format, const std::filesystem::path& outputFileName)
 {
-  // (0) Sanity check ////////////////////////////////////////////////////////
-
-  CHANNEL_MODE mode = MODE_INVALID;
-  if(        format.numChannels == 1 ) {
-    mode = MODE_1;
-  } else if( format.numChannels == 2 ) {
-    mode = MODE_2;
-  }
-
-  if( impl                 ||  // do not operate on an existing instance
-      !format.isValid()    ||  // proper audio format passed in
-      mode == MODE_INVALID ) { // support Mono/Stereo only
+  if( impl ) { // do not operate on an existing instance
     return false;
   }
 
-  std::unique_ptr<AacEncoderImpl> result = std::make_unique<AacEncoderImpl>();
-  result->format = format;
-
   // (1) Open encoder ////////////////////////////////////////////////////////
 
-  if( aacEncOpen(&result->handle, 0, UINT(format.numChannels)) != AACENC_OK ) {
-    return false;
-  }
-
-  if( !result->setParam(AACENC_AOT, AOT_AAC_LC) ) {
-    return false;
-  }
-
-  if( !result->setParam(AACENC_BITRATE, 64000) ) {
-    return false;
-  }
-
-  if( !result->setParam(AACENC_BITRATEMODE, 0) ) {
-    return false;
-  }
-
-  if( !result->setParam(AACENC_SAMPLERATE, UINT(format.numSamplesPerSecond)) ) {
+  std::unique_ptr<AacEncoderImpl> result = priv::open(format, TT_MP4_ADTS);
+  if( !result ) {
     return false;
   }
 
-  if( !result->setParam(AACENC_CHANNELMODE, UINT(mode)) ) {
-    return false;
-  }
-
-  if( !result->setParam(AACENC_CHANNELORDER, 1) ) {
-    return false;
-  }
-
-  if( !result->setParam(AACENC_AFTERBURNER, 1) ) {
-    return false;
-  }
+  // (2) Create output file //////////////////////////////////////////////////
 
-  if( !result->setParam(AACENC_GRANULE_LENGTH, UINT(mpeg4::numSamplesPerAacFrame)) ) {
+  if( !result->file.setBufferSize(_outputBufferSize)  ||
+      !result->file.open(outputFileName) ) {
     return false;
   }
 
-  if( !result->setParam(AACENC_TRANSMUX, TT_MP4_ADTS) ) {
-    return false;
-  }
+  // (3) Store result ////////////////////////////////////////////////////////
 
-  if( !result->setParam(AACENC_SIGNALING_MODE, 0) ) {
-    return false;
-  }
+  impl = std::move(result);
 
-  if( !result->setParam(AACENC_HEADER_PERIOD, 0) ) {
-    return false;
-  }
+  return true;
+}
 
-  if( !result->setParam(AACENC_TPSUBFRAMES, 1) ) {
+bool AacEncoder::initialize(const AacFormat& format, IAccessUnitSink *sink)
+{
+  if( impl  ||  sink == nullptr ) { // do not operate on an existing instance
     return false;
   }
 
-  if( aacEncEncode(result->handle, nullptr, nullptr, nullptr, nullptr) != AACENC_OK ) {
-    return false;
-  }
+  // (1) Open encoder ////////////////////////////////////////////////////////
 
-  if( aacEncInfo(result->handle, &result->info) != AACENC_OK ) {
+  std::unique_ptr<AacEncoderImpl> result = priv::open(format, TT_MP4_RAW);
+  if( !result ) {
     return false;
   }
 
-  // (2) Create output file //////////////////////////////////////////////////
+  // (2) Pass AudioSpecificConfig to sink ////////////////////////////////////
 
-  if( !result->file.open(outputFileName, cs::FileOpenFlag::Write) ) {
+  if( !sink->setAudioSpecificConfig(result->info.confBuf, std::size_t(result->info.confSize)) ) {
     return false;
   }
 
   // (3) Store result ////////////////////////////////////////////////////////
 
   impl = std::move(result);
-  impl->inDesc.initialize(IN_AUDIO_DATA, numBytesPerSample);
-  impl->outDesc.initialize(OUT_BITSTREAM_DATA, 1);
-  std::memset(impl->zeros, 0, sizeof(impl->zeros));
+  impl->sink = sink;
 
   return true;
 }
 
 uint64_t AacEncoder::numPcmFrames() const
 {
-  return impl->numDataSamples/impl->info.inputChannels;
+  return (impl->numDataSamples + impl->numPending/numBytesPerSample)/impl->info.inputChannels;
 }
 
 std::filesystem::path AacEncoder::outputSuffix(const AacFormat&) const
@@ -288,6 +544,32 @@ std::filesystem::path AacEncoder::outputSuffix(const AacFormat&) const
   return "aac";
 }
 
+std::string AacEncoder::settings() const
+{
+  return encoderSettings();
+}
+
+void AacEncoder::clearPool()
+{
+  priv::pool().clear();
+}
+
+std::string AacEncoder::encoderSettings()
+{
+  // NOTE: Profile & bitrate are part of the AacFormat; cf. EncodeCache::computeKey()
+  return cs::sprint("AacEncoder;afterburner=%", priv::afterburner);
+}
+
+AacEncoderPoolStatistics AacEncoder::poolStatistics()
+{
+  return priv::pool().statistics();
+}
+
+void AacEncoder::resetPoolStatistics()
+{
+  priv::pool().resetStatistics();
+}
+
 ////// private ///////////////////////////////////////////////////////////////
 
 bool AacEncoder::encodeBlock(const uint8_t *data, int size, bool *eof)
@@ -296,12 +578,12 @@ bool AacEncoder::encodeBlock(const uint8_t *data, int size, bool *eof)
     impl->inDesc.assign(data, size);
     impl->outDesc.assign(impl->bitstream, sizeof(impl->bitstream));
 
-    AACENC_InArgs in_args;
+    AACENC_InArgs in_args{};
     in_args.numInSamples = size < 1
         ? -1      // Flush encoder!
         : size/numBytesPerSample;
 
-    AACENC_OutArgs out_args;
+    AACENC_OutArgs out_args{};
     const AACENC_ERROR error =
         aacEncEncode(impl->handle, impl->inDesc, impl->outDesc, &in_args, &out_args);
 
@@ -315,8 +597,7 @@ bool AacEncoder::encodeBlock(const uint8_t *data, int size, bool *eof)
 
     impl->numDataSamples += uint64_t(out_args.numInSamples);
 
-    if( out_args.numOutBytes > 0  &&
-        impl->file.write(impl->bitstream, out_args.numOutBytes) != std::size_t(out_args.numOutBytes) ) {
+    if( out_args.numOutBytes > 0  &&  !impl->write(impl->bitstream, out_args.numOutBytes) ) {
       return false;
     }
 
@@ -31,6 +31,14 @@
 
 #include "AacFormat.h"
 
+bool AacFormat::isSamePcmFormat(const AacFormat& other) const
+{
+  return
+      numBitsPerChannel   == other.numBitsPerChannel  &&
+      numChannels         == other.numChannels        &&
+      numSamplesPerSecond == other.numSamplesPerSecond;
+}
+
 bool AacFormat::isSupportedRate(const unsigned int rate) const
 {
   for(unsigned int i = 0; i < numSupportedRates(); i++) {
@@ -43,21 +51,44 @@ bool AacFormat::isSupportedRate(const unsigned int rate) const
 
 bool AacFormat::isValid() const
 {
-  if( numBitsPerChannel != 16 ) {
+  if( !isValidPcm() ) {
     return false;
   }
 
-  if( numChannels != 1  &&  numChannels != 2 ) {
+  if( !isSupportedRate(numSamplesPerSecond) ) {
     return false;
   }
 
-  if( !isSupportedRate(numSamplesPerSecond) ) {
+  if( bitRateMode > maxBitRateMode  ||  (bitRateMode == 0  &&  bitRate < 1) ) {
+    return false;
+  }
+
+  if( profile != AacProfile::AAC_LC    &&
+      profile != AacProfile::HE_AAC    &&
+      profile != AacProfile::HE_AACv2 ) {
+    return false;
+  }
+
+  if( profile != AacProfile::AAC_LC  &&
+      (numSamplesPerSecond < minSbrRate  ||  numSamplesPerSecond > maxSbrRate) ) {
+    return false;
+  }
+
+  if( profile == AacProfile::HE_AACv2  &&  numChannels != 2 ) {
     return false;
   }
 
   return true;
 }
 
+bool AacFormat::isValidPcm() const
+{
+  return
+      numBitsPerChannel == 16  &&
+      (numChannels == 1  ||  numChannels == 2)  &&
+      numSamplesPerSecond > 0;
+}
+
 unsigned int AacFormat::numBytesPerChannel() const
 {
   return numBitsPerChannel/8;
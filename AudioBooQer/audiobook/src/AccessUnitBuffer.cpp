@@ -0,0 +1,101 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include "AccessUnitBuffer.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+const std::vector<uint8_t>& AccessUnitBuffer::audioSpecificConfig() const
+{
+  return _asc;
+}
+
+void AccessUnitBuffer::clear()
+{
+  _asc.clear();
+  _payload.clear();
+  _sizes.clear();
+}
+
+bool AccessUnitBuffer::isEmpty() const
+{
+  return _sizes.empty();
+}
+
+std::size_t AccessUnitBuffer::numAccessUnits() const
+{
+  return _sizes.size();
+}
+
+bool AccessUnitBuffer::writeTo(IAccessUnitSink *sink, const std::size_t first,
+                               const std::size_t count) const
+{
+  if( sink == nullptr  ||  first > _sizes.size() ) {
+    return false;
+  }
+  const std::size_t last = count < _sizes.size() - first
+      ? first + count
+      : _sizes.size();
+
+  const uint8_t *data = _payload.data();
+  for(std::size_t i = 0; i < first; i++) {
+    data += _sizes[i];
+  }
+
+  return sink->writeAccessUnits(data, _sizes.data() + first, last - first);
+}
+
+bool AccessUnitBuffer::setAudioSpecificConfig(const uint8_t *asc, const std::size_t size)
+{
+  if( asc == nullptr  ||  size < 1 ) {
+    return false;
+  }
+  try {
+    _asc.assign(asc, asc + size);
+  } catch(...) {
+    return false;
+  }
+  return true;
+}
+
+bool AccessUnitBuffer::writeAccessUnit(const uint8_t *data, const std::size_t size)
+{
+  if( data == nullptr  ||  size < 1 ) {
+    return false;
+  }
+  try {
+    _payload.insert(_payload.end(), data, data + size);
+    _sizes.push_back(uint32_t(size));
+  } catch(...) {
+    return false;
+  }
+  return true;
+}
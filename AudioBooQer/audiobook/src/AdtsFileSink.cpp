@@ -0,0 +1,95 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <array>
+
+#include "AdtsFileSink.h"
+
+#include "Mpeg4Audio.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+AdtsFileSink::AdtsFileSink(const std::size_t bufferSize) noexcept
+  : _file(bufferSize)
+{
+}
+
+AdtsFileSink::~AdtsFileSink() noexcept
+{
+}
+
+bool AdtsFileSink::close()
+{
+  return _file.close();
+}
+
+bool AdtsFileSink::flush()
+{
+  return _file.flush();
+}
+
+bool AdtsFileSink::isOpen() const
+{
+  return _file.isOpen();
+}
+
+bool AdtsFileSink::open(const std::filesystem::path& filename)
+{
+  return _file.open(filename);
+}
+
+bool AdtsFileSink::setBufferSize(const std::size_t size)
+{
+  return _file.setBufferSize(size);
+}
+
+bool AdtsFileSink::setAudioSpecificConfig(const uint8_t *asc, const std::size_t size)
+{
+  // NOTE: ADTS signals SBR/PS implicitly; i.e. only the AAC core remains.
+  mpeg4::AudioSpecificConfig config;
+  if( !mpeg4::parseAudioSpecificConfig(&config, asc, size) ) {
+    return false;
+  }
+  _asc = mpeg4::coreAscFromConfig(config); // NOTE: Big endian, as mpeg4::*FromASC()
+  return _asc != 0;
+}
+
+bool AdtsFileSink::writeAccessUnit(const uint8_t *data, const std::size_t size)
+{
+  const std::array<uint8_t,mpeg4::numAdtsHeaderBytes> header =
+      mpeg4::createAdtsHeader(_asc, size);
+  if( data == nullptr  ||  header[0] == 0 ) {
+    return false;
+  }
+  return
+      _file.write(header.data(), header.size())  &&
+      _file.write(data, size);
+}
@@ -0,0 +1,366 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include <cs/Logging/OutputContext.h>
+
+#include "AdtsIndex.h"
+
+#include "AdtsParser.h"
+#include "Checksum.h"
+#include "FileUtil.h"
+#include "MappedFile.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  /*
+   * NOTE:
+   * Layout of the sidecar; all values are little endian:
+   * - Header: magic[8], file's size (u64), file's time (i64), ASC (u16),
+   *   reserved (u16), #ranges (u32), #frames (u64), #PCM frames (u64)
+   * - #ranges x (offset (u64), size (u64))
+   * - #frames x (offset (u64), length (u16))
+   * - XXH64 (u64) of all of the above
+   */
+  inline constexpr char magic[8] = {'A', 'D', 'T', 'S', 'I', 'D', 'X', '2'};
+
+  inline constexpr std::size_t  headerSize = 48;
+  inline constexpr std::size_t   rangeSize = 16;
+  inline constexpr std::size_t   frameSize = 10;
+  inline constexpr std::size_t trailerSize = 8;
+
+  template<typename T>
+  void put(uint8_t *&data, const T value)
+  {
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+      *data++ = uint8_t(uint64_t(value) >> (8*i));
+    }
+  }
+
+  template<typename T>
+  T get(const uint8_t *&data)
+  {
+    uint64_t value = 0;
+    for(std::size_t i = 0; i < sizeof(T); i++) {
+      value |= uint64_t(*data++) << (8*i);
+    }
+    return T(value);
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+uint16_t AdtsIndex::audioSpecificConfig() const
+{
+  return _asc;
+}
+
+void AdtsIndex::clear()
+{
+  _asc          = 0;
+  _fileSize     = 0;
+  _fileTime     = 0;
+  _frames.clear();
+  _numFrames    = 0;
+  _numPcmFrames = 0;
+  _skipped.clear();
+}
+
+const std::vector<AdtsIndex::Frame>& AdtsIndex::frames() const
+{
+  return _frames;
+}
+
+bool AdtsIndex::isEmpty() const
+{
+  return _numFrames < 1;
+}
+
+uint64_t AdtsIndex::numFrames() const
+{
+  return _numFrames;
+}
+
+uint64_t AdtsIndex::numPcmFrames() const
+{
+  return _numPcmFrames;
+}
+
+void AdtsIndex::setNumPcmFrames(const uint64_t numPcmFrames)
+{
+  _numPcmFrames = numPcmFrames;
+}
+
+const std::vector<AdtsIndex::Range>& AdtsIndex::skippedRanges() const
+{
+  return _skipped;
+}
+
+bool AdtsIndex::build(const std::filesystem::path& adtsFileName, const cs::OutputContext& ctx)
+{
+  clear();
+
+  // (1) Map ADTS file ///////////////////////////////////////////////////////
+
+  MappedFile file;
+  if( !guard(adtsFileName, &_fileSize, &_fileTime)  ||
+      !file.open(adtsFileName)  ||  file.size() != _fileSize ) {
+    ctx.logError(u8"Unable to read ADTS file \"" + adtsFileName.generic_u8string() + u8"\"!");
+    clear();
+    return false;
+  }
+
+  // (2) Scan & validate frames //////////////////////////////////////////////
+
+  AdtsParser adts(file.span());
+  try {
+    for(;;) {
+      if( !adts.hasFrame() ) {
+        const uint64_t offset = adts.offset();
+
+        AdtsParser::size_type numSkipped{0};
+        const bool isFrame = adts.resync(&numSkipped);
+        if( numSkipped > 0 ) {
+          _skipped.emplace_back(offset, numSkipped);
+        }
+
+        if( !isFrame ) {
+          break;
+        }
+      }
+
+      const uint16_t asc = adts.mpeg4AudioSpecificConfig();
+      if( _asc == 0 ) {
+        _asc = asc;
+      }
+
+      if( adts.aacFrameCount() != 1 ) {
+        ctx.logError(u8"Invalid AAC frame count detected!");
+        clear();
+        return false;
+      }
+
+      if( _asc == 0  ||  asc != _asc ) {
+        ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+        clear();
+        return false;
+      }
+
+      Frame frame;
+      frame.offset = adts.offset();
+      frame.length = uint16_t(adts.frameData() + adts.frameSize() - (file.data() + adts.offset()));
+      _frames.push_back(frame);
+
+      adts.nextFrame();
+    }
+  } catch(...) {
+    ctx.logError(u8"std::vector<>::push_back() failed!");
+    clear();
+    return false;
+  }
+
+  _numFrames = _frames.size();
+
+  return !isEmpty();
+}
+
+bool AdtsIndex::load(const std::filesystem::path& adtsFileName, const bool withFrames)
+{
+  clear();
+
+  // (1) Map sidecar /////////////////////////////////////////////////////////
+
+  uint64_t fileSize{0};
+  int64_t  fileTime{0};
+  if( !guard(adtsFileName, &fileSize, &fileTime) ) {
+    return false;
+  }
+
+  MappedFile file;
+  if( !file.open(sidecarName(adtsFileName))  ||
+      file.size() < priv::headerSize + priv::trailerSize ) {
+    return false;
+  }
+
+  // (2) Validate checksum ///////////////////////////////////////////////////
+
+  const std::size_t size = file.size() - priv::trailerSize;
+  const uint8_t *trailer = file.data() + size;
+  if( checksum::xxh64(file.data(), size) != priv::get<uint64_t>(trailer) ) {
+    return false;
+  }
+
+  // (3) Validate header /////////////////////////////////////////////////////
+
+  const uint8_t *data = file.data();
+  if( !std::equal(priv::magic, priv::magic + sizeof(priv::magic), data) ) {
+    return false;
+  }
+  data += sizeof(priv::magic);
+
+  const uint64_t    guardSize = priv::get<uint64_t>(data);
+  const int64_t     guardTime = priv::get<int64_t>(data);
+  const uint16_t          asc = priv::get<uint16_t>(data);
+  priv::get<uint16_t>(data); // reserved
+  const uint32_t    numRanges = priv::get<uint32_t>(data);
+  const uint64_t    numFrames = priv::get<uint64_t>(data);
+  const uint64_t numPcmFrames = priv::get<uint64_t>(data);
+
+  if( guardSize != fileSize  ||  guardTime != fileTime  ||  asc == 0  ||  numFrames < 1  ||
+      numFrames > (size - priv::headerSize)/priv::frameSize  ||
+      size != priv::headerSize + numRanges*priv::rangeSize + numFrames*priv::frameSize ) {
+    return false;
+  }
+
+  // (4) Read ranges & frames ////////////////////////////////////////////////
+
+  try {
+    _skipped.resize(numRanges);
+    for(Range& range : _skipped) {
+      range.first  = priv::get<uint64_t>(data);
+      range.second = priv::get<uint64_t>(data);
+    }
+
+    if( withFrames ) {
+      _frames.resize(std::size_t(numFrames));
+      for(Frame& frame : _frames) {
+        frame.offset = priv::get<uint64_t>(data);
+        frame.length = priv::get<uint16_t>(data);
+        if( frame.offset + frame.length > fileSize ) {
+          clear();
+          return false;
+        }
+      }
+    }
+  } catch(...) {
+    clear();
+    return false;
+  }
+
+  _asc          = asc;
+  _fileSize     = fileSize;
+  _fileTime     = fileTime;
+  _numFrames    = numFrames;
+  _numPcmFrames = numPcmFrames;
+
+  return true;
+}
+
+bool AdtsIndex::save(const std::filesystem::path& adtsFileName) const
+{
+  if( isEmpty()  ||  _frames.size() != _numFrames ) {
+    return false;
+  }
+
+  // (1) Serialize index /////////////////////////////////////////////////////
+
+  std::vector<uint8_t> buffer;
+  try {
+    buffer.resize(priv::headerSize + _skipped.size()*priv::rangeSize +
+                  _frames.size()*priv::frameSize + priv::trailerSize);
+  } catch(...) {
+    return false;
+  }
+
+  uint8_t *data = std::copy(priv::magic, priv::magic + sizeof(priv::magic), buffer.data());
+  priv::put<uint64_t>(data, _fileSize);
+  priv::put<int64_t>(data, _fileTime);
+  priv::put<uint16_t>(data, _asc);
+  priv::put<uint16_t>(data, 0); // reserved
+  priv::put<uint32_t>(data, uint32_t(_skipped.size()));
+  priv::put<uint64_t>(data, _numFrames);
+  priv::put<uint64_t>(data, _numPcmFrames);
+
+  for(const Range& range : _skipped) {
+    priv::put<uint64_t>(data, range.first);
+    priv::put<uint64_t>(data, range.second);
+  }
+
+  for(const Frame& frame : _frames) {
+    priv::put<uint64_t>(data, frame.offset);
+    priv::put<uint16_t>(data, frame.length);
+  }
+
+  priv::put<uint64_t>(data, checksum::xxh64(buffer.data(), buffer.size() - priv::trailerSize));
+
+  // (2) Replace sidecar /////////////////////////////////////////////////////
+
+  return fileutil::writeFile(sidecarName(adtsFileName), buffer.data(), buffer.size());
+}
+
+std::span<const uint8_t> AdtsIndex::accessUnit(const std::span<const uint8_t>& adts,
+                                               const Frame& frame)
+{
+  if( frame.offset + frame.length > adts.size() ) {
+    return std::span<const uint8_t>();
+  }
+
+  const AdtsParser parser(adts.subspan(std::size_t(frame.offset)));
+  if( !parser.hasFrame()  ||
+      parser.frameData() + parser.frameSize() != adts.data() + frame.offset + frame.length ) {
+    return std::span<const uint8_t>();
+  }
+
+  return std::span<const uint8_t>(parser.frameData(), parser.frameSize());
+}
+
+std::filesystem::path AdtsIndex::sidecarName(const std::filesystem::path& adtsFileName)
+{
+  std::filesystem::path result(adtsFileName);
+  result += ".idx";
+  return result;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool AdtsIndex::guard(const std::filesystem::path& adtsFileName, uint64_t *size, int64_t *time)
+{
+  std::error_code ec;
+
+  const std::uintmax_t fileSize = std::filesystem::file_size(adtsFileName, ec);
+  if( ec ) {
+    return false;
+  }
+
+  const std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(adtsFileName, ec);
+  if( ec ) {
+    return false;
+  }
+
+  *size = uint64_t(fileSize);
+  *time = int64_t(fileTime.time_since_epoch().count());
+
+  return true;
+}
@@ -29,20 +29,149 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <algorithm>
+#include <bit>
+
 #include <cs/Core/Endian.h>
 
+#if defined(__SSE2__)  ||  defined(_M_X64)  ||  (defined(_M_IX86_FP)  &&  _M_IX86_FP >= 2)
+# define HAVE_SSE2
+# include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__)  &&  (defined(__x86_64__)  ||  defined(__i386__))  &&  \
+    !defined(ADTSPARSER_NO_AVX2)
+# define HAVE_AVX2
+# include <immintrin.h>
+#endif
+
 #include "AdtsParser.h"
 
 #include "Mpeg4Audio.h"
 
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  using size_type = AdtsParser::size_type;
+
+  using FindFunc = size_type (*)(const uint8_t *data, size_type pos, const size_type size);
+
+  // NOTE: Sampling frequency indices 13-15 are reserved (resp. escape).
+  inline constexpr uint64_t numFrequencies = 13;
+
+  // 0xFFF, layer 0
+  inline bool isSync(const uint8_t *data)
+  {
+    return data[0] == 0xFF  &&  (data[1] & 0xF6) == 0xF0;
+  }
+
+  size_type findSyncScalar(const uint8_t *data, size_type pos, const size_type size)
+  {
+    for(; pos + 1 < size; pos++) {
+      if( isSync(data + pos) ) {
+        return pos;
+      }
+    }
+    return size;
+  }
+
+#ifdef HAVE_SSE2
+  size_type findSyncSSE2(const uint8_t *data, size_type pos, const size_type size)
+  {
+    const __m128i   ff = _mm_set1_epi8(char(0xFF));
+    const __m128i mask = _mm_set1_epi8(char(0xF6));
+    const __m128i sync = _mm_set1_epi8(char(0xF0));
+    for(; pos + 17 <= size; pos += 16) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+      const __m128i match = _mm_and_si128(_mm_cmpeq_epi8(a, ff),
+                                          _mm_cmpeq_epi8(_mm_and_si128(b, mask), sync));
+      const unsigned int bits = unsigned(_mm_movemask_epi8(match));
+      if( bits != 0 ) {
+        return pos + size_type(std::countr_zero(bits));
+      }
+    }
+    return findSyncScalar(data, pos, size);
+  }
+#endif
+
+#ifdef HAVE_AVX2
+  __attribute__((target("avx2")))
+  size_type findSyncAVX2(const uint8_t *data, size_type pos, const size_type size)
+  {
+    const __m256i   ff = _mm256_set1_epi8(char(0xFF));
+    const __m256i mask = _mm256_set1_epi8(char(0xF6));
+    const __m256i sync = _mm256_set1_epi8(char(0xF0));
+    for(; pos + 33 <= size; pos += 32) {
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+      const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 1));
+      const __m256i match = _mm256_and_si256(_mm256_cmpeq_epi8(a, ff),
+                                             _mm256_cmpeq_epi8(_mm256_and_si256(b, mask), sync));
+      const unsigned int bits = unsigned(_mm256_movemask_epi8(match));
+      if( bits != 0 ) {
+        return pos + size_type(std::countr_zero(bits));
+      }
+    }
+    return findSyncScalar(data, pos, size);
+  }
+#endif
+
+  FindFunc selectFindSync()
+  {
+#ifdef HAVE_AVX2
+    if( __builtin_cpu_supports("avx2") ) {
+      return findSyncAVX2;
+    }
+#endif
+#ifdef HAVE_SSE2
+    return findSyncSSE2;
+#else
+    return findSyncScalar;
+#endif
+  }
+
+  /*
+   * NOTE:
+   * Returns the offset of the first sync word at or after 'pos'; a trailing
+   * 0xFF may be the start of a sync word beyond 'size'.
+   */
+  size_type findSync(const uint8_t *data, const size_type pos, const size_type size)
+  {
+    static const FindFunc func = selectFindSync();
+
+    const size_type result = func(data, pos, size);
+    if( result >= size  &&  pos < size  &&  data[size - 1] == 0xFF ) {
+      return size - 1;
+    }
+    return result;
+  }
+
+} // namespace priv
+
 ////// public ////////////////////////////////////////////////////////////////
 
 AdtsParser::AdtsParser(cs::Buffer&& buffer)
   : _buffer(std::move(buffer))
 {
+  _data = _buffer.data();
+  _size = _buffer.size();
   readHeader();
 }
 
+AdtsParser::AdtsParser(const uint8_t *data, const size_type size)
+  : _buffer()
+  , _data(data)
+  , _size(data != nullptr ? size : 0)
+{
+  readHeader();
+}
+
+AdtsParser::AdtsParser(const std::span<const uint8_t>& data)
+  : AdtsParser(data.data(), data.size())
+{
+}
+
 AdtsParser::size_type AdtsParser::aacFrameCount() const
 {
   return hasFrame()
@@ -53,7 +182,7 @@ AdtsParser::size_type AdtsParser::aacFrameCount() const
 const uint8_t *AdtsParser::frameData() const
 {
   return hasFrame()
-      ? _buffer.data() + _offset + headerSize()
+      ? _data + _offset + headerSize()
       : nullptr;
 }
 
@@ -66,7 +195,7 @@ AdtsParser::size_type AdtsParser::frameSize() const
 
 bool AdtsParser::hasFrame() const
 {
-  return isHeader()  &&  _offset + adtsLength() <= _buffer.size();
+  return isHeader()  &&  _offset + adtsLength() <= _size;
 }
 
 bool AdtsParser::isMpeg2Frame() const
@@ -93,6 +222,11 @@ bool AdtsParser::nextFrame()
   return hasFrame();
 }
 
+AdtsParser::size_type AdtsParser::offset() const
+{
+  return _offset;
+}
+
 bool AdtsParser::reset()
 {
   _offset = 0;
@@ -100,6 +234,31 @@ bool AdtsParser::reset()
   return hasFrame();
 }
 
+bool AdtsParser::resync(size_type *numSkipped, const bool isEndOfData)
+{
+  const size_type start = _offset;
+
+  if( !hasFrame() ) {
+    size_type pos = _offset;
+    while( pos < _size ) {
+      pos = priv::findSync(_data, pos, _size);
+      if( pos >= _size  ||  isCandidate(pos, isEndOfData) ) {
+        break;
+      }
+      pos++;
+    }
+
+    _offset = std::min(pos, _size);
+    readHeader();
+  }
+
+  if( numSkipped != nullptr ) {
+    *numSkipped = _offset - start;
+  }
+
+  return hasFrame();
+}
+
 ////// private ///////////////////////////////////////////////////////////////
 
 AdtsParser::size_type AdtsParser::adtsLength() const
@@ -109,6 +268,15 @@ AdtsParser::size_type AdtsParser::adtsLength() const
       : 0;
 }
 
+uint64_t AdtsParser::headerAt(const size_type offset) const
+{
+  if( offset + sizeof(uint64_t) > _size ) {
+    return 0;
+  }
+
+  return cs::fromBigEndian<uint64_t>(*reinterpret_cast<const uint64_t*>(_data + offset));
+}
+
 AdtsParser::size_type AdtsParser::headerSize() const
 {
   return isHeader()
@@ -118,9 +286,36 @@ AdtsParser::size_type AdtsParser::headerSize() const
       : 0;
 }
 
+bool AdtsParser::isCandidate(const size_type offset, const bool isEndOfData) const
+{
+  if( offset + sizeof(uint64_t) > _size ) {
+    return !isEndOfData; // Truncated; cf. findSync()
+  }
+  const uint64_t header = headerAt(offset);
+
+  // (1) Validate header /////////////////////////////////////////////////////
+
+  if( !isValidHeader(header) ) {
+    return false;
+  }
+  const size_type length = (header & AdtsLength) >> 21;
+
+  // (2) Validate next header ////////////////////////////////////////////////
+
+  const size_type next = offset + length;
+  if( next > _size ) {
+    return !isEndOfData; // Truncated
+  }
+  if( next + sizeof(uint64_t) > _size ) {
+    return true; // At end of data
+  }
+
+  return (headerAt(next) & FixedHeader) == (header & FixedHeader);
+}
+
 bool AdtsParser::isHeader() const
 {
-  return (_header & Sync) == Sync;
+  return isValidHeader(_header);
 }
 
 bool AdtsParser::isNoProtection() const
@@ -128,6 +323,18 @@ bool AdtsParser::isNoProtection() const
   return isHeader()  &&  (_header & NoProtection) == NoProtection;
 }
 
+bool AdtsParser::isValidHeader(const uint64_t header)
+{
+  if( (header & (Sync | Layer)) != Sync  ||
+      ((header & Mpeg4Frequency) >> 42) >= priv::numFrequencies ) {
+    return false;
+  }
+
+  // NOTE: A frame holds at least one byte beyond its header.
+  const size_type length = (header & AdtsLength) >> 21;
+  return length > ((header & NoProtection) == NoProtection ? 7 : 9);
+}
+
 uint16_t AdtsParser::mpeg4AudioType() const
 {
   return isHeader()
@@ -158,13 +365,7 @@ AdtsParser::size_type AdtsParser::numberFrames() const
 
 bool AdtsParser::readHeader()
 {
-  _header = 0;
-
-  if( _offset + sizeof(uint64_t) > _buffer.size() ) {
-    return false;
-  }
-
-  _header = cs::fromBigEndian<uint64_t>(*reinterpret_cast<const uint64_t*>(_buffer.data() + _offset));
+  _header = headerAt(_offset);
 
   return isHeader();
 }
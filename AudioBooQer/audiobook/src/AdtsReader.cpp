@@ -0,0 +1,186 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "AdtsReader.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+AdtsReader::AdtsReader(const size_type windowSize)
+  : _file()
+  , _parser()
+  , _window()
+{
+  // The window must hold (at least) two frames of maximum length!
+  _window.resize(std::max<size_type>(windowSize, 2*maxAdtsLength));
+}
+
+void AdtsReader::close()
+{
+  _parser.reset();
+  _file.close();
+  _base = 0;
+  _eof  = false;
+  _size = 0;
+}
+
+bool AdtsReader::isOpen() const
+{
+  return _file.isOpen();
+}
+
+bool AdtsReader::open(const std::filesystem::path& filename)
+{
+  close();
+
+  if( !_file.open(filename) ) {
+    return false;
+  }
+
+  return fill(0);
+}
+
+AdtsReader::size_type AdtsReader::aacFrameCount() const
+{
+  return _parser
+      ? _parser->aacFrameCount()
+      : 0;
+}
+
+const uint8_t *AdtsReader::frameData() const
+{
+  return _parser
+      ? _parser->frameData()
+      : nullptr;
+}
+
+AdtsReader::size_type AdtsReader::frameSize() const
+{
+  return _parser
+      ? _parser->frameSize()
+      : 0;
+}
+
+bool AdtsReader::hasFrame() const
+{
+  return _parser  &&  _parser->hasFrame();
+}
+
+bool AdtsReader::isEndOfFile() const
+{
+  return _eof  &&  (!_parser  ||  _parser->offset() >= _size);
+}
+
+uint16_t AdtsReader::mpeg4AudioSpecificConfig() const
+{
+  return _parser
+      ? _parser->mpeg4AudioSpecificConfig()
+      : 0;
+}
+
+bool AdtsReader::nextFrame()
+{
+  if( !_parser ) {
+    return false;
+  }
+
+  if( _parser->nextFrame()  ||  _eof ) {
+    return _parser->hasFrame();
+  }
+
+  return fill(_parser->offset());
+}
+
+AdtsReader::size_type AdtsReader::offset() const
+{
+  return _parser
+      ? _base + _parser->offset()
+      : _base;
+}
+
+bool AdtsReader::resync(size_type *numSkipped)
+{
+  const size_type start = offset();
+
+  bool result = false;
+  while( _parser ) {
+    result = _parser->resync(nullptr, _eof);
+    if( result  ||  _eof ) {
+      break;
+    }
+
+    // NOTE: Keeps a candidate, that is truncated by the window.
+    result = fill(_parser->offset());
+    if( result ) {
+      break;
+    }
+  }
+
+  if( numSkipped != nullptr ) {
+    *numSkipped = offset() - start;
+  }
+
+  return result;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool AdtsReader::fill(const size_type offset)
+{
+  // (1) Move incomplete frame to front of window ////////////////////////////
+
+  const size_type remain = offset < _size
+      ? _size - offset
+      : 0;
+  if( remain > 0  &&  offset > 0 ) {
+    std::memmove(_window.data(), _window.data() + offset, remain);
+  }
+  _base += _size - remain;
+  _size  = remain;
+
+  // (2) Fill window /////////////////////////////////////////////////////////
+
+  while( !_eof  &&  _size < _window.size() ) {
+    const size_type numRead = _file.read(_window.data() + _size, _window.size() - _size);
+    if( numRead < 1 ) {
+      _eof = true;
+    }
+    _size += numRead;
+  }
+
+  // (3) Parse window ////////////////////////////////////////////////////////
+
+  _parser.emplace(_window.data(), _size);
+
+  return _parser->hasFrame();
+}
@@ -0,0 +1,187 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include "AudioProbe.h"
+
+#include "MappedFile.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  // NOTE: An MPEG frame header is searched for within the first bytes only.
+  inline constexpr std::size_t maxSyncSearch = 64*1024;
+
+  inline uint32_t readLE32(const uint8_t *data)
+  {
+    return uint32_t(data[0]) | uint32_t(data[1]) << 8 |
+        uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+  }
+
+  inline bool isFourCC(const uint8_t *data, const char *fourcc)
+  {
+    return std::equal(data, data + 4, fourcc);
+  }
+
+  bool waveRate(const uint8_t *data, const std::size_t size, unsigned int *rate)
+  {
+    if( size < 12  ||  !isFourCC(data, "RIFF")  ||  !isFourCC(data + 8, "WAVE") ) {
+      return false;
+    }
+
+    for(std::size_t pos = 12; pos + 8 <= size; ) {
+      const std::size_t len = readLE32(data + pos + 4);
+      if( isFourCC(data + pos, "fmt ") ) {
+        if( len < 16  ||  len > size - pos - 8 ) {
+          return false;
+        }
+        *rate = readLE32(data + pos + 12);
+        return *rate > 0;
+      }
+
+      // Chunks are padded to even sizes!
+      pos += 8 + len + (len & 1);
+    }
+
+    return false;
+  }
+
+  struct MpegHeader {
+    MpegHeader() noexcept = default;
+
+    std::size_t  frameLength{};
+    unsigned int rate{};
+    uint8_t      version{};
+    uint8_t      layer{};
+  };
+
+  bool parseMpegHeader(MpegHeader *header, const uint8_t *data)
+  {
+    static const unsigned int bitRates[5][15] = { // [kbit/s]
+      {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448}, // V1 L1
+      {0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384}, // V1 L2
+      {0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320}, // V1 L3
+      {0, 32, 48, 56,  64,  80,  96, 112, 128, 144, 160, 176, 192, 224, 256}, // V2 L1
+      {0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160}  // V2 L2 & L3
+    };
+    static const unsigned int rates[3] = {44100, 48000, 32000};
+
+    if( data[0] != 0xFF  ||  (data[1] & 0xE0) != 0xE0 ) {
+      return false;
+    }
+
+    const unsigned int version = (data[1] >> 3) & 0x03; // 0: 2.5, 1: reserved, 2: 2, 3: 1
+    const unsigned int   layer = 4 - ((data[1] >> 1) & 0x03);
+    const unsigned int bitRate = data[2] >> 4;
+    const unsigned int    rate = (data[2] >> 2) & 0x03;
+    const unsigned int padding = (data[2] >> 1) & 0x01;
+    if( version == 1  ||  layer == 4  ||  bitRate == 0  ||  bitRate == 15  ||  rate == 3 ) {
+      return false;
+    }
+
+    const bool isV1 = version == 3;
+    const unsigned int bps = 1000*bitRates[isV1 ? layer - 1 : (layer == 1 ? 3 : 4)][bitRate];
+
+    header->version = uint8_t(version);
+    header->layer   = uint8_t(layer);
+    header->rate    = rates[rate] >> (isV1 ? 0 : (version == 2 ? 1 : 2));
+
+    if(        layer == 1 ) {
+      header->frameLength = (12*bps/header->rate + padding)*4;
+    } else if( layer == 3  &&  !isV1 ) {
+      header->frameLength = 72*bps/header->rate + padding;
+    } else {
+      header->frameLength = 144*bps/header->rate + padding;
+    }
+
+    return true;
+  }
+
+  bool mpegRate(const uint8_t *data, const std::size_t size, unsigned int *rate)
+  {
+    // (1) Skip ID3v2 tag ////////////////////////////////////////////////////
+
+    std::size_t pos = 0;
+    if( size >= 10  &&  std::equal(data, data + 3, "ID3") ) {
+      const std::size_t tagSize = std::size_t(data[6] & 0x7F) << 21 | std::size_t(data[7] & 0x7F) << 14 |
+          std::size_t(data[8] & 0x7F) << 7 | std::size_t(data[9] & 0x7F);
+      pos = 10 + tagSize + ((data[5] & 0x10) != 0 ? 10 : 0);
+    }
+
+    // (2) Search for two consecutive, matching frame headers ////////////////
+
+    const std::size_t end = std::min(size, pos + maxSyncSearch);
+    for(; pos + 4 <= end; pos++) {
+      MpegHeader first;
+      if( !parseMpegHeader(&first, data + pos) ) {
+        continue;
+      }
+
+      const std::size_t next = pos + first.frameLength;
+      MpegHeader second;
+      if( next + 4 > size  ||  !parseMpegHeader(&second, data + next)  ||
+          second.version != first.version  ||  second.layer != first.layer  ||
+          second.rate != first.rate ) {
+        continue;
+      }
+
+      *rate = first.rate;
+      return true;
+    }
+
+    return false;
+  }
+
+} // namespace priv
+
+////// Public ////////////////////////////////////////////////////////////////
+
+namespace probe {
+
+  bool samplingRate(const std::filesystem::path& filename, unsigned int *rate)
+  {
+    if( rate == nullptr ) {
+      return false;
+    }
+    *rate = 0;
+
+    MappedFile file;
+    if( !file.open(filename) ) {
+      return false;
+    }
+
+    return priv::waveRate(file.data(), file.size(), rate)  ||
+        priv::mpegRate(file.data(), file.size(), rate);
+  }
+
+} // namespace probe
@@ -0,0 +1,243 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#include "BufferedFileWriter.h"
+
+#include "IoThread.h"
+
+////// Implementation ////////////////////////////////////////////////////////
+
+namespace priv {
+
+  std::atomic<uint64_t> totalNumBytes{0};
+  std::atomic<uint64_t> totalNumWrites{0};
+
+} // namespace priv
+
+void BufferedFileWriter::AlignedDelete::operator()(uint8_t *p) const
+{
+  ::operator delete[](p, std::align_val_t(alignment));
+}
+
+////// public ////////////////////////////////////////////////////////////////
+
+BufferedFileWriter::BufferedFileWriter(const std::size_t bufferSize) noexcept
+  : _bufferSize(std::max<std::size_t>(bufferSize, 1))
+{
+}
+
+BufferedFileWriter::~BufferedFileWriter() noexcept
+{
+  close();
+}
+
+std::size_t BufferedFileWriter::bufferSize() const
+{
+  return _bufferSize;
+}
+
+bool BufferedFileWriter::close()
+{
+  const bool result = flush();
+  wait();
+  _file.close();
+
+  // NOTE: A closed writer holds no buffers; cf. open()
+  _buffer.reset();
+  _inFlight.reset();
+
+  return result;
+}
+
+bool BufferedFileWriter::flush()
+{
+  return submit()  &&  wait();
+}
+
+bool BufferedFileWriter::isOpen() const
+{
+  return _file.isOpen();
+}
+
+uint64_t BufferedFileWriter::numBytes() const
+{
+  return _numBytes;
+}
+
+uint64_t BufferedFileWriter::numWrites() const
+{
+  return _numWrites;
+}
+
+bool BufferedFileWriter::open(const std::filesystem::path& filename)
+{
+  close();
+
+  _fill      = 0;
+  _numBytes  = 0;
+  _numWrites = 0;
+
+  if( !allocate(_buffer)  ||  !allocate(_inFlight) ) {
+    return false;
+  }
+
+  return _file.open(filename, cs::FileOpenFlag::Write);
+}
+
+bool BufferedFileWriter::setBufferSize(const std::size_t size)
+{
+  if( size == _bufferSize ) {
+    return true;
+  }
+
+  if( !flush() ) {
+    return false;
+  }
+
+  _buffer.reset();
+  _inFlight.reset();
+  _bufferSize = std::max<std::size_t>(size, 1);
+
+  return !isOpen()  ||  (allocate(_buffer)  &&  allocate(_inFlight));
+}
+
+bool BufferedFileWriter::write(const void *data, const std::size_t size)
+{
+  if( !isOpen()  ||  !_buffer  ||  !_inFlight  ||  data == nullptr ) {
+    return false;
+  }
+
+  const uint8_t *src = reinterpret_cast<const uint8_t*>(data);
+  std::size_t remain = size;
+  while( remain > 0 ) {
+    const std::size_t numCopy = std::min<std::size_t>(remain, _bufferSize - _fill);
+    std::memcpy(_buffer.get() + _fill, src, numCopy);
+    _fill += numCopy;
+
+    src    += numCopy;
+    remain -= numCopy;
+
+    if( _fill >= _bufferSize  &&  !submit() ) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void BufferedFileWriter::resetTotals()
+{
+  priv::totalNumBytes  = 0;
+  priv::totalNumWrites = 0;
+}
+
+uint64_t BufferedFileWriter::totalNumBytes()
+{
+  return priv::totalNumBytes;
+}
+
+uint64_t BufferedFileWriter::totalNumWrites()
+{
+  return priv::totalNumWrites;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool BufferedFileWriter::allocate(BufferPtr& buffer) const
+{
+  if( buffer ) {
+    return true;
+  }
+
+  try {
+    // NOTE: Round up to a multiple of the alignment.
+    const std::size_t size = (_bufferSize + alignment - 1)/alignment*alignment;
+    buffer.reset(static_cast<uint8_t*>(::operator new[](size, std::align_val_t(alignment))));
+  } catch(...) {
+    return false;
+  }
+
+  return true;
+}
+
+void BufferedFileWriter::count(const std::size_t size)
+{
+  _numBytes  += size;
+  _numWrites += 1;
+  priv::totalNumBytes  += size;
+  priv::totalNumWrites += 1;
+}
+
+bool BufferedFileWriter::submit()
+{
+  if( _fill < 1 ) {
+    return true;
+  }
+
+  // (1) Wait for the previous write; bounds buffers in use to two ///////////
+
+  if( !wait() ) {
+    return false;
+  }
+
+  // (2) Swap buffers and write the full one asynchronously //////////////////
+
+  count(_fill);
+  std::swap(_buffer, _inFlight);
+
+  const uint8_t *data = _inFlight.get();
+  const std::size_t size = _fill;
+  _fill = 0;
+
+  try {
+    _pending = IoThread::instance().submit([this, data, size]() -> bool {
+      return _file.write(data, size) == size;
+    });
+  } catch(...) {
+    return false;
+  }
+
+  return true;
+}
+
+bool BufferedFileWriter::wait()
+{
+  if( !_pending.valid() ) {
+    return true;
+  }
+  return _pending.get();
+}
@@ -0,0 +1,158 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstring>
+
+#include "Checksum.h"
+
+#include "MappedFile.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+// NOTE: cf. https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+
+namespace priv {
+
+  inline constexpr uint64_t Prime1 = 0x9E3779B185EBCA87;
+  inline constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4F;
+  inline constexpr uint64_t Prime3 = 0x165667B19E3779F9;
+  inline constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63;
+  inline constexpr uint64_t Prime5 = 0x27D4EB2F165667C5;
+
+  template<typename T>
+  inline T load(const uint8_t *data) // NOTE: Little endian host!
+  {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  inline uint64_t rotl(const uint64_t x, const int r)
+  {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  inline uint64_t round(uint64_t acc, const uint64_t input)
+  {
+    acc += input*Prime2;
+    acc  = rotl(acc, 31);
+    return acc*Prime1;
+  }
+
+  inline uint64_t merge(uint64_t acc, const uint64_t value)
+  {
+    acc ^= round(0, value);
+    return acc*Prime1 + Prime4;
+  }
+
+} // namespace priv
+
+////// Public ////////////////////////////////////////////////////////////////
+
+namespace checksum {
+
+  uint64_t xxh64(const void *input, const std::size_t size, const uint64_t seed)
+  {
+    using namespace priv;
+
+    const uint8_t *data = static_cast<const uint8_t*>(input);
+    const uint8_t  *end = data + size;
+
+    uint64_t hash;
+    if( size >= 32 ) {
+      uint64_t v1 = seed + Prime1 + Prime2;
+      uint64_t v2 = seed + Prime2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - Prime1;
+
+      for(; end - data >= 32; data += 32) {
+        v1 = round(v1, load<uint64_t>(data));
+        v2 = round(v2, load<uint64_t>(data + 8));
+        v3 = round(v3, load<uint64_t>(data + 16));
+        v4 = round(v4, load<uint64_t>(data + 24));
+      }
+
+      hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+      hash = merge(hash, v1);
+      hash = merge(hash, v2);
+      hash = merge(hash, v3);
+      hash = merge(hash, v4);
+    } else {
+      hash = seed + Prime5;
+    }
+
+    hash += uint64_t(size);
+
+    for(; end - data >= 8; data += 8) {
+      hash ^= round(0, load<uint64_t>(data));
+      hash  = rotl(hash, 27)*Prime1 + Prime4;
+    }
+
+    if( end - data >= 4 ) {
+      hash ^= uint64_t(load<uint32_t>(data))*Prime1;
+      hash  = rotl(hash, 23)*Prime2 + Prime3;
+      data += 4;
+    }
+
+    for(; data < end; data++) {
+      hash ^= uint64_t(*data)*Prime5;
+      hash  = rotl(hash, 11)*Prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+  }
+
+  bool xxh64(const std::filesystem::path& filename, uint64_t *hash, uint64_t *size)
+  {
+    if( hash == nullptr ) {
+      return false;
+    }
+
+    MappedFile file;
+    if( !file.open(filename) ) {
+      return false;
+    }
+
+    *hash = xxh64(file.data(), file.size());
+    if( size != nullptr ) {
+      *size = uint64_t(file.size());
+    }
+
+    return true;
+  }
+
+} // namespace checksum
@@ -0,0 +1,126 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <string>
+
+#include "DualMonoEncoder.h"
+
+#include "PcmUtil.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+DualMonoEncoder::DualMonoEncoder(AudioEncoderPtr encoder)
+  : _encoder(std::move(encoder))
+{
+}
+
+DualMonoEncoder::~DualMonoEncoder()
+{
+}
+
+bool DualMonoEncoder::isDownmixed() const
+{
+  return _downmix;
+}
+
+bool DualMonoEncoder::encode(const void *data, const std::size_t size)
+{
+  if( !_encoder  ||  !isValidData(data, size) ) {
+    return false;
+  }
+
+  if( !_downmix ) {
+    return _encoder->encode(data, size);
+  }
+
+  const std::size_t numFrames = size/_format.numBytesPerPcmFrame();
+  if( numFrames*_format.numBytesPerPcmFrame() != size ) {
+    return false;
+  }
+
+  try {
+    _mono.resize(numFrames);
+  } catch(...) {
+    return false;
+  }
+  pcm::downmixStereo(_mono.data(), reinterpret_cast<const int16_t*>(data), numFrames);
+
+  return _encoder->encode(_mono.data(), _mono.size()*sizeof(int16_t));
+}
+
+bool DualMonoEncoder::flush()
+{
+  return _encoder  &&  _encoder->flush();
+}
+
+bool DualMonoEncoder::initialize(const AacFormat& format, const std::filesystem::path& outputFileName)
+{
+  return _encoder  &&  _encoder->initialize(prepare(format), outputFileName);
+}
+
+bool DualMonoEncoder::initialize(const AacFormat& format, IAccessUnitSink *sink)
+{
+  return _encoder  &&  _encoder->initialize(prepare(format), sink);
+}
+
+uint64_t DualMonoEncoder::numPcmFrames() const
+{
+  return _encoder->numPcmFrames();
+}
+
+std::filesystem::path DualMonoEncoder::outputSuffix(const AacFormat& format) const
+{
+  return _encoder->outputSuffix(format);
+}
+
+std::string DualMonoEncoder::settings() const
+{
+  const std::string encoderSettings = _encoder->settings();
+  return !encoderSettings.empty()
+      ? std::string("DualMonoEncoder;") + encoderSettings
+      : std::string();
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+AacFormat DualMonoEncoder::prepare(const AacFormat& format)
+{
+  _downmix = format.numChannels == 2  &&  format.numBitsPerChannel == 16  &&
+      format.profile != AacProfile::HE_AACv2;
+  _format = format;
+
+  AacFormat result = format;
+  if( _downmix ) {
+    result.numChannels = 1;
+  }
+
+  return result;
+}
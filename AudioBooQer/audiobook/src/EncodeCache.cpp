@@ -0,0 +1,365 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+
+#include <cs/Core/Buffer.h>
+#include <cs/Logging/ILogger.h>
+#include <cs/Logging/OutputContext.h>
+
+#include "EncodeCache.h"
+
+#include "AdtsIndex.h"
+#include "Checksum.h"
+#include "FileUtil.h"
+#include "IAccessUnitSink.h"
+#include "MappedFile.h"
+#include "Mpeg4Audio.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  template<typename T>
+  void append(cs::Buffer& buffer, const T& value)
+  {
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), data, data + sizeof(T));
+  }
+
+  // NOTE: A file failing to index is not cached; there is nothing to report.
+  class NullLogger : public cs::ILogger {
+  public:
+    NullLogger() noexcept = default;
+    ~NullLogger() noexcept = default;
+
+    void logText(const std::u8string& /*msg*/) const override
+    {
+    }
+
+    void logWarning(const std::u8string& /*msg*/) const override
+    {
+    }
+
+    void logError(const std::u8string& /*msg*/) const override
+    {
+    }
+  };
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+std::filesystem::path EncodeCache::directory() const
+{
+  return _directory;
+}
+
+bool EncodeCache::isOpen() const
+{
+  return !_directory.empty();
+}
+
+uint64_t EncodeCache::maxSize() const
+{
+  return _maxSize;
+}
+
+bool EncodeCache::open(const std::filesystem::path& directory, const uint64_t maxSize)
+{
+  _directory.clear();
+  _maxSize = maxSize;
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+  if( !std::filesystem::is_directory(directory, ec) ) {
+    return false;
+  }
+
+  try {
+    _directory = directory;
+  } catch(...) {
+    return false;
+  }
+
+  return true;
+}
+
+bool EncodeCache::lookup(const Key key, uint64_t *numPcmFrames) const
+{
+  AdtsIndex index;
+  if( numPcmFrames == nullptr  ||  !load(key, &index, false) ) {
+    return false;
+  }
+
+  *numPcmFrames = index.numPcmFrames();
+
+  return true;
+}
+
+bool EncodeCache::restore(const Key key, const std::filesystem::path& outputFileName) const
+{
+  AdtsIndex index;
+  if( !load(key, &index, false)  ||  !fileutil::linkFile(entryName(key), outputFileName) ) {
+    return false;
+  }
+
+  // NOTE: The sidecar is optional; a stale one is detected by AdtsIndex::load().
+  fileutil::linkFile(AdtsIndex::sidecarName(entryName(key)),
+                     AdtsIndex::sidecarName(outputFileName));
+
+  return true;
+}
+
+bool EncodeCache::restore(const Key key, IAccessUnitSink *sink, const AacProfile profile) const
+{
+  AdtsIndex index;
+  if( sink == nullptr  ||  !load(key, &index, true) ) {
+    return false;
+  }
+
+  // (1) Map ADTS file ///////////////////////////////////////////////////////
+
+  MappedFile file;
+  if( !file.open(entryName(key)) ) {
+    return false;
+  }
+
+  // (2) Locate all access units; the sink may not be able to discard any ////
+
+  for(const AdtsIndex::Frame& frame : index.frames()) {
+    if( AdtsIndex::accessUnit(file.span(), frame).empty() ) {
+      return false;
+    }
+  }
+
+  // (3) Pass AudioSpecificConfig and access units to sink ///////////////////
+
+  // NOTE: ADTS signals SBR/PS implicitly; cf. AacEncoder::initialize()
+  const uint16_t asc = index.audioSpecificConfig();
+  if( profile == AacProfile::AAC_LC ) {
+    if( !sink->setAudioSpecificConfig(reinterpret_cast<const uint8_t*>(&asc), sizeof(uint16_t)) ) {
+      return false;
+    }
+  } else {
+    const std::array<uint8_t,mpeg4::numExplicitSbrConfigBytes> config =
+        mpeg4::createExplicitSbrConfig(asc, uint16_t(profile));
+    if( !sink->setAudioSpecificConfig(config.data(), config.size()) ) {
+      return false;
+    }
+  }
+
+  for(const AdtsIndex::Frame& frame : index.frames()) {
+    const std::span<const uint8_t> unit = AdtsIndex::accessUnit(file.span(), frame);
+    if( !sink->writeAccessUnit(unit.data(), unit.size()) ) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool EncodeCache::store(const Key key, const std::filesystem::path& encodedFileName,
+                        const uint64_t numPcmFrames) const
+{
+  if( !isOpen()  ||  numPcmFrames < 1 ) {
+    return false;
+  }
+
+  // (1) Index ADTS file /////////////////////////////////////////////////////
+
+  const std::filesystem::path tempFileName = fileutil::tempFileName(entryName(key));
+  if( !fileutil::linkFile(encodedFileName, tempFileName) ) {
+    fileutil::removeFile(tempFileName);
+    return false;
+  }
+
+  const priv::NullLogger logger;
+  const cs::OutputContext ctx(&logger, false, nullptr, false);
+
+  AdtsIndex index;
+  if( !index.build(tempFileName, ctx)  ||  !index.skippedRanges().empty() ) {
+    fileutil::removeFile(tempFileName);
+    return false;
+  }
+  index.setNumPcmFrames(numPcmFrames);
+
+  // (2) Replace ADTS file; the sidecar completes the entry //////////////////
+
+  // NOTE: Renaming keeps the size and time, which guard the sidecar.
+  if( !fileutil::replaceFile(tempFileName, entryName(key))  ||  !index.save(entryName(key)) ) {
+    return false;
+  }
+
+  // NOTE: The sidecar is optional; cf. restore()
+  fileutil::linkFile(AdtsIndex::sidecarName(entryName(key)),
+                     AdtsIndex::sidecarName(encodedFileName));
+
+  evict();
+
+  return true;
+}
+
+bool EncodeCache::computeKey(Key *key, const std::vector<std::filesystem::path>& inputFileNames,
+                             const AacFormat& format, const std::string& settings)
+{
+  if( key == nullptr  ||  inputFileNames.empty()  ||  !format.isValid()  ||  settings.empty() ) {
+    return false;
+  }
+
+  cs::Buffer material;
+  try {
+    // (1) Content of input files ////////////////////////////////////////////
+
+    for(const std::filesystem::path& filename : inputFileNames) {
+      uint64_t hash = 0;
+      uint64_t size = 0;
+      if( !checksum::xxh64(filename, &hash, &size) ) {
+        return false;
+      }
+      priv::append(material, hash);
+      priv::append(material, size);
+    }
+
+    // (2) PCM format & encoding /////////////////////////////////////////////
+
+    priv::append(material, uint32_t(format.numBitsPerChannel));
+    priv::append(material, uint32_t(format.numChannels));
+    priv::append(material, uint32_t(format.numSamplesPerSecond));
+    priv::append(material, uint32_t(format.profile));
+    priv::append(material, uint32_t(format.bitRate));
+    priv::append(material, uint32_t(format.bitRateMode));
+
+    // (3) Encoder's settings ////////////////////////////////////////////////
+
+    material.insert(material.end(), settings.begin(), settings.end());
+  } catch(...) {
+    return false;
+  }
+
+  *key = checksum::xxh64(material.data(), material.size());
+
+  return true;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+std::filesystem::path EncodeCache::entryName(const Key key) const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.aac", static_cast<unsigned long long>(key));
+  return _directory / name;
+}
+
+void EncodeCache::evict() const
+{
+  // NOTE: Concurrent stores leave eviction to the first one.
+  const std::unique_lock<std::mutex> lock(_evictMutex, std::try_to_lock);
+  if( !lock.owns_lock() ) {
+    return;
+  }
+
+  // (1) Collect complete entries ////////////////////////////////////////////
+
+  struct Entry {
+    std::filesystem::file_time_type time{};
+    std::filesystem::path           sidecarName{};
+    uint64_t                        size{};
+  };
+
+  std::vector<Entry> entries;
+  uint64_t numBytes = 0;
+  try {
+    std::error_code ec;
+    for(const std::filesystem::directory_entry& item :
+        std::filesystem::directory_iterator(_directory, ec)) {
+      if( item.path().extension() != ".idx" ) {
+        continue;
+      }
+
+      // NOTE: "<key>.aac.idx" -> "<key>.aac"
+      std::filesystem::path aacName = item.path();
+      aacName.replace_extension();
+
+      Entry entry;
+      entry.time        = item.last_write_time(ec);
+      entry.sidecarName = item.path();
+      entry.size        = std::filesystem::file_size(aacName, ec);
+      if( ec ) {
+        ec.clear();
+        continue;
+      }
+
+      entries.push_back(std::move(entry));
+      numBytes += entries.back().size;
+    }
+  } catch(...) {
+    return;
+  }
+
+  // (2) Evict least recently used entries ///////////////////////////////////
+
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) -> bool {
+    return a.time < b.time;
+  });
+
+  for(const Entry& entry : entries) {
+    if( numBytes <= _maxSize ) {
+      break;
+    }
+
+    // NOTE: Removing the sidecar first invalidates the entry.
+    std::filesystem::path aacName = entry.sidecarName;
+    aacName.replace_extension();
+    fileutil::removeFile(entry.sidecarName);
+    fileutil::removeFile(aacName);
+
+    numBytes -= entry.size;
+  }
+}
+
+bool EncodeCache::load(const Key key, AdtsIndex *index, const bool withFrames) const
+{
+  if( !isOpen()  ||  !index->load(entryName(key), withFrames)  ||
+      index->numPcmFrames() < 1  ||  !index->skippedRanges().empty() ) {
+    return false;
+  }
+
+  // NOTE: Mark entry as used; cf. evict()
+  std::error_code ec;
+  std::filesystem::last_write_time(AdtsIndex::sidecarName(entryName(key)),
+                                   std::filesystem::file_time_type::clock::now(), ec);
+
+  return true;
+}
@@ -0,0 +1,247 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+
+#include <system_error>
+#include <vector>
+
+#include "FanOutEncoder.h"
+#include "PcmUtil.h"
+
+////// Implementation ////////////////////////////////////////////////////////
+
+struct FanOutVariant {
+  FanOutVariant() noexcept = default;
+
+  AudioEncoderPtr       encoder{};
+  AacFormat             format{};
+  std::filesystem::path name{};
+  std::filesystem::path outputFileName{};
+  std::vector<int16_t>  pcm{};
+};
+
+class FanOutEncoderImpl {
+public:
+  FanOutEncoderImpl() = default;
+  ~FanOutEncoderImpl() = default;
+
+  AacFormat                  format{};
+  bool                       is_initialized{false};
+  std::vector<FanOutVariant> variants{};
+};
+
+namespace priv {
+
+  // NOTE: Mono -> Stereo duplicates; Stereo -> Mono averages the channels.
+  bool remix(std::vector<int16_t>& dest, const unsigned int numDestChannels,
+             const int16_t *src, const unsigned int numSrcChannels,
+             const std::size_t numFrames)
+  {
+    try {
+      dest.resize(numFrames*numDestChannels);
+    } catch(...) {
+      return false;
+    }
+
+    if(        numSrcChannels == 1  &&  numDestChannels == 2 ) {
+      for(std::size_t i = 0; i < numFrames; i++) {
+        dest[2*i]     = src[i];
+        dest[2*i + 1] = src[i];
+      }
+    } else if( numSrcChannels == 2  &&  numDestChannels == 1 ) {
+      pcm::downmixStereo(dest.data(), src, numFrames);
+    } else {
+      return false;
+    }
+
+    return true;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+FanOutEncoder::FanOutEncoder()
+{
+  try {
+    impl = std::make_unique<FanOutEncoderImpl>();
+  } catch(...) {
+    impl.reset();
+  }
+}
+
+FanOutEncoder::~FanOutEncoder()
+{
+}
+
+bool FanOutEncoder::addVariant(AudioEncoderPtr encoder, const AacFormat& format,
+                               const std::filesystem::path& name)
+{
+  if( !impl  ||  impl->is_initialized  ||  !encoder  ||
+      format.numChannels < 1  ||  format.numChannels > 2  ||  name.empty() ) {
+    return false;
+  }
+
+  try {
+    FanOutVariant variant;
+    variant.encoder = std::move(encoder);
+    variant.format  = format;
+    variant.name    = name;
+    impl->variants.push_back(std::move(variant));
+  } catch(...) {
+    return false;
+  }
+
+  return true;
+}
+
+std::size_t FanOutEncoder::numVariants() const
+{
+  return impl
+      ? impl->variants.size()
+      : 0;
+}
+
+std::filesystem::path FanOutEncoder::outputFileName(const std::size_t index) const
+{
+  return index < numVariants()
+      ? impl->variants[index].outputFileName
+      : std::filesystem::path();
+}
+
+bool FanOutEncoder::encode(const void *data, const std::size_t size)
+{
+  if( !impl  ||  !impl->is_initialized  ||  !isValidData(data, size) ) {
+    return false;
+  }
+
+  const std::size_t numFrames = size/impl->format.numBytesPerPcmFrame();
+  if( numFrames*impl->format.numBytesPerPcmFrame() != size ) {
+    return false;
+  }
+
+  for(FanOutVariant& variant : impl->variants) {
+    if( variant.format.numChannels == impl->format.numChannels ) {
+      if( !variant.encoder->encode(data, size) ) {
+        return false;
+      }
+      continue;
+    }
+
+    if( !priv::remix(variant.pcm, variant.format.numChannels,
+                     reinterpret_cast<const int16_t*>(data), impl->format.numChannels,
+                     numFrames)  ||
+        !variant.encoder->encode(variant.pcm.data(), variant.pcm.size()*sizeof(int16_t)) ) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool FanOutEncoder::flush()
+{
+  if( !impl  ||  !impl->is_initialized ) {
+    return false;
+  }
+
+  bool result = true;
+  for(FanOutVariant& variant : impl->variants) {
+    result = variant.encoder->flush()  &&  result;
+  }
+
+  return result;
+}
+
+bool FanOutEncoder::initialize(const AacFormat& format, const std::filesystem::path& outputFileName)
+{
+  if( !impl  ||  impl->is_initialized  ||  impl->variants.empty()  ||  !format.isValid() ) {
+    return false;
+  }
+
+  // (1) Remixing is performed on 16bit PCM only /////////////////////////////
+
+  for(const FanOutVariant& variant : impl->variants) {
+    if( variant.format.numChannels != format.numChannels  &&
+        format.numBitsPerChannel != 16 ) {
+      return false;
+    }
+  }
+
+  // (2) Initialize variants /////////////////////////////////////////////////
+
+  for(FanOutVariant& variant : impl->variants) {
+    AacFormat variantFormat = format;
+    variantFormat.numChannels = variant.format.numChannels;
+    variantFormat.bitRate     = variant.format.bitRate;
+    variantFormat.bitRateMode = variant.format.bitRateMode;
+    variantFormat.profile     = variant.format.profile;
+
+    variant.outputFileName = variantFileName(outputFileName, variant.name);
+
+    std::error_code ec;
+    std::filesystem::create_directories(variant.outputFileName.parent_path(), ec);
+    if( ec ) {
+      return false;
+    }
+
+    if( !variant.encoder->initialize(variantFormat, variant.outputFileName) ) {
+      return false;
+    }
+  }
+
+  impl->format         = format;
+  impl->is_initialized = true;
+
+  return true;
+}
+
+uint64_t FanOutEncoder::numPcmFrames() const
+{
+  return impl  &&  impl->is_initialized
+      ? impl->variants.front().encoder->numPcmFrames()
+      : 0;
+}
+
+std::filesystem::path FanOutEncoder::outputSuffix(const AacFormat& format) const
+{
+  return numVariants() > 0
+      ? impl->variants.front().encoder->outputSuffix(format)
+      : std::filesystem::path();
+}
+
+std::filesystem::path FanOutEncoder::variantFileName(const std::filesystem::path& outputFileName,
+                                                     const std::filesystem::path& name)
+{
+  return outputFileName.parent_path() / name / outputFileName.filename();
+}
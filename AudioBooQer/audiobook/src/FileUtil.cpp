@@ -0,0 +1,162 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifdef _WIN32
+# define NOMINMAX
+# define WIN32_LEAN_AND_MEAN
+# include <Windows.h>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <cstdio>
+
+#include <atomic>
+
+#include <cs/IO/File.h>
+
+#include "FileUtil.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  std::atomic<uint64_t> nextTempFileId{0};
+
+  unsigned long long processId()
+  {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long long>(getpid());
+#endif
+  }
+
+  // NOTE: Flush the file's data to the storage device.
+  bool syncFile(const std::filesystem::path& filename)
+  {
+#ifdef _WIN32
+    const HANDLE file = CreateFileW(filename.c_str(), GENERIC_WRITE, 0, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if( file == INVALID_HANDLE_VALUE ) {
+      return false;
+    }
+
+    const bool result = FlushFileBuffers(file) != FALSE;
+    CloseHandle(file);
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if( fd < 0 ) {
+      return false;
+    }
+
+    const bool result = fsync(fd) == 0;
+    ::close(fd);
+#endif
+
+    return result;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+namespace fileutil {
+
+  bool linkFile(const std::filesystem::path& from, const std::filesystem::path& to)
+  {
+    removeFile(to);
+
+    std::error_code ec;
+    std::filesystem::create_hard_link(from, to, ec);
+    if( !ec ) {
+      return true;
+    }
+
+    ec.clear();
+    return std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec)  &&
+        !ec;
+  }
+
+  void removeFile(const std::filesystem::path& filename)
+  {
+    std::error_code ec;
+    std::filesystem::remove(filename, ec);
+  }
+
+  bool replaceFile(const std::filesystem::path& tempFileName,
+                   const std::filesystem::path& filename)
+  {
+    std::error_code ec;
+    std::filesystem::rename(tempFileName, filename, ec);
+    if( ec ) {
+      removeFile(tempFileName);
+      return false;
+    }
+    return true;
+  }
+
+  std::filesystem::path tempFileName(const std::filesystem::path& filename)
+  {
+    char suffix[64];
+    std::snprintf(suffix, sizeof(suffix), ".%llu.%llu.tmp", priv::processId(),
+                  static_cast<unsigned long long>(priv::nextTempFileId++));
+
+    std::filesystem::path result(filename);
+    result += suffix;
+    return result;
+  }
+
+  bool writeFile(const std::filesystem::path& filename,
+                 const void *data, const std::size_t size)
+  {
+    const std::filesystem::path tempName = tempFileName(filename);
+    {
+      cs::File file;
+      if( !file.open(tempName, cs::FileOpenFlag::Write)  ||
+          file.write(data, size) != size ) {
+        file.close();
+        removeFile(tempName);
+        return false;
+      }
+    }
+
+    // NOTE: Otherwise, a crash may leave the renamed file without its data.
+    if( !priv::syncFile(tempName) ) {
+      removeFile(tempName);
+      return false;
+    }
+
+    return replaceFile(tempName, filename);
+  }
+
+} // namespace fileutil
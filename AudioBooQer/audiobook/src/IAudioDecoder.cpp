@@ -0,0 +1,66 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include "IAudioDecoder.h"
+
+#include "IAudioEncoder.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+IAudioDecoder::~IAudioDecoder()
+{
+}
+
+bool IAudioDecoder::encode(IAudioEncoder *encoder, const std::size_t blockSize)
+{
+  if( encoder == nullptr ) {
+    return false;
+  }
+
+  // Keep blocks aligned to PCM frames!
+  const std::size_t numBytesPerPcmFrame = format().numBytesPerPcmFrame();
+  if( numBytesPerPcmFrame < 1  ||  blockSize < numBytesPerPcmFrame ) {
+    return false;
+  }
+  const std::size_t maxSize = blockSize - blockSize%numBytesPerPcmFrame;
+
+  while( !isAtEnd() ) {
+    const std::span<const uint8_t> block = read(maxSize);
+    if( block.empty() ) {
+      return false;
+    }
+    if( !encoder->encode(block.data(), block.size()) ) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -42,6 +42,16 @@ bool IAudioEncoder::flush()
   return true;
 }
 
+bool IAudioEncoder::initialize(const AacFormat&, IAccessUnitSink*)
+{
+  return false;
+}
+
+std::string IAudioEncoder::settings() const
+{
+  return std::string();
+}
+
 ////// protected /////////////////////////////////////////////////////////////
 
 bool IAudioEncoder::isValidData(const void *data, const std::size_t size) const
@@ -0,0 +1,122 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include "IoThread.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+IoThread::~IoThread() noexcept
+{
+  {
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _quit = true;
+  }
+  _cond.notify_all();
+
+  for(std::thread& thread : _threads) {
+    thread.join();
+  }
+}
+
+IoThread& IoThread::instance()
+{
+  static IoThread instance;
+  return instance;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+IoThread::IoThread() noexcept
+  : _cond()
+  , _mutex()
+  , _quit(false)
+  , _tasks()
+  , _threads()
+{
+  const unsigned int numThreads =
+      std::clamp<unsigned int>(std::thread::hardware_concurrency(), 1, maxThreads);
+
+  try {
+    _threads.reserve(numThreads);
+    for(unsigned int i = 0; i < numThreads; i++) {
+      _threads.emplace_back(&IoThread::run, this);
+    }
+  } catch(...) {
+  }
+}
+
+std::future<bool> IoThread::enqueue(std::packaged_task<bool()>&& task)
+{
+  std::future<bool> result = task.get_future();
+
+  // NOTE: Without a thread, execute task synchronously.
+  if( _threads.empty() ) {
+    task();
+    return result;
+  }
+
+  bool is_queued = false;
+  {
+    const std::lock_guard<std::mutex> lock(_mutex);
+    try {
+      _tasks.push_back(std::move(task));
+      is_queued = true;
+    } catch(...) {
+    }
+  }
+
+  if( !is_queued ) {
+    task();
+    return result;
+  }
+  _cond.notify_one();
+
+  return result;
+}
+
+void IoThread::run()
+{
+  while( true ) {
+    std::packaged_task<bool()> task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cond.wait(lock, [this]() -> bool { return _quit  ||  !_tasks.empty(); });
+      if( _tasks.empty() ) { // NOTE: Finish all pending tasks before quitting!
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+    task();
+  }
+}
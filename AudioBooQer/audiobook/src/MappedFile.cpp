@@ -0,0 +1,182 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifdef _WIN32
+# define NOMINMAX
+# define WIN32_LEAN_AND_MEAN
+# include <Windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+#include "IoThread.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+MappedFile::~MappedFile() noexcept
+{
+  close();
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+  if( _data != nullptr ) {
+    UnmapViewOfFile(_data);
+  }
+  if( _handle != nullptr ) {
+    CloseHandle(_handle);
+  }
+#else
+  if( _data != nullptr ) {
+    munmap(const_cast<uint8_t*>(_data), _size);
+  }
+#endif
+
+  _data   = nullptr;
+  _handle = nullptr;
+  _size   = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+  return _data != nullptr;
+}
+
+bool MappedFile::open(const std::filesystem::path& filename)
+{
+  close();
+
+#ifdef _WIN32
+  const HANDLE file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if( file == INVALID_HANDLE_VALUE ) {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if( !GetFileSizeEx(file, &size)  ||  size.QuadPart < 1 ) {
+    CloseHandle(file);
+    return false;
+  }
+
+  // NOTE: The mapping keeps its own reference to the file!
+  _handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if( _handle == nullptr ) {
+    return false;
+  }
+
+  _data = static_cast<const uint8_t*>(MapViewOfFile(_handle, FILE_MAP_READ, 0, 0, 0));
+  if( _data == nullptr ) {
+    close();
+    return false;
+  }
+  _size = size_type(size.QuadPart);
+#else
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if( fd < 0 ) {
+    return false;
+  }
+
+  struct stat st;
+  if( fstat(fd, &st) != 0  ||  st.st_size < 1 ) {
+    ::close(fd);
+    return false;
+  }
+
+  // NOTE: The mapping keeps its own reference to the file!
+  void *data = mmap(nullptr, size_type(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if( data == MAP_FAILED ) {
+    return false;
+  }
+
+  madvise(data, size_type(st.st_size), MADV_SEQUENTIAL);
+
+  _data = static_cast<const uint8_t*>(data);
+  _size = size_type(st.st_size);
+#endif
+
+  return true;
+}
+
+const uint8_t *MappedFile::data() const
+{
+  return _data;
+}
+
+bool MappedFile::prefetch() const
+{
+  if( !isOpen() ) {
+    return false;
+  }
+
+#ifdef _WIN32
+# if _WIN32_WINNT >= 0x0602
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = const_cast<uint8_t*>(_data);
+  range.NumberOfBytes  = _size;
+  return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0) != FALSE;
+# else
+  return false;
+# endif
+#else
+  return madvise(const_cast<uint8_t*>(_data), _size, MADV_WILLNEED) == 0;
+#endif
+}
+
+MappedFile::size_type MappedFile::size() const
+{
+  return _size;
+}
+
+std::span<const uint8_t> MappedFile::span() const
+{
+  return std::span<const uint8_t>(_data, _size);
+}
+
+void MappedFile::prefetchAsync(const std::filesystem::path& filename)
+{
+  try {
+    // NOTE: Pages read ahead remain in the cache after unmapping.
+    IoThread::instance().submit([filename]() -> bool {
+      MappedFile file;
+      return file.open(filename)  &&  file.prefetch();
+    });
+  } catch(...) {
+  }
+}
@@ -0,0 +1,413 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+
+#include <cs/Logging/OutputContext.h>
+
+#include "Mp4ChapterWriter.h"
+
+#include "AdtsFileSink.h"
+#include "AdtsParser.h"
+#include "IAccessUnitSink.h"
+#include "MappedFile.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+class Mp4ChapterSink : public IAccessUnitSink {
+public:
+  Mp4ChapterSink(Mp4ChapterWriter *writer, const int position,
+                 const std::filesystem::path& spillName) noexcept
+    : position(position)
+    , spill(Mp4ChapterWriter::spillBufferSize)
+    , spillName(spillName)
+    , writer(writer)
+  {
+  }
+
+  ~Mp4ChapterSink() noexcept
+  {
+  }
+
+  bool setAudioSpecificConfig(const uint8_t *asc, const std::size_t size)
+  {
+    return writer->setAudioSpecificConfig(this, asc, size);
+  }
+
+  bool writeAccessUnit(const uint8_t *data, const std::size_t size)
+  {
+    return writer->writeAccessUnit(this, data, size);
+  }
+
+  std::vector<uint8_t>  asc{};
+  bool                  isComplete{false};
+  bool                  isSpilled{false};
+  uint64_t              numAccessUnits{0};
+  const int             position{};
+  AdtsFileSink          spill;
+  std::filesystem::path spillName{};
+  std::u8string         title{};
+  Mp4ChapterWriter     *writer{nullptr};
+};
+
+namespace priv {
+
+  void removeSpillFile(const std::filesystem::path& filename)
+  {
+    std::error_code ec;
+    std::filesystem::remove(filename, ec);
+  }
+
+  std::filesystem::path spillName(const std::filesystem::path& filename, const int position)
+  {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%d.tmp", position);
+    std::filesystem::path result = filename;
+    result += suffix;
+    return result;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+Mp4ChapterWriter::Mp4ChapterWriter(const cs::OutputContext& ctx)
+  : _ctx(ctx)
+{
+}
+
+Mp4ChapterWriter::~Mp4ChapterWriter()
+{
+  discard();
+}
+
+bool Mp4ChapterWriter::close(const std::u8string& language)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if( !_muxer.isOpen() ) {
+    return false;
+  }
+
+  if( !_error  &&  _nextPosition != _endPosition ) {
+    _ctx.logError(u8"Missing chapters in output file \"" + _filename.generic_u8string() + u8"\"!");
+    _error = true;
+  }
+
+  discard();
+
+  return _muxer.close(language, _ctx)  &&  !_error;
+}
+
+bool Mp4ChapterWriter::commit(const int position, const std::u8string& title,
+                              const bool isEncoded)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if( !_muxer.isOpen()  ||  _error ) {
+    return false;
+  }
+
+  Mp4ChapterSink *chapter = this->chapter(position);
+  if( chapter == nullptr  ||  chapter->isComplete ) {
+    _ctx.logError(u8"Invalid chapter position!");
+    return false;
+  }
+
+  // (1) Complete chapter ////////////////////////////////////////////////////
+
+  chapter->isComplete = true;
+
+  if( !isEncoded  ||  chapter->numAccessUnits < 1 ) {
+    _ctx.logError(u8"Empty chapter \"" + title + u8"\"!");
+    _error = true;
+    return false;
+  }
+
+  try {
+    chapter->title = title;
+  } catch(...) {
+    _ctx.logError(u8"std::u8string::operator=() failed!");
+    _error = true;
+    return false;
+  }
+
+  // NOTE: Release the spill file's buffers until the chapter is written.
+  if( chapter->spill.isOpen()  &&  !chapter->spill.close() ) {
+    _ctx.logError(u8"Unable to write file \"" + chapter->spillName.generic_u8string() + u8"\"!");
+    _error = true;
+    return false;
+  }
+
+  // (2) Write all chapters, that are in order ///////////////////////////////
+
+  if( !advance() ) {
+    _error = true;
+    return false;
+  }
+
+  return true;
+}
+
+std::filesystem::path Mp4ChapterWriter::filename() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _filename;
+}
+
+bool Mp4ChapterWriter::open(const std::filesystem::path& filename, const uint32_t timeScale,
+                            const int firstPosition, const int numChapters)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if( _muxer.isOpen()  ||  numChapters < 1 ) {
+    return false;
+  }
+
+  // (1) Create one sink per chapter /////////////////////////////////////////
+
+  _chapters.clear();
+  try {
+    _chapters.reserve(std::size_t(numChapters));
+    for(int i = 0; i < numChapters; i++) {
+      const int position = firstPosition + i;
+      _chapters.push_back(std::make_unique<Mp4ChapterSink>(this, position,
+                                                           priv::spillName(filename, position)));
+    }
+  } catch(...) {
+    _chapters.clear();
+    _ctx.logError(u8"Unable to create chapters!");
+    return false;
+  }
+
+  // (2) Create output file //////////////////////////////////////////////////
+
+  if( !_muxer.open(filename, timeScale, _ctx) ) {
+    _chapters.clear();
+    return false;
+  }
+
+  _asc.clear();
+  _endPosition   = firstPosition + numChapters;
+  _error         = false;
+  _filename      = filename;
+  _firstPosition = firstPosition;
+  _nextPosition  = firstPosition;
+
+  return true;
+}
+
+IAccessUnitSink *Mp4ChapterWriter::sink(const int position) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return chapter(position);
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool Mp4ChapterWriter::advance()
+{
+  while( _nextPosition < _endPosition ) {
+    const Mp4ChapterSink *head = chapter(_nextPosition);
+    if( !head->isComplete ) {
+      break;
+    }
+
+    if( !_muxer.addChapter(head->title) ) {
+      _ctx.logError(u8"Unable to add chapter \"" + head->title + u8"\"!");
+      return false;
+    }
+    _nextPosition++;
+
+    if( _nextPosition < _endPosition  &&  !promote(chapter(_nextPosition)) ) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+Mp4ChapterSink *Mp4ChapterWriter::chapter(const int position) const
+{
+  if( position < _firstPosition  ||  position - _firstPosition >= int(_chapters.size()) ) {
+    return nullptr;
+  }
+  return _chapters[std::size_t(position - _firstPosition)].get();
+}
+
+void Mp4ChapterWriter::discard()
+{
+  for(const ChapterPtr& chapter : _chapters) {
+    if( chapter->isSpilled ) {
+      chapter->spill.close();
+      priv::removeSpillFile(chapter->spillName);
+      chapter->isSpilled = false;
+    }
+  }
+}
+
+bool Mp4ChapterWriter::promote(Mp4ChapterSink *chapter)
+{
+  // NOTE: The chapter did not start, yet; it is written as it arrives.
+  if( chapter->asc.empty() ) {
+    return true;
+  }
+
+  if( !writeConfig(chapter) ) {
+    return false;
+  }
+
+  if( !chapter->isSpilled ) {
+    return true;
+  }
+
+  // (1) Close spill file ////////////////////////////////////////////////////
+
+  if( chapter->spill.isOpen()  &&  !chapter->spill.close() ) {
+    _ctx.logError(u8"Unable to write file \"" + chapter->spillName.generic_u8string() + u8"\"!");
+    return false;
+  }
+
+  // (2) Copy spilled access units to muxer //////////////////////////////////
+
+  uint64_t numAccessUnits = 0;
+  {
+    MappedFile file;
+    if( !file.open(chapter->spillName) ) {
+      _ctx.logError(u8"Unable to open file \"" + chapter->spillName.generic_u8string() + u8"\"!");
+      return false;
+    }
+
+    for(AdtsParser adts(file.span()); adts.hasFrame(); adts.nextFrame()) {
+      if( !_muxer.writeSample(adts.frameData(), adts.frameSize()) ) {
+        _ctx.logError(u8"Unable to write AAC frame!");
+        return false;
+      }
+      numAccessUnits++;
+    }
+  }
+
+  if( numAccessUnits != chapter->numAccessUnits ) {
+    _ctx.logError(u8"Corrupt file \"" + chapter->spillName.generic_u8string() + u8"\"!");
+    return false;
+  }
+
+  // (3) Remove spill file ///////////////////////////////////////////////////
+
+  priv::removeSpillFile(chapter->spillName);
+  chapter->isSpilled = false;
+
+  return true;
+}
+
+bool Mp4ChapterWriter::setAudioSpecificConfig(Mp4ChapterSink *chapter,
+                                              const uint8_t *asc, const std::size_t size)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if( !_muxer.isOpen()  ||  _error  ||  chapter->isComplete  ||  !chapter->asc.empty()  ||
+      asc == nullptr  ||  size < 1 ) {
+    return false;
+  }
+
+  try {
+    chapter->asc.assign(asc, asc + size);
+  } catch(...) {
+    _ctx.logError(u8"std::vector<>::assign() failed!");
+    _error = true;
+    return false;
+  }
+
+  // (1) First incomplete chapter is passed through //////////////////////////
+
+  if( chapter->position == _nextPosition ) {
+    if( !writeConfig(chapter) ) {
+      _error = true;
+      return false;
+    }
+    return true;
+  }
+
+  // (2) Later chapters are spilled //////////////////////////////////////////
+
+  chapter->isSpilled = true;
+  if( !chapter->spill.open(chapter->spillName)  ||
+      !chapter->spill.setAudioSpecificConfig(asc, size) ) {
+    _ctx.logError(u8"Unable to create file \"" + chapter->spillName.generic_u8string() + u8"\"!");
+    _error = true;
+    return false;
+  }
+
+  return true;
+}
+
+bool Mp4ChapterWriter::writeAccessUnit(Mp4ChapterSink *chapter,
+                                       const uint8_t *data, const std::size_t size)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if( !_muxer.isOpen()  ||  _error  ||  chapter->isComplete  ||  chapter->asc.empty() ) {
+    return false;
+  }
+
+  const bool is_written = chapter->position == _nextPosition
+      ? _muxer.writeSample(data, size)
+      : chapter->spill.writeAccessUnit(data, size);
+  if( !is_written ) {
+    _ctx.logError(u8"Unable to write AAC frame!");
+    _error = true;
+    return false;
+  }
+
+  chapter->numAccessUnits++;
+
+  return true;
+}
+
+bool Mp4ChapterWriter::writeConfig(const Mp4ChapterSink *chapter)
+{
+  if( _asc.empty() ) {
+    if( !_muxer.setAudioSpecificConfig(chapter->asc.data(), chapter->asc.size(), _ctx) ) {
+      return false;
+    }
+    try {
+      _asc = chapter->asc;
+    } catch(...) {
+      _ctx.logError(u8"std::vector<>::operator=() failed!");
+      return false;
+    }
+  } else if( chapter->asc != _asc ) {
+    _ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+    return false;
+  }
+
+  return true;
+}
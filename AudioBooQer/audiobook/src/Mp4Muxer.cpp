@@ -0,0 +1,410 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <future>
+#include <numeric>
+
+#include <mp4v2/mp4v2.h>
+
+#include <cs/Logging/OutputContext.h>
+#include <cs/Text/StringUtil.h>
+
+#include "Mp4Muxer.h"
+
+#include "AccessUnitBuffer.h"
+#include "IoThread.h"
+#include "Mpeg4Audio.h"
+
+////// Asserts ///////////////////////////////////////////////////////////////
+
+static_assert(mpeg4::numSamplesPerAacFrame == 1024);
+
+////// Implementation ////////////////////////////////////////////////////////
+
+/*
+ * NOTE:
+ * Access units are collected in batches; a full batch is written by the
+ * IoThread, while the next one is being collected. Thus, at most two batches
+ * are in use and mp4v2 is only ever accessed by one thread at a time.
+ * Each batch is written by a single MP4WriteSamples() call, which fills the
+ * sample tables in one step and writes complete chunks as one block.
+ */
+
+inline constexpr std::size_t numBatchAccessUnits = 1024;
+
+class Mp4MuxerImpl : public IAccessUnitSink {
+public:
+  Mp4MuxerImpl() = default;
+  ~Mp4MuxerImpl();
+
+  bool launch();
+  bool submit();
+  bool wait();
+
+  bool setAudioSpecificConfig(const uint8_t *asc, const std::size_t size);
+  bool writeAccessUnit(const uint8_t *data, const std::size_t size);
+  bool writeAccessUnits(const uint8_t *data, const uint32_t *sizes,
+                        const std::size_t count);
+
+  MP4TrackId               auTrackId{MP4_INVALID_TRACK_ID};
+  AccessUnitBuffer         batch;
+  std::vector<std::string> chapterTitles;
+  std::vector<uint64_t>    durations;
+  MP4FileHandle            file{MP4_INVALID_FILE_HANDLE};
+  AccessUnitBuffer         inFlight;
+  uint64_t                 numChapterSamples{};
+  std::future<bool>        pending;
+  MP4Duration              sampleDuration{mpeg4::numSamplesPerAacFrame};
+  uint32_t                 timeScale{};
+};
+
+Mp4MuxerImpl::~Mp4MuxerImpl()
+{
+  wait();
+}
+
+bool Mp4MuxerImpl::launch()
+{
+  try {
+    pending = IoThread::instance().submit([this]() -> bool {
+      return inFlight.writeTo(this);
+    });
+  } catch(...) {
+    return false;
+  }
+  return true;
+}
+
+bool Mp4MuxerImpl::submit()
+{
+  if( batch.isEmpty() ) {
+    return true;
+  }
+
+  if( !wait() ) {
+    return false;
+  }
+
+  inFlight = std::move(batch);
+  batch.clear();
+
+  return launch();
+}
+
+bool Mp4MuxerImpl::wait()
+{
+  if( !pending.valid() ) {
+    return true;
+  }
+  return pending.get();
+}
+
+bool Mp4MuxerImpl::setAudioSpecificConfig(const uint8_t *asc, const std::size_t size)
+{
+  // (1) Derive sample duration; SBR doubles it //////////////////////////////
+
+  mpeg4::AudioSpecificConfig config;
+  if( !mpeg4::parseAudioSpecificConfig(&config, asc, size)  ||
+      config.outputSamplingFrequency() == 0 ) {
+    return false;
+  }
+
+  const MP4Duration duration =
+      MP4Duration(config.numSamplesPerFrame())*MP4Duration(timeScale)/
+      MP4Duration(config.outputSamplingFrequency());
+  if( duration < 1 ) {
+    return false;
+  }
+
+  // (2) Write AudioSpecificConfig ///////////////////////////////////////////
+
+  if( !MP4SetTrackESConfiguration(file, auTrackId, asc, uint32_t(size)) ) {
+    return false;
+  }
+  sampleDuration = duration;
+
+  return true;
+}
+
+bool Mp4MuxerImpl::writeAccessUnit(const uint8_t *data, const std::size_t size)
+{
+  return MP4WriteSample(file, auTrackId, data, uint32_t(size), sampleDuration);
+}
+
+bool Mp4MuxerImpl::writeAccessUnits(const uint8_t *data, const uint32_t *sizes,
+                                    const std::size_t count)
+{
+  if( count > std::size_t(UINT32_MAX) ) {
+    return false;
+  }
+  return MP4WriteSamples(file, auTrackId, data, sizes, uint32_t(count), sampleDuration);
+}
+
+////// public ////////////////////////////////////////////////////////////////
+
+Mp4Muxer::Mp4Muxer()
+  : impl()
+{
+}
+
+Mp4Muxer::~Mp4Muxer()
+{
+  if( isOpen() ) {
+    impl->wait();
+    MP4Close(impl->file);
+  }
+}
+
+bool Mp4Muxer::isOpen() const
+{
+  return impl  &&  impl->file != MP4_INVALID_FILE_HANDLE;
+}
+
+bool Mp4Muxer::close(const std::u8string& language, const cs::OutputContext& ctx)
+{
+  if( !isOpen() ) {
+    return false;
+  }
+
+  // (1) Write remaining samples /////////////////////////////////////////////
+
+  const bool is_written = impl->submit()  &&  impl->wait();
+
+  const MP4FileHandle file = impl->file;
+  impl->file = MP4_INVALID_FILE_HANDLE;
+
+  if( !is_written ) {
+    ctx.logError(u8"Unable to write AAC frame!");
+    MP4Close(file);
+    return false;
+  }
+
+  // (1.1) Samples written after the last chapter mark ///////////////////////
+
+  if( impl->numChapterSamples > 0 ) {
+    ctx.logError(u8"Samples without chapter detected!");
+    MP4Close(file);
+    return false;
+  }
+
+  if( impl->durations.empty() ) {
+    ctx.logError(u8"No chapters written!");
+    MP4Close(file);
+    return false;
+  }
+
+  // (2) Set timing information for file /////////////////////////////////////
+
+  MP4SetDuration(file, std::accumulate(impl->durations.begin(), impl->durations.end(), MP4Duration{0}));
+
+  // (3) Creater chapter track ///////////////////////////////////////////////
+
+  const MP4TrackId chTrackId =
+      MP4AddChapterTextTrack(file, impl->auTrackId);
+  if( chTrackId == MP4_INVALID_TRACK_ID ) {
+    ctx.logError(u8"Unable to create chapter track!");
+    MP4Close(file);
+    return false;
+  }
+
+  // (3.1) Set track's flags /////////////////////////////////////////////////
+
+  /*
+   * Flags (tkhd.flags), cf. ISO 14496-12 "8.3.2 Track Header Box":
+   *
+   * 0x1: Track_enabled
+   * 0x2: Track_in_movie
+   * 0x4: Track_in_preview
+   * 0x8: Track_size_is_aspect_ratio
+   */
+  if( !MP4SetTrackIntegerProperty(file, chTrackId, "tkhd.flags", 0xF) ) {
+    ctx.logError(u8"Unable to set chapter flags!");
+    MP4Close(file);
+    return false;
+  }
+
+  // (3.2) Set track's language //////////////////////////////////////////////
+
+  if( language.size() == 3 ) { // cf. ISO 639-2/T
+    if( !MP4SetTrackLanguage(file, chTrackId, cs::CSTR(language)) ) {
+      ctx.logError(u8"Unable to set chapter language!");
+      MP4Close(file);
+      return false;
+    }
+  }
+
+  // (4) Create chapters /////////////////////////////////////////////////////
+
+  for(std::size_t i = 0; i < impl->durations.size(); i++) {
+    MP4AddChapter(file, chTrackId, impl->durations[i], impl->chapterTitles[i].data());
+  }
+
+  // Done! ///////////////////////////////////////////////////////////////////
+
+  MP4Close(file);
+
+  return true;
+}
+
+bool Mp4Muxer::open(const std::filesystem::path& filename, const uint32_t timeScale,
+                    const cs::OutputContext& ctx)
+{
+  // (0) Sanity check ////////////////////////////////////////////////////////
+
+  if( isOpen() ) {
+    return false;
+  }
+
+  if( timeScale == 0 ) {
+    ctx.logError(u8"Invalid time scale!");
+    return false;
+  }
+
+  std::unique_ptr<Mp4MuxerImpl> result = std::make_unique<Mp4MuxerImpl>();
+  result->timeScale = timeScale;
+
+  // (1) Create MP4 file /////////////////////////////////////////////////////
+
+  const char *brand0 = "M4B ";
+  const char *brand1 = "isom";
+  const char *brand2 = "mp42"; // required for a valid MP4 file, cf. ISO 14496-14 "4 File Identification"
+  const char *brands[] = { brand0, brand1, brand2 };
+  char **compBrands = const_cast<char**>(brands);
+
+  result->file =
+      MP4CreateEx(cs::CSTR(filename.generic_u8string()), 0, 1, 0, compBrands[0], 0, compBrands, 3);
+  if( result->file == MP4_INVALID_FILE_HANDLE ) {
+    ctx.logError(u8"Unable to create output file \"" + filename.generic_u8string() + u8"\"!");
+    return false;
+  }
+
+  // (2) Set timing information for file /////////////////////////////////////
+
+  MP4SetTimeScale(result->file, timeScale);
+
+  // (3) Create audio track //////////////////////////////////////////////////
+
+  result->auTrackId =
+      MP4AddAudioTrack(result->file, timeScale, mpeg4::numSamplesPerAacFrame, MP4_MPEG4_AUDIO_TYPE);
+  if( result->auTrackId == MP4_INVALID_TRACK_ID ) {
+    ctx.logError(u8"Unable to create audio track!");
+    MP4Close(result->file);
+    return false;
+  }
+
+  // (3.1) Set track's flags /////////////////////////////////////////////////
+
+  /*
+   * Flags (tkhd.flags), cf. ISO 14496-12 "8.3.2 Track Header Box":
+   *
+   * 0x1: Track_enabled
+   * 0x2: Track_in_movie
+   * 0x4: Track_in_preview
+   * 0x8: Track_size_is_aspect_ratio
+   */
+  if( !MP4SetTrackIntegerProperty(result->file, result->auTrackId, "tkhd.flags", 0xF) ) {
+    ctx.logError(u8"Unable to set audio flags!");
+    MP4Close(result->file);
+    return false;
+  }
+
+  // Done! ///////////////////////////////////////////////////////////////////
+
+  impl = std::move(result);
+
+  return true;
+}
+
+bool Mp4Muxer::addChapter(const std::u8string& title)
+{
+  if( !isOpen()  ||  impl->numChapterSamples < 1 ) {
+    return false;
+  }
+
+  try {
+    impl->chapterTitles.emplace_back(cs::CSTR(title));
+    impl->durations.push_back(impl->numChapterSamples*uint64_t(impl->sampleDuration));
+  } catch(...) {
+    return false;
+  }
+
+  impl->numChapterSamples = 0;
+
+  return true;
+}
+
+const std::vector<uint64_t>& Mp4Muxer::chapterDurations() const
+{
+  static const std::vector<uint64_t> empty;
+  return impl
+      ? impl->durations
+      : empty;
+}
+
+bool Mp4Muxer::setAudioSpecificConfig(const uint8_t *asc, const std::size_t size,
+                                      const cs::OutputContext& ctx)
+{
+  if( !isOpen() ) {
+    return false;
+  }
+
+  if( !impl->wait()  ||  !impl->setAudioSpecificConfig(asc, size) ) {
+    ctx.logError(u8"Unable to write AudioSpecificConfig!");
+    return false;
+  }
+
+  return true;
+}
+
+uint32_t Mp4Muxer::timeScale() const
+{
+  return impl
+      ? impl->timeScale
+      : 0;
+}
+
+bool Mp4Muxer::writeSample(const uint8_t *data, const std::size_t size)
+{
+  if( !isOpen() ) {
+    return false;
+  }
+
+  if( !impl->batch.writeAccessUnit(data, size) ) {
+    return false;
+  }
+  impl->numChapterSamples++;
+
+  if( impl->batch.numAccessUnits() >= numBatchAccessUnits ) {
+    return impl->submit();
+  }
+
+  return true;
+}
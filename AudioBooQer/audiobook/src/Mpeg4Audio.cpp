@@ -49,6 +49,97 @@ namespace mpeg4 {
 #define ASC_SHIFT_CHANNELS    3
 #define ASC_SHIFT_FREQUENCY   7
 
+#define ASC_ESCAPE_AOT       31
+#define ASC_ESCAPE_FREQUENCY 15
+
+#define ASC_SYNC_PS       0x548
+#define ASC_SYNC_SBR      0x2B7
+
+  ////// Private /////////////////////////////////////////////////////////////
+
+  namespace priv {
+
+    class BitReader {
+    public:
+      BitReader(const uint8_t *data, const std::size_t size) noexcept
+        : _data(data)
+        , _numBits(data != nullptr ? size*8 : 0)
+        , _position(0)
+      {
+      }
+
+      ~BitReader() noexcept = default;
+
+      bool read(uint32_t *value, const std::size_t numBits)
+      {
+        if( numBits > 32  ||  numBits > remain() ) {
+          return false;
+        }
+        uint32_t result = 0;
+        for(std::size_t i = 0; i < numBits; i++, _position++) {
+          result <<= 1;
+          result  |= (_data[_position/8] >> (7 - _position%8)) & 1;
+        }
+        *value = result;
+        return true;
+      }
+
+      std::size_t remain() const
+      {
+        return _numBits - _position;
+      }
+
+    private:
+      const uint8_t *_data{nullptr};
+      std::size_t    _numBits{};
+      std::size_t    _position{};
+    };
+
+    bool readAudioObjectType(BitReader& bits, uint16_t *aot)
+    {
+      uint32_t value = 0;
+      if( !bits.read(&value, 5) ) {
+        return false;
+      }
+      if( value == ASC_ESCAPE_AOT ) {
+        uint32_t escape = 0;
+        if( !bits.read(&escape, 6) ) {
+          return false;
+        }
+        value = 32 + escape;
+      }
+      *aot = static_cast<uint16_t>(value);
+      return true;
+    }
+
+    bool readSamplingFrequency(BitReader& bits, uint32_t *freq)
+    {
+      uint32_t index = 0;
+      if( !bits.read(&index, 4) ) {
+        return false;
+      }
+      if( index == ASC_ESCAPE_FREQUENCY ) {
+        return bits.read(freq, 24)  &&  *freq > 0;
+      }
+      if( index >= ASC_RSVD_FREQUENCY ) {
+        return false;
+      }
+      *freq = SamplingFrequencyData[index];
+      return true;
+    }
+
+    uint16_t samplingFrequencyIndex(const uint32_t freq)
+    {
+      for(std::size_t i = 0; i < ASC_RSVD_FREQUENCY; i++) {
+        if( freq == SamplingFrequencyData[i] ) {
+          return static_cast<uint16_t>(i);
+        }
+      }
+      return ASC_RSVD_FREQUENCY;
+    }
+
+  } // namespace priv
+
   ////// Public //////////////////////////////////////////////////////////////
 
   const std::array<uint32_t,16> SamplingFrequencyData{
@@ -72,6 +163,111 @@ namespace mpeg4 {
     }
   };
 
+  bool AudioSpecificConfig::isSbr() const
+  {
+    return
+        extensionObjectType == uint16_t(AudioObjectType::SBR)  ||
+        extensionObjectType == uint16_t(AudioObjectType::PS);
+  }
+
+  uint32_t AudioSpecificConfig::numSamplesPerFrame() const
+  {
+    if( !isSbr()  ||  samplingFrequency == 0 ) {
+      return numCoreSamplesPerFrame;
+    }
+    return static_cast<uint32_t>(uint64_t(numCoreSamplesPerFrame)*uint64_t(outputSamplingFrequency())/
+                                 uint64_t(samplingFrequency));
+  }
+
+  uint32_t AudioSpecificConfig::outputSamplingFrequency() const
+  {
+    return isSbr()  &&  extensionSamplingFrequency > 0
+        ? extensionSamplingFrequency
+        : samplingFrequency;
+  }
+
+  bool parseAudioSpecificConfig(AudioSpecificConfig *config,
+                                const uint8_t *data, const std::size_t size)
+  {
+    if( config == nullptr ) {
+      return false;
+    }
+
+    priv::BitReader bits(data, size);
+    AudioSpecificConfig result;
+    uint32_t value = 0;
+
+    // (1) Audio Object Type, Sampling Frequency & Channel Configuration /////
+
+    uint16_t aot = 0;
+    if( !priv::readAudioObjectType(bits, &aot)                       ||
+        !priv::readSamplingFrequency(bits, &result.samplingFrequency) ||
+        !bits.read(&value, 4) ) {
+      return false;
+    }
+    result.channelConfiguration = static_cast<uint16_t>(value);
+
+    // (2) Explicit hierarchical signaling of SBR/PS /////////////////////////
+
+    if( aot == uint16_t(AudioObjectType::SBR)  ||  aot == uint16_t(AudioObjectType::PS) ) {
+      result.extensionObjectType = aot;
+      if( !priv::readSamplingFrequency(bits, &result.extensionSamplingFrequency)  ||
+          !priv::readAudioObjectType(bits, &aot) ) {
+        return false;
+      }
+    }
+    result.audioObjectType = aot;
+
+    // (3) GASpecificConfig; AAC cores with a Channel Configuration only /////
+
+    if( aot < 1  ||  aot >= ASC_RSVD_AOT  ||
+        result.channelConfiguration < 1  ||  result.channelConfiguration >= ASC_RSVD_CHANNELS ) {
+      return false;
+    }
+
+    if( !bits.read(&value, 1) ) { // frameLengthFlag
+      return false;
+    }
+    result.numCoreSamplesPerFrame = value != 0
+        ? 960
+        : numSamplesPerAacFrame;
+
+    if( !bits.read(&value, 1) ) { // dependsOnCoreCoder
+      return false;
+    }
+    if( value != 0  &&  !bits.read(&value, 14) ) { // coreCoderDelay
+      return false;
+    }
+
+    if( !bits.read(&value, 1) ) { // extensionFlag
+      return false;
+    }
+
+    // (4) Explicit backward compatible signaling of SBR/PS //////////////////
+
+    if( result.extensionObjectType == uint16_t(AudioObjectType::Null)  &&
+        bits.remain() >= 16  &&  bits.read(&value, 11)  &&  value == ASC_SYNC_SBR ) {
+      uint16_t extensionAot = 0;
+      if( priv::readAudioObjectType(bits, &extensionAot)  &&
+          extensionAot == uint16_t(AudioObjectType::SBR)  &&
+          bits.read(&value, 1)  &&  value != 0 ) { // sbrPresentFlag
+        if( !priv::readSamplingFrequency(bits, &result.extensionSamplingFrequency) ) {
+          return false;
+        }
+        result.extensionObjectType = extensionAot;
+
+        if( bits.remain() >= 12  &&  bits.read(&value, 11)  &&  value == ASC_SYNC_PS  &&
+            bits.read(&value, 1)  &&  value != 0 ) { // psPresentFlag
+          result.extensionObjectType = uint16_t(AudioObjectType::PS);
+        }
+      }
+    }
+
+    *config = result;
+
+    return true;
+  }
+
   uint16_t createAudioSpecificConfig(const uint16_t aot, const uint16_t channels, const uint32_t freq)
   {
     // Limit type to AAC and limit channels to defined range!
@@ -101,6 +297,72 @@ namespace mpeg4 {
     return cs::toBigEndian(asc);
   }
 
+  std::array<uint8_t,numExplicitSbrConfigBytes> createExplicitSbrConfig(const uint16_t asc,
+                                                                      const uint16_t extensionAot)
+  {
+    std::array<uint8_t,numExplicitSbrConfigBytes> config{};
+
+    const uint16_t      aot = audioObjectTypeFromASC(asc);
+    const uint16_t    index = samplingFrequencyIndexFromASC(asc);
+    const uint16_t channels = channelConfigurationFromASC(asc);
+
+    if( extensionAot != uint16_t(AudioObjectType::SBR)  &&
+        extensionAot != uint16_t(AudioObjectType::PS) ) {
+      return config;
+    }
+
+    if( aot < 1  ||  aot >= ASC_RSVD_AOT  ||  index >= ASC_RSVD_FREQUENCY  ||
+        channels < 1  ||  channels >= ASC_RSVD_CHANNELS ) {
+      return config;
+    }
+
+    const uint16_t extensionIndex = priv::samplingFrequencyIndex(2*SamplingFrequencyData[index]);
+    if( extensionIndex >= ASC_RSVD_FREQUENCY ) {
+      return config;
+    }
+
+    // NOTE: 5+4+4+4+5 bits, followed by an all-zero GASpecificConfig (3 bits).
+    uint32_t bits = 0;
+    bits |= uint32_t(extensionAot)   << 27;
+    bits |= uint32_t(index)          << 23;
+    bits |= uint32_t(channels)       << 19;
+    bits |= uint32_t(extensionIndex) << 15;
+    bits |= uint32_t(aot)            << 10;
+
+    config[0] = uint8_t(bits >> 24);
+    config[1] = uint8_t(bits >> 16);
+    config[2] = uint8_t(bits >>  8);
+    config[3] = uint8_t(bits);
+
+    return config;
+  }
+
+  std::array<uint8_t,numAdtsHeaderBytes> createAdtsHeader(const uint16_t asc, const std::size_t frameSize)
+  {
+    std::array<uint8_t,numAdtsHeaderBytes> header{};
+
+    const uint16_t      aot = audioObjectTypeFromASC(asc);
+    const uint16_t    index = samplingFrequencyIndexFromASC(asc);
+    const uint16_t channels = channelConfigurationFromASC(asc);
+    const std::size_t length = frameSize + numAdtsHeaderBytes;
+
+    // ADTS can only signal AOTs 1-4 and frames of up to 13bits!
+    if( aot < 1  ||  aot >= ASC_RSVD_AOT  ||  index >= ASC_RSVD_FREQUENCY  ||
+        channels >= ASC_RSVD_CHANNELS  ||  frameSize < 1  ||  length > 0x1FFF ) {
+      return header;
+    }
+
+    header[0] = 0xFF;                                   // Sync
+    header[1] = 0xF1;                                   // Sync, MPEG-4, No CRC
+    header[2] = uint8_t(((aot - 1) << 6) | (index << 2) | (channels >> 2));
+    header[3] = uint8_t(((channels & 0x3) << 6) | (length >> 11));
+    header[4] = uint8_t(length >> 3);
+    header[5] = uint8_t(((length & 0x7) << 5) | 0x1F); // Buffer fullness: VBR
+    header[6] = 0xFC;                                   // One raw data block
+
+    return header;
+  }
+
   uint16_t audioObjectTypeFromASC(const uint16_t asc)
   {
     return (cs::fromBigEndian(asc) >> ASC_SHIFT_AOT) & ASC_MASK_AOT;
@@ -125,4 +387,10 @@ namespace mpeg4 {
     return SamplingFrequencyData[index];
   }
 
+  uint16_t coreAscFromConfig(const AudioSpecificConfig& config)
+  {
+    return createAudioSpecificConfig(config.audioObjectType, config.channelConfiguration,
+                                     config.samplingFrequency);
+  }
+
 } // namespace mpeg4
@@ -29,24 +29,30 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <array>
 #include <chrono>
-#include <numeric>
+#include <memory>
+#include <span>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include <mp4v2/mp4v2.h>
 
-#include <cs/IO/File.h>
+#include <cs/Logging/ILogger.h>
 #include <cs/Logging/OutputContext.h>
 #include <cs/Text/StringUtil.h>
 
 #include "Output.h"
 
+#include "AdtsIndex.h"
 #include "AdtsParser.h"
+#include "AdtsReader.h"
+#include "FileUtil.h"
+#include "MappedFile.h"
+#include "Mp4Muxer.h"
 #include "Mpeg4Audio.h"
-
-////// Asserts ///////////////////////////////////////////////////////////////
-
-static_assert(mpeg4::numSamplesPerAacFrame == 1024);
+#include "TaskScheduler.h"
 
 ////// Types /////////////////////////////////////////////////////////////////
 
@@ -56,78 +62,228 @@ using Durations = std::vector<MP4Duration>;
 
 namespace priv {
 
-  MP4Duration adtsFrameCount(const std::filesystem::path& filename, uint16_t *globalAsc,
-                             const cs::OutputContext& ctx)
-  {
-    ctx.logText(u8"Reading ADTS file \"" + filename.generic_u8string() + u8"\".");
+  /*
+   * NOTE:
+   * BufferedLogger holds the messages of one task, which are replayed later;
+   * thus, concurrent tasks' messages are logged in a deterministic order.
+   */
+  class BufferedLogger : public cs::ILogger {
+  public:
+    BufferedLogger() noexcept = default;
+    ~BufferedLogger() noexcept = default;
 
-    // (1) Read ADTS file ////////////////////////////////////////////////////
+    void logText(const std::u8string& msg) const override
+    {
+      append(Text, msg);
+    }
 
-    cs::File file;
-    file.open(filename);
-    cs::Buffer buffer = file.readAll();
-    if( buffer.empty() ) {
-      ctx.logError(u8"Unable to read ADTS file \"" + filename.generic_u8string() + u8"\"!");
-      return 0;
+    void logWarning(const std::u8string& msg) const override
+    {
+      append(Warning, msg);
     }
 
-    AdtsParser adts(std::move(buffer));
+    void logError(const std::u8string& msg) const override
+    {
+      append(Error, msg);
+    }
 
-    // (2) Initialize reference ASC //////////////////////////////////////////
+    void replay(const cs::OutputContext& ctx) const
+    {
+      for(const Message& message : _messages) {
+        if(        message.first == Text ) {
+          ctx.logText(message.second);
+        } else if( message.first == Warning ) {
+          ctx.logWarning(message.second);
+        } else {
+          ctx.logError(message.second);
+        }
+      }
+    }
 
-    uint16_t refAsc = globalAsc != nullptr  &&  *globalAsc != 0
-        ? *globalAsc
-        : 0;
+  private:
+    enum Level : unsigned int {
+      Text = 0,
+      Warning,
+      Error
+    };
 
-    // (3) Count & validate frames ///////////////////////////////////////////
+    using Message = std::pair<Level,std::u8string>;
 
-    MP4Duration count{0};
-    while( adts.hasFrame() ) {
-      const uint16_t asc = adts.mpeg4AudioSpecificConfig();
+    void append(const Level level, const std::u8string& msg) const
+    {
+      try {
+        _messages.emplace_back(level, msg);
+      } catch(...) {
+      }
+    }
 
-      // (3.1) Set new reference /////////////////////////////////////////////
+    mutable std::vector<Message> _messages;
+  };
 
-      if( refAsc == 0 ) {
-        refAsc = asc;
-      }
+  struct ChapterValidation {
+    ChapterValidation() noexcept = default;
 
-      // (3.2) Count /////////////////////////////////////////////////////////
+    uint16_t       asc{0};
+    BufferedLogger logger;
+    MP4Duration    numFrames{0};
+  };
 
-      count++;
+  void logSkipped(const uint64_t offset, const uint64_t numSkipped,
+                  const std::filesystem::path& filename, const cs::OutputContext& ctx)
+  {
+    std::ostringstream output;
+    output << "Skipped " << numSkipped << " bytes at offset " << offset;
+    ctx.logWarning(cs::toUtf8String(output.str()) +
+                   u8" of ADTS file \"" + filename.generic_u8string() + u8"\"!");
+  }
 
-      // (3.3) Validate //////////////////////////////////////////////////////
+  /*
+   * NOTE:
+   * Corrupted data is skipped up to the next valid frame; each skipped range
+   * of bytes is reported as a warning.
+   */
+  template<typename ParserT>
+  bool resync(ParserT& adts, const std::filesystem::path& filename, const cs::OutputContext& ctx)
+  {
+    const uint64_t offset = adts.offset();
 
-      if( adts.aacFrameCount() != 1 ) {
-        ctx.logError(u8"Invalid AAC frame count detected!");
-        return 0;
-      }
+    AdtsParser::size_type numSkipped{0};
+    const bool result = adts.resync(&numSkipped);
 
-      if( refAsc == 0  ||  asc != refAsc ) {
-        ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+    if( numSkipped > 0 ) {
+      logSkipped(offset, numSkipped, filename, ctx);
+    }
+
+    return result;
+  }
+
+  /*
+   * NOTE:
+   * The frames are counted and validated by an AdtsIndex, which is loaded
+   * from its sidecar, if it is up to date; otherwise, the ADTS file is
+   * scanned once and the sidecar is (re)written.
+   */
+  MP4Duration adtsFrameCount(const std::filesystem::path& filename, uint16_t *globalAsc,
+                             const cs::OutputContext& ctx)
+  {
+    ctx.logText(u8"Reading ADTS file \"" + filename.generic_u8string() + u8"\".");
+
+    // (1) Load or build index ///////////////////////////////////////////////
+
+    AdtsIndex index;
+    if( !index.load(filename, false) ) {
+      if( !index.build(filename, ctx) ) {
         return 0;
       }
 
-      // (3.4) Next //////////////////////////////////////////////////////////
+      // NOTE: The sidecar is optional, e.g. in a read-only directory.
+      index.save(filename);
+    }
+
+    for(const AdtsIndex::Range& range : index.skippedRanges()) {
+      logSkipped(range.first, range.second, filename, ctx);
+    }
+
+    // (2) Validate against global ASC reference /////////////////////////////
 
-      adts.nextFrame();
+    const uint16_t asc = index.audioSpecificConfig();
+    if( globalAsc != nullptr  &&  *globalAsc != 0  &&  asc != *globalAsc ) {
+      ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+      return 0;
     }
 
-    // (4) Update global ASC reference ///////////////////////////////////////
+    // (3) Update global ASC reference ///////////////////////////////////////
 
     if( globalAsc != nullptr  &&  *globalAsc == 0 ) {
-      *globalAsc = refAsc;
+      *globalAsc = asc;
     }
 
     // Done! /////////////////////////////////////////////////////////////////
 
-    return count;
+    return MP4Duration(index.numFrames());
+  }
+
+  void validateChapter(ChapterValidation *validation, const std::filesystem::path& filename)
+  {
+    const cs::OutputContext ctx(&validation->logger, true, nullptr, false);
+    validation->numFrames = adtsFrameCount(filename, &validation->asc, ctx);
   }
 
-  std::u8string formatAsc(const uint16_t asc)
+  /*
+   * NOTE:
+   * Each chapter is an independent read & parse; thus, all chapters are
+   * validated concurrently. The TaskScheduler's destructor waits for all
+   * validations to complete.
+   */
+  void validateChapters(ChapterValidation *validations, const BookBinder& binder)
+  {
+    TaskScheduler scheduler;
+
+    for(std::size_t i = 0; const BookBinderChapter& chapter : binder) {
+      ChapterValidation *validation = &validations[i++];
+      const std::filesystem::path& filename = chapter.second;
+
+      // NOTE: Validate synchronously, if the task cannot be queued.
+      if( !scheduler.submit([validation, &filename]() -> void {
+                              validateChapter(validation, filename);
+                            }) ) {
+        validateChapter(validation, filename);
+      }
+    }
+  }
+
+  /*
+   * NOTE:
+   * Chapters are validated concurrently, but merged in order: The first
+   * chapter's ASC is the reference, and messages are logged in order.
+   */
+  bool validateBinder(Durations *durations, uint16_t *refAsc,
+                      const BookBinder& binder, const cs::OutputContext& ctx)
+  {
+    std::unique_ptr<ChapterValidation[]> validations;
+    try {
+      durations->resize(std::size_t(binder.size()));
+      validations = std::make_unique<ChapterValidation[]>(binder.size());
+    } catch(...) {
+      ctx.logError(u8"std::vector<>::resize() failed!");
+      return false;
+    }
+
+    validateChapters(validations.get(), binder);
+
+    *refAsc = 0;
+    for(std::size_t i = 0; i < binder.size(); i++) {
+      const ChapterValidation& validation = validations[i];
+
+      validation.logger.replay(ctx);
+
+      (*durations)[i] = validation.numFrames;
+      if( (*durations)[i] == 0 ) {
+        return false;
+      }
+
+      if( *refAsc == 0 ) {
+        *refAsc = validation.asc;
+      }
+
+      if( *refAsc == 0  ||  validation.asc != *refAsc ) {
+        ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+        return false;
+      }
+
+      ctx.setProgressValue(int(i));
+    }
+
+    return true;
+  }
+
+  std::u8string formatAsc(const mpeg4::AudioSpecificConfig& config)
   {
     std::ostringstream output;
 
-    const uint16_t aot = mpeg4::audioObjectTypeFromASC(asc);
+    const uint16_t aot = config.extensionObjectType != 0
+        ? config.extensionObjectType
+        : config.audioObjectType;
     {
       if(        aot == 0 ) {
         output << "Null";
@@ -139,19 +295,26 @@ namespace priv {
         output << "AAC SSR";
       } else if( aot == 4 ) {
         output << "AAC LTP";
+      } else if( aot == 5 ) {
+        output << "HE-AAC";
+      } else if( aot == 29 ) {
+        output << "HE-AACv2";
       } else {
         output << "???";
       }
     }
     output << ", ";
 
-    const uint32_t freq = mpeg4::samplingFrequencyFromASC(asc);
+    const uint32_t freq = config.outputSamplingFrequency();
     {
       output << freq << "Hz";
     }
     output << ", ";
 
-    const uint16_t ch = mpeg4::channelConfigurationFromASC(asc);
+    // NOTE: PS encodes Stereo as a Mono core!
+    const uint16_t ch = config.extensionObjectType == uint16_t(mpeg4::AudioObjectType::PS)
+        ? 2
+        : config.channelConfiguration;
     {
       if(        ch == 1 ) {
         output << "Mono";
@@ -165,6 +328,37 @@ namespace priv {
     return cs::toUtf8String(output.str());
   }
 
+  /*
+   * NOTE:
+   * ADTS signals SBR/PS implicitly, i.e. 'asc' describes the AAC core only;
+   * the audio track is given an explicit AudioSpecificConfig instead.
+   */
+  bool trackConfig(std::vector<uint8_t> *data, mpeg4::AudioSpecificConfig *config,
+                   const uint16_t asc, const AacProfile profile, const cs::OutputContext& ctx)
+  {
+    try {
+      if( profile == AacProfile::AAC_LC ) {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t*>(&asc);
+        data->assign(bytes, bytes + sizeof(uint16_t));
+      } else {
+        const std::array<uint8_t,mpeg4::numExplicitSbrConfigBytes> explicitConfig =
+            mpeg4::createExplicitSbrConfig(asc, uint16_t(profile));
+        data->assign(explicitConfig.begin(), explicitConfig.end());
+      }
+    } catch(...) {
+      ctx.logError(u8"std::vector<>::assign() failed!");
+      return false;
+    }
+
+    if( !mpeg4::parseAudioSpecificConfig(config, data->data(), data->size())  ||
+        config->outputSamplingFrequency() == 0 ) {
+      ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+      return false;
+    }
+
+    return true;
+  }
+
   void printBinder(const BookBinder& binder,
                    const Durations& durations, const uint32_t timeScale,
                    const cs::OutputContext& ctx)
@@ -193,158 +387,242 @@ namespace priv {
     }
   }
 
-  bool writeAdtsSample(MP4FileHandle file, const MP4TrackId trackId,
-                       const std::filesystem::path& filename, const cs::OutputContext& ctx)
+  /*
+   * NOTE:
+   * The number of frames is known from validation; the frames are located
+   * by the AdtsIndex' frame table, i.e. the ADTS file is not scanned again.
+   * The muxer collects the access units in batches, which are written to
+   * the MP4 file in bulk.
+   */
+  bool writeAdtsSample(Mp4Muxer& muxer,
+                       const std::filesystem::path& filename, const MP4Duration numFrames,
+                       const cs::OutputContext& ctx)
   {
     ctx.logText(u8"Writing ADTS file \"" + filename.generic_u8string() + u8"\".");
 
-    // (1) Read ADTS file ////////////////////////////////////////////////////
+    // (1) Load or build index ///////////////////////////////////////////////
 
-    cs::File sampleFile;
-    sampleFile.open(filename);
-    cs::Buffer buffer = sampleFile.readAll();
-    if( buffer.empty() ) {
+    // NOTE: The sidecar was (re)written by adtsFrameCount(), if possible.
+    AdtsIndex index;
+    if( !index.load(filename)  &&  !index.build(filename, ctx) ) {
+      return false;
+    }
+
+    if( index.numFrames() != numFrames ) {
+      ctx.logError(u8"ADTS file \"" + filename.generic_u8string() + u8"\" changed since validation!");
+      return false;
+    }
+
+    // (2) Map ADTS file /////////////////////////////////////////////////////
+
+    MappedFile sampleFile;
+    if( !sampleFile.open(filename) ) {
       ctx.logError(u8"Unable to read ADTS file \"" + filename.generic_u8string() + u8"\"!");
       return false;
     }
 
-    AdtsParser adts(std::move(buffer));
+    // (3) Write frames //////////////////////////////////////////////////////
 
-    // (2) Write frames //////////////////////////////////////////////////////
+    // NOTE: Skipped data was already reported by adtsFrameCount().
+    for(const AdtsIndex::Frame& frame : index.frames()) {
+      const std::span<const uint8_t> unit = AdtsIndex::accessUnit(sampleFile.span(), frame);
+      if( unit.empty() ) {
+        ctx.logError(u8"ADTS file \"" + filename.generic_u8string() + u8"\" changed since validation!");
+        return false;
+      }
 
-    while( adts.hasFrame() ) {
-      if( !MP4WriteSample(file, trackId,
-                          adts.frameData(), uint32_t(adts.frameSize())) ) {
+      if( !muxer.writeSample(unit.data(), unit.size()) ) {
         ctx.logError(u8"Unable to write AAC frame!");
         return false;
       }
-
-      adts.nextFrame();
     }
 
     return true;
   }
 
-} // namespace priv
+  MP4Duration streamAdtsSample(Mp4Muxer& muxer,
+                               AdtsReader& adts, const std::filesystem::path& filename,
+                               const uint16_t refAsc, const cs::OutputContext& ctx)
+  {
+    ctx.logText(u8"Streaming ADTS file \"" + filename.generic_u8string() + u8"\".");
 
-////// Public ////////////////////////////////////////////////////////////////
+    // (1) Open ADTS file ////////////////////////////////////////////////////
 
-bool outputAdtsBinder(const std::filesystem::path& filename, const BookBinder& binder,
-                      const cs::OutputContext& ctx,
-                      const std::u8string& language)
-{
-  // (0) Sanity check ////////////////////////////////////////////////////////
+    if( !adts.isOpen() ) {
+      adts.open(filename);
+    }
 
-  if( binder.empty() ) {
-    ctx.logWarning(u8"Empty input!");
-    return false;
-  }
+    if( !adts.isOpen() ) {
+      ctx.logError(u8"Unable to read ADTS file \"" + filename.generic_u8string() + u8"\"!");
+      return 0;
+    }
 
-  ctx.setProgressRange(0, int(binder.size()));
+    // (2) Validate & write frames ///////////////////////////////////////////
 
-  // (1) Validate & accumulate ADTS frames ///////////////////////////////////
+    MP4Duration count{0};
+    while( adts.hasFrame()  ||  resync(adts, filename, ctx) ) {
+      if( adts.aacFrameCount() != 1 ) {
+        ctx.logError(u8"Invalid AAC frame count detected!");
+        return 0;
+      }
 
-  Durations durations{};
-  uint16_t     refAsc{0};
+      if( adts.mpeg4AudioSpecificConfig() != refAsc ) {
+        ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+        return 0;
+      }
+
+      if( !muxer.writeSample(adts.frameData(), adts.frameSize()) ) {
+        ctx.logError(u8"Unable to write AAC frame!");
+        return 0;
+      }
+
+      count++;
+
+      adts.nextFrame();
+    }
+
+    adts.close();
+
+    if( count == 0 ) {
+      ctx.logError(u8"Unable to read ADTS file \"" + filename.generic_u8string() + u8"\"!");
+    }
+
+    return count;
+  }
+
+  /*
+   * NOTE:
+   * Each chapter is read once through the AdtsReader's bounded window, and
+   * its frames are validated and written in a single pass; the reference ASC
+   * is peeked from the first chapter.
+   */
+  bool streamBinder(const std::filesystem::path& filename, const BookBinder& binder,
+                    const cs::OutputContext& ctx,
+                    const std::u8string& language, const AacProfile profile)
   {
-    try {
-      durations.resize(std::size_t(binder.size()));
-    } catch(...) {
-      ctx.logError(u8"std::vector<>::resize() failed!");
+    // (1) Peek reference ASC from first chapter /////////////////////////////
+
+    AdtsReader adts;
+    if( !adts.open(binder.front().second)  &&
+        !resync(adts, binder.front().second, ctx) ) {
+      ctx.logError(u8"Unable to read ADTS file \"" + binder.front().second.generic_u8string() + u8"\"!");
+      return false;
+    }
+
+    const uint16_t refAsc = adts.mpeg4AudioSpecificConfig();
+    if( refAsc == 0 ) {
+      ctx.logError(u8"Invalid AudioSpecificConfig detected!");
+      return false;
+    }
+
+    std::vector<uint8_t> trackAsc;
+    mpeg4::AudioSpecificConfig config;
+    if( !trackConfig(&trackAsc, &config, refAsc, profile, ctx) ) {
+      return false;
+    }
+
+    ctx.logText(u8"Detected format: " + formatAsc(config));
+
+    // (2) Create MP4 file & audio track /////////////////////////////////////
+
+    Mp4Muxer muxer;
+    if( !muxer.open(filename, config.outputSamplingFrequency(), ctx) ) {
+      return false;
+    }
+
+    // (3) Write AudioSpecificConfig /////////////////////////////////////////
+
+    if( !muxer.setAudioSpecificConfig(trackAsc.data(), trackAsc.size(), ctx) ) {
       return false;
     }
 
+    // (4) Validate & write chapters in a single pass ////////////////////////
+
+    // NOTE: The first chapter is still open from peeking the ASC.
     for(std::size_t i = 0; const BookBinderChapter& chapter : binder) {
-      durations[i] = priv::adtsFrameCount(chapter.second, &refAsc, ctx);
-      if( durations[i] == 0 ) {
+      if( streamAdtsSample(muxer, adts, chapter.second, refAsc, ctx) == 0  ||
+          !muxer.addChapter(chapter.first) ) {
         return false;
-      } else {
-        durations[i] *= MP4Duration(mpeg4::numSamplesPerAacFrame);
       }
       i++;
 
-      if( refAsc == 0 ) {
-        ctx.logError(u8"Invalid AudioSpecificConfig detected!");
-        return false;
-      }
-
       ctx.setProgressValue(int(i - 1));
     }
-  } // End durations
 
-  const MP4Duration duration = std::accumulate(durations.begin(), durations.end(), MP4Duration{0});
+    printBinder(binder, muxer.chapterDurations(), muxer.timeScale(), ctx);
 
-  // (2) Extract & validate time scale ///////////////////////////////////////
+    // (5) Create chapter track //////////////////////////////////////////////
 
-  const uint32_t timeScale = mpeg4::samplingFrequencyFromASC(refAsc);
-  if( timeScale == 0 ) {
-    ctx.logError(u8"Invalid time scale!");
-    return false;
+    return muxer.close(language, ctx);
   }
 
-  ctx.logText(u8"Detected format: " + priv::formatAsc(refAsc));
-  priv::printBinder(binder, durations, timeScale, ctx);
+} // namespace priv
+
+////// Public ////////////////////////////////////////////////////////////////
+
+bool outputAdtsBinder(const std::filesystem::path& filename, const BookBinder& binder,
+                      const cs::OutputContext& ctx,
+                      const std::u8string& language, const AacProfile profile)
+{
+  // (0) Sanity check ////////////////////////////////////////////////////////
+
+  if( binder.empty() ) {
+    ctx.logWarning(u8"Empty input!");
+    return false;
+  }
 
-  // (3) Create MP4 file /////////////////////////////////////////////////////
+  ctx.setProgressRange(0, int(binder.size()));
 
-  const char *brand0 = "M4B ";
-  const char *brand1 = "isom";
-  const char *brand2 = "mp42"; // required for a valid MP4 file, cf. ISO 14496-14 "4 File Identification"
-  const char *brands[] = { brand0, brand1, brand2 };
-  char **compBrands = const_cast<char**>(brands);
+  // (1) Validate & accumulate ADTS frames ///////////////////////////////////
 
-  const MP4FileHandle file =
-      MP4CreateEx(cs::CSTR(filename.generic_u8string()), 0, 1, 0, compBrands[0], 0, compBrands, 3);
-  if( file == MP4_INVALID_FILE_HANDLE ) {
-    ctx.logError(u8"Unable to create output file \"" + filename.generic_u8string() + u8"\"!");
+  Durations numFrames{};
+  uint16_t     refAsc{0};
+  if( !priv::validateBinder(&numFrames, &refAsc, binder, ctx) ) {
     return false;
   }
 
-  // (4) Set timing information for file /////////////////////////////////////
+  // (2) Extract & validate time scale ///////////////////////////////////////
 
-  MP4SetDuration(file, duration);
-  MP4SetTimeScale(file, timeScale);
+  std::vector<uint8_t> trackAsc;
+  mpeg4::AudioSpecificConfig config;
+  if( !priv::trackConfig(&trackAsc, &config, refAsc, profile, ctx) ) {
+    return false;
+  }
 
-  // (5) Create audio track //////////////////////////////////////////////////
+  const uint32_t timeScale = config.outputSamplingFrequency();
 
-  const MP4TrackId auTrackId =
-      MP4AddAudioTrack(file, timeScale, mpeg4::numSamplesPerAacFrame, MP4_MPEG4_AUDIO_TYPE);
-  if( auTrackId == MP4_INVALID_TRACK_ID ) {
-    ctx.logError(u8"Unable to create audio track!");
-    MP4Close(file);
+  Durations durations{};
+  try {
+    durations.reserve(numFrames.size());
+    for(const MP4Duration count : numFrames) {
+      durations.push_back(count*MP4Duration(config.numSamplesPerFrame()));
+    }
+  } catch(...) {
+    ctx.logError(u8"std::vector<>::push_back() failed!");
     return false;
   }
 
-  // (5.1) Set track's flags /////////////////////////////////////////////////
+  ctx.logText(u8"Detected format: " + priv::formatAsc(config));
+  priv::printBinder(binder, durations, timeScale, ctx);
 
-  /*
-   * Flags (tkhd.flags), cf. ISO 14496-12 "8.3.2 Track Header Box":
-   *
-   * 0x1: Track_enabled
-   * 0x2: Track_in_movie
-   * 0x4: Track_in_preview
-   * 0x8: Track_size_is_aspect_ratio
-   */
-  if( !MP4SetTrackIntegerProperty(file, auTrackId, "tkhd.flags", 0xF) ) {
-    ctx.logError(u8"Unable to set audio flags!");
-    MP4Close(file);
+  // (3) Create MP4 file & audio track ///////////////////////////////////////
+
+  Mp4Muxer muxer;
+  if( !muxer.open(filename, timeScale, ctx) ) {
     return false;
   }
 
-  // (6) Write AudioSpecificConfig ///////////////////////////////////////////
+  // (4) Write AudioSpecificConfig ///////////////////////////////////////////
 
-  if( !MP4SetTrackESConfiguration(file, auTrackId,
-                                  reinterpret_cast<const uint8_t*>(&refAsc), sizeof(uint16_t)) ) {
-    ctx.logError(u8"Unable to write AudioSpecificConfig!");
-    MP4Close(file);
+  if( !muxer.setAudioSpecificConfig(trackAsc.data(), trackAsc.size(), ctx) ) {
     return false;
   }
 
-  // (7) Write chapters to MP4 file //////////////////////////////////////////
+  // (5) Write chapters to MP4 file //////////////////////////////////////////
 
   for(std::size_t i = 0; const BookBinderChapter& chapter : binder) {
-    if( !priv::writeAdtsSample(file, auTrackId, chapter.second, ctx) ) {
-      MP4Close(file);
+    if( !priv::writeAdtsSample(muxer, chapter.second, numFrames[i], ctx)  ||
+        !muxer.addChapter(chapter.first) ) {
       return false;
     }
     i++;
@@ -352,54 +630,73 @@ bool outputAdtsBinder(const std::filesystem::path& filename, const BookBinder& b
     ctx.setProgressValue(int(i - 1));
   }
 
-  // (8) Creater chapter track ///////////////////////////////////////////////
+  // (6) Create chapter track ////////////////////////////////////////////////
 
-  const MP4TrackId chTrackId =
-      MP4AddChapterTextTrack(file, auTrackId);
-  if( chTrackId == MP4_INVALID_TRACK_ID ) {
-    ctx.logError(u8"Unable to create chapter track!");
-    MP4Close(file);
+  if( !muxer.close(language, ctx) ) {
     return false;
   }
 
-  // (8.1) Set track's flags /////////////////////////////////////////////////
+  // Done! ///////////////////////////////////////////////////////////////////
+
+  ctx.setProgressValue(int(binder.size()));
+
+  return true;
+}
+
+bool outputAdtsBinderStreaming(const std::filesystem::path& filename, const BookBinder& binder,
+                               const cs::OutputContext& ctx,
+                               const std::u8string& language, const AacProfile profile)
+{
+  // (0) Sanity check ////////////////////////////////////////////////////////
+
+  if( binder.empty() ) {
+    ctx.logWarning(u8"Empty input!");
+    return false;
+  }
+
+  ctx.setProgressRange(0, int(binder.size()));
+
+  // (1) Write to temporary file /////////////////////////////////////////////
 
   /*
-   * Flags (tkhd.flags), cf. ISO 14496-12 "8.3.2 Track Header Box":
-   *
-   * 0x1: Track_enabled
-   * 0x2: Track_in_movie
-   * 0x4: Track_in_preview
-   * 0x8: Track_size_is_aspect_ratio
+   * NOTE:
+   * The chapters are validated while being written; thus, the output file is
+   * replaced only on success, and an invalid chapter does not leave a
+   * truncated M4B file behind.
    */
-  if( !MP4SetTrackIntegerProperty(file, chTrackId, "tkhd.flags", 0xF) ) {
-    ctx.logError(u8"Unable to set chapter flags!");
-    MP4Close(file);
+
+  const std::filesystem::path tempFileName = fileutil::tempFileName(filename);
+  if( !priv::streamBinder(tempFileName, binder, ctx, language, profile) ) {
+    fileutil::removeFile(tempFileName);
     return false;
   }
 
-  // (8.2) Set track's language //////////////////////////////////////////////
+  // (2) Replace output file /////////////////////////////////////////////////
 
-  if( language.size() == 3 ) { // cf. ISO 639-2/T
-    if( !MP4SetTrackLanguage(file, chTrackId, cs::CSTR(language)) ) {
-      ctx.logError(u8"Unable to set chapter language!");
-      MP4Close(file);
-      return false;
-    }
+  if( !fileutil::replaceFile(tempFileName, filename) ) {
+    ctx.logError(u8"Unable to write MP4 file \"" + filename.generic_u8string() + u8"\"!");
+    return false;
   }
 
-  // (9) Create chapters /////////////////////////////////////////////////////
+  // Done! ///////////////////////////////////////////////////////////////////
 
-  for(std::size_t i = 0; const BookBinderChapter& chapter : binder) {
-    MP4AddChapter(file, chTrackId, durations[i], cs::CSTR(chapter.first));
-    i++;
+  ctx.setProgressValue(int(binder.size()));
 
-    ctx.setProgressValue(int(i));
-  }
+  return true;
+}
 
-  // Done! ///////////////////////////////////////////////////////////////////
+bool isAdtsBinderIndexed(const BookBinder& binder)
+{
+  if( binder.empty() ) {
+    return false;
+  }
 
-  MP4Close(file);
+  for(const BookBinderChapter& chapter : binder) {
+    AdtsIndex index;
+    if( !index.load(chapter.second, false) ) {
+      return false;
+    }
+  }
 
   return true;
 }
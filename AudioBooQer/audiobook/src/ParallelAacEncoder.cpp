@@ -0,0 +1,447 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <cs/Core/Buffer.h>
+#include <cs/Text/PrintUtil.h>
+
+#include "ParallelAacEncoder.h"
+
+#include "AacEncoder.h"
+#include "AccessUnitBuffer.h"
+#include "AdtsFileSink.h"
+#include "Mpeg4Audio.h"
+#include "TaskScheduler.h"
+
+////// Implementation ////////////////////////////////////////////////////////
+
+namespace priv {
+
+  class Throttle {
+  public:
+    Throttle() noexcept
+      : _count(0)
+      , _max(std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+    {
+    }
+
+    void acquire()
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cond.wait(lock, [this]() -> bool { return _count < _max; });
+      _count++;
+    }
+
+    std::size_t max() const
+    {
+      const std::lock_guard<std::mutex> lock(_mutex);
+      return _max;
+    }
+
+    void release()
+    {
+      {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        _count--;
+      }
+      _cond.notify_all();
+    }
+
+    void setMax(const std::size_t max)
+    {
+      {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        _max = std::max<std::size_t>(1, max);
+      }
+      _cond.notify_all();
+    }
+
+  private:
+    std::condition_variable _cond;
+    std::size_t             _count;
+    std::size_t             _max;
+    mutable std::mutex      _mutex;
+  };
+
+  Throttle& throttle()
+  {
+    static Throttle instance;
+    return instance;
+  }
+
+  TaskScheduler& scheduler()
+  {
+    static TaskScheduler instance;
+    return instance;
+  }
+
+  struct Segment {
+    Segment() noexcept = default;
+
+    AccessUnitBuffer units{};
+    std::size_t      first{};
+    std::size_t      count{};
+    bool             ok{false};
+  };
+
+  Segment encodeSegment(const AacFormat& format, const cs::Buffer& pcm,
+                        const std::size_t first, const std::size_t count)
+  {
+    Segment result;
+    result.first = first;
+    result.count = count;
+
+    AacEncoder encoder;
+    if( !encoder.initialize(format, &result.units) ) {
+      return result;
+    }
+
+    if( !pcm.empty()  &&  !encoder.encode(pcm.data(), pcm.size()) ) {
+      return result;
+    }
+
+    if( !encoder.flush() ) {
+      return result;
+    }
+
+    const std::size_t numRequired = count != SIZE_MAX
+        ? first + count
+        : first;
+    result.ok = result.units.numAccessUnits() >= numRequired;
+
+    return result;
+  }
+
+} // namespace priv
+
+class ParallelAacEncoderImpl {
+public:
+  ParallelAacEncoderImpl() = default;
+  ~ParallelAacEncoderImpl() = default;
+
+  AdtsFileSink                           adts{};
+  std::vector<uint8_t>                   asc{};
+  AacFormat                              format{};
+  uint64_t                               numDataBytes{};
+  std::size_t                            numSamplesPerFrame{};
+  std::size_t                            numSegments{};
+  cs::Buffer                             pcm{};
+  std::deque<std::future<priv::Segment>> pending{};
+  IAccessUnitSink                       *sink{nullptr};
+};
+
+namespace priv {
+
+  std::unique_ptr<ParallelAacEncoderImpl> open(const AacFormat& format)
+  {
+    // (1) Probe AudioSpecificConfig; all segments have to match it //////////
+
+    AccessUnitBuffer probe;
+    AacEncoder encoder;
+    if( !encoder.initialize(format, &probe) ) {
+      return std::unique_ptr<ParallelAacEncoderImpl>();
+    }
+
+    // NOTE: With SBR, one access unit comprises 2048 PCM frames!
+    mpeg4::AudioSpecificConfig config;
+    if( !mpeg4::parseAudioSpecificConfig(&config,
+                                         probe.audioSpecificConfig().data(),
+                                         probe.audioSpecificConfig().size()) ) {
+      return std::unique_ptr<ParallelAacEncoderImpl>();
+    }
+
+    // (2) Create implementation /////////////////////////////////////////////
+
+    std::unique_ptr<ParallelAacEncoderImpl> result;
+    try {
+      result = std::make_unique<ParallelAacEncoderImpl>();
+      result->asc = probe.audioSpecificConfig();
+    } catch(...) {
+      return std::unique_ptr<ParallelAacEncoderImpl>();
+    }
+    result->format             = format;
+    result->numSamplesPerFrame = config.numSamplesPerFrame();
+
+    return result;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+ParallelAacEncoder::ParallelAacEncoder(const std::size_t numSegmentFrames,
+                                       const std::size_t numOverlapFrames,
+                                       const std::size_t outputBufferSize)
+  : impl()
+  , _numOverlapFrames(numOverlapFrames)
+  , _numSegmentFrames(std::max<std::size_t>({numSegmentFrames, numOverlapFrames, 1}))
+  , _outputBufferSize(outputBufferSize)
+{
+}
+
+ParallelAacEncoder::~ParallelAacEncoder()
+{
+}
+
+bool ParallelAacEncoder::encode(const void *data, const std::size_t size)
+{
+  if( !impl  ||  !isValidData(data, size) ) {
+    return false;
+  }
+
+  const uint8_t *src = reinterpret_cast<const uint8_t*>(data);
+  std::size_t remain = size;
+  while( remain > 0 ) {
+    // NOTE: The first segment has no leading overlap!
+    const std::size_t numSegmentFrames = impl->numSegments > 0
+        ? _numOverlapFrames + _numSegmentFrames + _numOverlapFrames
+        : _numSegmentFrames + _numOverlapFrames;
+    const std::size_t segmentSize =
+        numSegmentFrames*impl->numSamplesPerFrame*impl->format.numBytesPerPcmFrame();
+
+    const std::size_t numTake = std::min<std::size_t>(remain, segmentSize - impl->pcm.size());
+    try {
+      impl->pcm.reserve(segmentSize);
+      impl->pcm.insert(impl->pcm.end(), src, src + numTake);
+    } catch(...) {
+      return false;
+    }
+    impl->numDataBytes += numTake;
+
+    src    += numTake;
+    remain -= numTake;
+
+    if( impl->pcm.size() >= segmentSize  &&  !dispatch(false) ) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ParallelAacEncoder::flush()
+{
+  if( !impl ) {
+    return false;
+  }
+
+  // (1) Encode remaining PCM ////////////////////////////////////////////////
+
+  if( !dispatch(true) ) {
+    return false;
+  }
+
+  // (2) Stitch all pending segments /////////////////////////////////////////
+
+  while( !impl->pending.empty() ) {
+    if( !stitch() ) {
+      return false;
+    }
+  }
+
+  // (3) Account for padding of the last frame; cf. AacEncoder::flush() //////
+
+  const uint64_t numFrameBytes =
+      uint64_t(impl->numSamplesPerFrame*impl->format.numBytesPerPcmFrame());
+  impl->numDataBytes = (impl->numDataBytes + numFrameBytes - 1)/numFrameBytes*numFrameBytes;
+
+  return impl->adts.flush();
+}
+
+bool ParallelAacEncoder::initialize(const AacFormat& format, const std::filesystem::path& outputFileName)
+{
+  if( impl ) { // do not operate on an existing instance
+    return false;
+  }
+
+  // (1) Open encoder ////////////////////////////////////////////////////////
+
+  std::unique_ptr<ParallelAacEncoderImpl> result = priv::open(format);
+  if( !result ) {
+    return false;
+  }
+
+  // (2) Create output file //////////////////////////////////////////////////
+
+  if( !result->adts.setBufferSize(_outputBufferSize)  ||
+      !result->adts.open(outputFileName) ) {
+    return false;
+  }
+
+  if( !result->adts.setAudioSpecificConfig(result->asc.data(), result->asc.size()) ) {
+    return false;
+  }
+
+  // (3) Store result ////////////////////////////////////////////////////////
+
+  impl = std::move(result);
+  impl->sink = &impl->adts;
+
+  return true;
+}
+
+bool ParallelAacEncoder::initialize(const AacFormat& format, IAccessUnitSink *sink)
+{
+  if( impl  ||  sink == nullptr ) { // do not operate on an existing instance
+    return false;
+  }
+
+  // (1) Open encoder ////////////////////////////////////////////////////////
+
+  std::unique_ptr<ParallelAacEncoderImpl> result = priv::open(format);
+  if( !result ) {
+    return false;
+  }
+
+  // (2) Pass AudioSpecificConfig to sink ////////////////////////////////////
+
+  if( !sink->setAudioSpecificConfig(result->asc.data(), result->asc.size()) ) {
+    return false;
+  }
+
+  // (3) Store result ////////////////////////////////////////////////////////
+
+  impl = std::move(result);
+  impl->sink = sink;
+
+  return true;
+}
+
+uint64_t ParallelAacEncoder::numPcmFrames() const
+{
+  return impl->numDataBytes/impl->format.numBytesPerPcmFrame();
+}
+
+std::filesystem::path ParallelAacEncoder::outputSuffix(const AacFormat&) const
+{
+  return "aac";
+}
+
+std::string ParallelAacEncoder::settings() const
+{
+  // NOTE: Segmentation affects the encoded stream at the segments' seams!
+  return cs::sprint("ParallelAacEncoder;segment=%;overlap=%;",
+                    _numSegmentFrames, _numOverlapFrames) + AacEncoder::encoderSettings();
+}
+
+std::size_t ParallelAacEncoder::maxThreadCount()
+{
+  return priv::throttle().max();
+}
+
+void ParallelAacEncoder::setMaxThreadCount(const std::size_t count)
+{
+  priv::throttle().setMax(count);
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool ParallelAacEncoder::dispatch(const bool is_last)
+{
+  // (1) Limit segments in flight; this also bounds memory usage /////////////
+
+  while( impl->pending.size() >= maxThreadCount() ) {
+    if( !stitch() ) {
+      return false;
+    }
+  }
+
+  // (2) Carry overlap over to next segment //////////////////////////////////
+
+  cs::Buffer next;
+  if( !is_last ) {
+    const std::size_t numCarry =
+        2*_numOverlapFrames*impl->numSamplesPerFrame*impl->format.numBytesPerPcmFrame();
+    try {
+      next.assign(impl->pcm.end() - std::ptrdiff_t(numCarry), impl->pcm.end());
+    } catch(...) {
+      return false;
+    }
+  }
+
+  // (3) Encode segment //////////////////////////////////////////////////////
+
+  const std::size_t first = impl->numSegments > 0
+      ? _numOverlapFrames
+      : 0;
+  const std::size_t count = is_last
+      ? SIZE_MAX
+      : _numSegmentFrames;
+
+  // NOTE: Blocks until less than maxThreadCount() segments are encoded.
+  priv::throttle().acquire();
+
+  std::shared_ptr<std::packaged_task<priv::Segment()>> task;
+  try {
+    task = std::make_shared<std::packaged_task<priv::Segment()>>(
+          [format = impl->format, pcm = std::move(impl->pcm), first, count]() -> priv::Segment {
+            return priv::encodeSegment(format, pcm, first, count);
+          });
+    impl->pending.push_back(task->get_future());
+  } catch(...) {
+    priv::throttle().release();
+    return false;
+  }
+
+  const bool is_submitted = priv::scheduler().submit([task]() -> void {
+    (*task)();
+    priv::throttle().release();
+  });
+  if( !is_submitted ) {
+    priv::throttle().release();
+    impl->pending.pop_back();
+    return false;
+  }
+
+  impl->pcm = std::move(next);
+  impl->numSegments++;
+
+  return true;
+}
+
+bool ParallelAacEncoder::stitch()
+{
+  const priv::Segment segment = impl->pending.front().get();
+  impl->pending.pop_front();
+
+  if( !segment.ok  ||  segment.units.audioSpecificConfig() != impl->asc ) {
+    return false;
+  }
+
+  return segment.units.writeTo(impl->sink, segment.first, segment.count);
+}
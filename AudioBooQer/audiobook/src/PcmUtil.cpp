@@ -0,0 +1,393 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cmath>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#if defined(__SSE2__)  ||  defined(_M_X64)  ||  (defined(_M_IX86_FP)  &&  _M_IX86_FP >= 2)
+# define HAVE_SSE2
+# include <emmintrin.h>
+#endif
+
+#include "PcmUtil.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  // NOTE: Samples are requantized from 24bit, i.e. 8 fractional bits.
+  inline constexpr int32_t fractionBits = 8;
+  inline constexpr float   floatScale   = 8388608.0f; // 2^23
+
+  inline int32_t halve(const int16_t sample)
+  {
+    return int32_t(sample) >> 1;
+  }
+
+  inline uint32_t nextRandom(uint32_t& state)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  inline int32_t triangular(const uint32_t random)
+  {
+    return int32_t(random & 0xFF) - int32_t((random >> 8) & 0xFF);
+  }
+
+  inline int16_t quantize(const int32_t sample, const int32_t noise)
+  {
+    const int32_t result = (sample + noise + (1 << (fractionBits - 1))) >> fractionBits;
+    return int16_t(std::clamp<int32_t>(result,
+                                       std::numeric_limits<int16_t>::min(),
+                                       std::numeric_limits<int16_t>::max()));
+  }
+
+  inline uint32_t load32(const uint8_t *data, const bool swapBytes)
+  {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return swapBytes
+        ? (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24)
+        : value;
+  }
+
+  int32_t loadSample(const uint8_t *data, const pcm::SampleFormat format, const bool swapBytes)
+  {
+    if(        format == pcm::SampleFormat::Int24 ) {
+      const bool isLittle = (std::endian::native == std::endian::little) != swapBytes;
+      const uint32_t value = isLittle
+          ? uint32_t(data[0])       | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16
+          : uint32_t(data[0]) << 16 | uint32_t(data[1]) << 8 | uint32_t(data[2]);
+      return int32_t(value << 8) >> 8;
+
+    } else if( format == pcm::SampleFormat::Int32 ) {
+      return int32_t(load32(data, swapBytes)) >> fractionBits;
+
+    } else if( format == pcm::SampleFormat::Float32 ) {
+      float value = std::bit_cast<float>(load32(data, swapBytes));
+      // NOTE: Same semantics as _mm_max_ps()/_mm_min_ps(); NaN yields -2.0!
+      value = value > -2.0f ? value : -2.0f;
+      value = value <  2.0f ? value :  2.0f;
+      return int32_t(std::lrintf(value*floatScale));
+    }
+
+    return 0;
+  }
+
+  void convertSample(uint8_t *output, const uint8_t *input, const pcm::SampleFormat format,
+                     const bool swapBytes, pcm::Dither *dither)
+  {
+    int32_t noise = 0;
+    if( dither != nullptr ) {
+      noise = triangular(nextRandom(dither->state[dither->lane]));
+      dither->lane = (dither->lane + 1) % 4;
+    }
+    const int16_t result = quantize(loadSample(input, format, swapBytes), noise);
+    std::memcpy(output, &result, sizeof(result));
+  }
+
+  void swapInt16(uint8_t *dest, const uint8_t *src, const std::size_t numSamples)
+  {
+    std::size_t i = 0;
+
+#ifdef HAVE_SSE2
+    for(; i + 8 <= numSamples; i += 8) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2*i),
+                       _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+    }
+#endif
+
+    for(; i < numSamples; i++) {
+      const uint8_t lo = src[2*i];
+      dest[2*i]     = src[2*i + 1];
+      dest[2*i + 1] = lo;
+    }
+  }
+
+#ifdef HAVE_SSE2
+  inline int64_t sum(const __m128i v)
+  {
+    alignas(16) int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+    return lanes[0] + lanes[1];
+  }
+
+  inline __m128i swap32(const __m128i x)
+  {
+    const __m128i y = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(y, _MM_SHUFFLE(2, 3, 0, 1)),
+                               _MM_SHUFFLE(2, 3, 0, 1));
+  }
+
+  // NOTE: Loads four samples; reads 16 bytes, i.e. 4 beyond the samples!
+  inline __m128i loadInt24(const uint8_t *data, const bool swapBytes)
+  {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const __m128i lo = _mm_unpacklo_epi32(x, _mm_srli_si128(x, 3));
+    const __m128i hi = _mm_unpacklo_epi32(_mm_srli_si128(x, 6), _mm_srli_si128(x, 9));
+    const __m128i y = _mm_unpacklo_epi64(lo, hi); // b0 b1 b2 -- per lane
+    return swapBytes
+        ? _mm_srai_epi32(swap32(y), 8)
+        : _mm_srai_epi32(_mm_slli_epi32(y, 8), 8);
+  }
+
+  inline __m128i loadSamples(const uint8_t *data, const pcm::SampleFormat format,
+                             const bool swapBytes)
+  {
+    if( format == pcm::SampleFormat::Int24 ) {
+      return loadInt24(data, swapBytes);
+    }
+
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    if( swapBytes ) {
+      x = swap32(x);
+    }
+
+    if( format == pcm::SampleFormat::Int32 ) {
+      return _mm_srai_epi32(x, fractionBits);
+    }
+
+    __m128 value = _mm_castsi128_ps(x);
+    value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-2.0f)), _mm_set1_ps(2.0f));
+    return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(floatScale)));
+  }
+
+  inline __m128i nextRandom(__m128i& state)
+  {
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+    state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+    return state;
+  }
+
+  inline __m128i triangular(const __m128i random)
+  {
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    return _mm_sub_epi32(_mm_and_si128(random, mask),
+                         _mm_and_si128(_mm_srli_epi32(random, 8), mask));
+  }
+#endif
+
+} // namespace priv
+
+////// Public ////////////////////////////////////////////////////////////////
+
+namespace pcm {
+
+  Dither::Dither(const uint32_t seed) noexcept
+  {
+    // NOTE: xorshift requires a non-zero state!
+    uint32_t x = seed != 0 ? seed : 1;
+    for(uint32_t& lane : state) {
+      lane = priv::nextRandom(x);
+    }
+  }
+
+  void StereoStatistics::accumulate(const int16_t *pcm, const std::size_t numFrames)
+  {
+    std::size_t i = 0;
+
+#ifdef HAVE_SSE2
+    // (1) Four frames per iteration /////////////////////////////////////////
+
+    const __m128i zero = _mm_setzero_si128();
+    __m128i  accCross = zero;
+    __m128i   accLeft = zero;
+    __m128i  accRight = zero;
+    for(; i + 4 <= numFrames; i += 4) {
+      // L0 R0 L1 R1 L2 R2 L3 R3
+      const __m128i x = _mm_srai_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pcm + 2*i)), 1);
+
+      // L0 L1 L2 L3 R0 R1 R2 R3 -> L0²+L1² L2²+L3² R0²+R1² R2²+R3²
+      __m128i y = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 1, 2, 0));
+      y = _mm_shufflehi_epi16(y, _MM_SHUFFLE(3, 1, 2, 0));
+      y = _mm_shuffle_epi32(y, _MM_SHUFFLE(3, 1, 2, 0));
+      const __m128i squares = _mm_madd_epi16(y, y);
+      accLeft  = _mm_add_epi64(accLeft,  _mm_unpacklo_epi32(squares, zero));
+      accRight = _mm_add_epi64(accRight, _mm_unpackhi_epi32(squares, zero));
+
+      // R0 L0 R1 L1 R2 L2 R3 L3 -> 2*L0*R0 2*L1*R1 2*L2*R2 2*L3*R3
+      __m128i z = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+      z = _mm_shufflehi_epi16(z, _MM_SHUFFLE(2, 3, 0, 1));
+      const __m128i cross = _mm_madd_epi16(x, z);
+      const __m128i  sign = _mm_srai_epi32(cross, 31);
+      accCross = _mm_add_epi64(accCross, _mm_unpacklo_epi32(cross, sign));
+      accCross = _mm_add_epi64(accCross, _mm_unpackhi_epi32(cross, sign));
+    }
+
+    sumCross += priv::sum(accCross)/2;
+    sumLeft  += uint64_t(priv::sum(accLeft));
+    sumRight += uint64_t(priv::sum(accRight));
+#endif
+
+    // (2) Remaining frames //////////////////////////////////////////////////
+
+    for(; i < numFrames; i++) {
+      const int32_t  left = priv::halve(pcm[2*i]);
+      const int32_t right = priv::halve(pcm[2*i + 1]);
+      sumCross += int64_t(left*right);
+      sumLeft  += uint64_t(left*left);
+      sumRight += uint64_t(right*right);
+    }
+
+    this->numFrames += numFrames;
+  }
+
+  bool StereoStatistics::isDualMono(const int threshold) const
+  {
+    return sideLevel() < double(threshold);
+  }
+
+  double StereoStatistics::sideLevel() const
+  {
+    const int64_t  mid = int64_t(sumLeft + sumRight) + 2*sumCross;
+    const int64_t side = int64_t(sumLeft + sumRight) - 2*sumCross;
+    if( side <= 0 ) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    if( mid <= 0 ) {
+      return std::numeric_limits<double>::infinity();
+    }
+    return 10*std::log10(double(side)/double(mid));
+  }
+
+  void convertToInt16(void *dest, const void *src, const std::size_t numSamples,
+                      const SampleFormat format, const bool swapBytes,
+                      Dither *dither)
+  {
+    uint8_t       *output = static_cast<uint8_t*>(dest);
+    const uint8_t  *input = static_cast<const uint8_t*>(src);
+    const std::size_t size = sampleSize(format);
+
+    // (1) 16bit is not requantized //////////////////////////////////////////
+
+    if( format == SampleFormat::Int16 ) {
+      if(        swapBytes ) {
+        priv::swapInt16(output, input, numSamples);
+      } else if( output != input ) {
+        std::memmove(output, input, numSamples*size);
+      }
+      return;
+    }
+
+    std::size_t i = 0;
+
+    // (2) Continue the previous block's dither lanes ////////////////////////
+
+    for(; dither != nullptr  &&  dither->lane != 0  &&  i < numSamples; i++) {
+      priv::convertSample(output + 2*i, input + i*size, format, swapBytes, dither);
+    }
+
+#ifdef HAVE_SSE2
+    // (3) Eight samples per iteration ///////////////////////////////////////
+
+    /*
+     * NOTE:
+     * Each iteration loads all of its input before storing its output; as
+     * the output is smaller, storing never overwrites unread input.
+     */
+
+    const std::size_t numSimdSamples = format == SampleFormat::Int24
+        ? (numSamples*size >= 4 ? (numSamples*size - 4)/size : 0)
+        : numSamples;
+
+    const __m128i rounding = _mm_set1_epi32(1 << (priv::fractionBits - 1));
+    __m128i state = dither != nullptr
+        ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->state))
+        : _mm_setzero_si128();
+    for(; i + 8 <= numSimdSamples; i += 8) {
+      __m128i a = priv::loadSamples(input + i*size,          format, swapBytes);
+      __m128i b = priv::loadSamples(input + i*size + 4*size, format, swapBytes);
+      if( dither != nullptr ) {
+        a = _mm_add_epi32(a, priv::triangular(priv::nextRandom(state)));
+        b = _mm_add_epi32(b, priv::triangular(priv::nextRandom(state)));
+      }
+      a = _mm_srai_epi32(_mm_add_epi32(a, rounding), priv::fractionBits);
+      b = _mm_srai_epi32(_mm_add_epi32(b, rounding), priv::fractionBits);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2*i), _mm_packs_epi32(a, b));
+    }
+    if( dither != nullptr ) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->state), state);
+    }
+#endif
+
+    // (4) Remaining samples /////////////////////////////////////////////////
+
+    for(; i < numSamples; i++) {
+      priv::convertSample(output + 2*i, input + i*size, format, swapBytes, dither);
+    }
+  }
+
+  void downmixStereo(int16_t *dest, const int16_t *src, const std::size_t numFrames)
+  {
+    std::size_t i = 0;
+
+#ifdef HAVE_SSE2
+    // (1) Eight frames per iteration ////////////////////////////////////////
+
+    const __m128i one = _mm_set1_epi16(1);
+    for(; i + 8 <= numFrames; i += 8) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*i));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*i + 8));
+      const __m128i sumA = _mm_srai_epi32(_mm_madd_epi16(a, one), 1);
+      const __m128i sumB = _mm_srai_epi32(_mm_madd_epi16(b, one), 1);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packs_epi32(sumA, sumB));
+    }
+#endif
+
+    // (2) Remaining frames //////////////////////////////////////////////////
+
+    for(; i < numFrames; i++) {
+      dest[i] = int16_t((int32_t(src[2*i]) + int32_t(src[2*i + 1])) >> 1);
+    }
+  }
+
+  std::size_t sampleSize(const SampleFormat format)
+  {
+    if(        format == SampleFormat::Int16 ) {
+      return 2;
+    } else if( format == SampleFormat::Int24 ) {
+      return 3;
+    } else if( format == SampleFormat::Int32  ||  format == SampleFormat::Float32 ) {
+      return 4;
+    }
+    return 0;
+  }
+
+} // namespace pcm
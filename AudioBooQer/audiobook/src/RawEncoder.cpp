@@ -90,3 +90,8 @@ std::filesystem::path RawEncoder::outputSuffix(const AacFormat& format) const
                     format.numBitsPerChannel,
                     format.numSamplesPerSecond);
 }
+
+std::string RawEncoder::settings() const
+{
+  return std::string("RawEncoder");
+}
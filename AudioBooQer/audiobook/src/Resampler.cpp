@@ -0,0 +1,403 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cmath>
+
+#include <algorithm>
+#include <numeric>
+
+#if defined(__SSE2__)  ||  defined(_M_X64)  ||  (defined(_M_IX86_FP)  &&  _M_IX86_FP >= 2)
+# define HAVE_SSE2
+# include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__)  &&  (defined(__x86_64__)  ||  defined(__i386__))
+# define HAVE_AVX2
+# include <immintrin.h>
+#endif
+
+#include "Resampler.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  // NOTE: Parameters of the prototype filter.
+  inline constexpr double kaiserBeta = 8.0;
+  inline constexpr double rolloff    = 0.95;
+
+  inline constexpr double PI = 3.14159265358979323846;
+
+  // Modified Bessel function of the first kind, order 0
+  double besselI0(const double x)
+  {
+    double result = 1;
+    double   term = 1;
+    for(int k = 1; k < 64; k++) {
+      term *= (x/(2*k))*(x/(2*k));
+      result += term;
+      if( term < result*1e-12 ) {
+        break;
+      }
+    }
+    return result;
+  }
+
+  double kaiser(const double x)
+  {
+    return std::abs(x) < 1
+        ? besselI0(kaiserBeta*std::sqrt(1 - x*x))/besselI0(kaiserBeta)
+        : 0;
+  }
+
+  double sinc(const double x)
+  {
+    return x != 0
+        ? std::sin(PI*x)/(PI*x)
+        : 1;
+  }
+
+  inline int16_t saturate(const float value)
+  {
+    return int16_t(std::clamp<long>(std::lrint(value), -32768, 32767));
+  }
+
+  // NOTE: The number of taps is a multiple of 8, cf. Resampler::initialize().
+
+  float dotScalar(const float *a, const float *b, const std::size_t size)
+  {
+    float result = 0;
+    for(std::size_t i = 0; i < size; i++) {
+      result += a[i]*b[i];
+    }
+    return result;
+  }
+
+#ifdef HAVE_SSE2
+  float dotSSE2(const float *a, const float *b, const std::size_t size)
+  {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for(std::size_t i = 0; i < size; i += 8) {
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+
+    __m128 sum = _mm_add_ps(acc0, acc1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+  }
+#endif
+
+#ifdef HAVE_AVX2
+  __attribute__((target("avx2,fma")))
+  float dotAVX2(const float *a, const float *b, const std::size_t size)
+  {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for(; i + 16 <= size; i += 16) {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),     _mm256_loadu_ps(b + i),     acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    if( i < size ) {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+  }
+#endif
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+bool Resampler::initialize(const unsigned int numChannels,
+                           const unsigned int inputRate, const unsigned int outputRate,
+                           const ResamplerKernel kernel)
+{
+  if( numChannels < 1  ||  inputRate < 1  ||  outputRate < 1  ||  !isSupported(kernel) ) {
+    return false;
+  }
+
+  // (1) Kernel //////////////////////////////////////////////////////////////
+
+  if(        kernel == ResamplerKernel::Auto ) {
+    _kernel = isSupported(ResamplerKernel::AVX2)
+        ? ResamplerKernel::AVX2
+        : isSupported(ResamplerKernel::SSE2)
+          ? ResamplerKernel::SSE2
+          : ResamplerKernel::Scalar;
+  } else {
+    _kernel = kernel;
+  }
+
+  _dot = priv::dotScalar;
+#ifdef HAVE_SSE2
+  if( _kernel == ResamplerKernel::SSE2 ) {
+    _dot = priv::dotSSE2;
+  }
+#endif
+#ifdef HAVE_AVX2
+  if( _kernel == ResamplerKernel::AVX2 ) {
+    _dot = priv::dotAVX2;
+  }
+#endif
+
+  // (2) Ratio L/M ///////////////////////////////////////////////////////////
+
+  const unsigned int divisor = std::gcd(inputRate, outputRate);
+  _up   = outputRate/divisor;
+  _down = inputRate/divisor;
+
+  _inputRate  = inputRate;
+  _outputRate = outputRate;
+
+  // (3) Filter //////////////////////////////////////////////////////////////
+
+  const double scale = std::min<double>(1, double(_up)/double(_down));
+
+  _numPhases = std::min<std::size_t>(_up, maxNumPhases);
+  _numTaps   = std::min<std::size_t>(maxNumTaps,
+                                     (std::size_t(std::ceil(double(baseNumTaps)/scale)) + 7)/8*8);
+
+  try {
+    _channels.assign(numChannels, std::vector<float>());
+    _coefficients.assign(isPassThrough() ? 0 : _numPhases*_numTaps, 0);
+  } catch(...) {
+    _channels.clear();
+    _coefficients.clear();
+    return false;
+  }
+
+  const double center = double(_numTaps/2 - 1);
+  const double cutoff = priv::rolloff*scale;
+  for(std::size_t p = 0; p < _coefficients.size()/std::max<std::size_t>(1, _numTaps); p++) {
+    float *coefficients = _coefficients.data() + p*_numTaps;
+    const double frac = double(p)/double(_numPhases);
+
+    double sum = 0;
+    for(std::size_t j = 0; j < _numTaps; j++) {
+      const double t = double(j) - center - frac;
+      const double h = cutoff*priv::sinc(cutoff*t)*priv::kaiser(t/double(_numTaps/2));
+      coefficients[j] = float(h);
+      sum += h;
+    }
+
+    // NOTE: Unity gain at DC for every phase.
+    for(std::size_t j = 0; j < _numTaps; j++) {
+      coefficients[j] = float(double(coefficients[j])/sum);
+    }
+  }
+
+  reset();
+
+  return true;
+}
+
+unsigned int Resampler::inputRate() const
+{
+  return _inputRate;
+}
+
+bool Resampler::isPassThrough() const
+{
+  return _up == _down;
+}
+
+ResamplerKernel Resampler::kernel() const
+{
+  return _kernel;
+}
+
+std::size_t Resampler::numTaps() const
+{
+  return _numTaps;
+}
+
+unsigned int Resampler::outputRate() const
+{
+  return _outputRate;
+}
+
+bool Resampler::flush(std::vector<int16_t>& output)
+{
+  output.clear();
+  if( _channels.empty()  ||  isPassThrough() ) {
+    return !_channels.empty();
+  }
+
+  // (1) Pad with zeros covering the filter's look-ahead /////////////////////
+
+  try {
+    for(std::vector<float>& channel : _channels) {
+      channel.insert(channel.end(), _numTaps/2, 0);
+    }
+  } catch(...) {
+    return false;
+  }
+
+  // (2) Emit output up to the end of the input //////////////////////////////
+
+  const uint64_t numOutputFrames = (_numInputFrames*_up + _down - 1)/_down;
+  const bool ok = filter(output, numOutputFrames - std::min(numOutputFrames, _numOutputFrames));
+
+  reset();
+
+  return ok;
+}
+
+bool Resampler::process(std::vector<int16_t>& output,
+                        const int16_t *input, const std::size_t numFrames)
+{
+  output.clear();
+  if( _channels.empty() ) {
+    return false;
+  }
+
+  const std::size_t numChannels = _channels.size();
+
+  if( isPassThrough() ) {
+    try {
+      output.assign(input, input + numFrames*numChannels);
+    } catch(...) {
+      return false;
+    }
+    return true;
+  }
+
+  // (1) Deinterleave input //////////////////////////////////////////////////
+
+  try {
+    for(std::size_t c = 0; c < numChannels; c++) {
+      std::vector<float>& channel = _channels[c];
+      const std::size_t offset = channel.size();
+      channel.resize(offset + numFrames);
+      for(std::size_t i = 0; i < numFrames; i++) {
+        channel[offset + i] = float(input[i*numChannels + c]);
+      }
+    }
+  } catch(...) {
+    return false;
+  }
+  _numInputFrames += numFrames;
+
+  // (2) Filter //////////////////////////////////////////////////////////////
+
+  return filter(output, UINT64_MAX);
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool Resampler::filter(std::vector<int16_t>& output, const uint64_t maxNumOutputFrames)
+{
+  const std::size_t numChannels = _channels.size();
+  const std::size_t   numFrames = _channels.front().size();
+
+  // (1) Count output frames /////////////////////////////////////////////////
+
+  std::size_t numOutputFrames = 0;
+  for(uint64_t start = _start, phase = _phase;
+      start + _numTaps <= numFrames  &&  numOutputFrames < maxNumOutputFrames;
+      numOutputFrames++) {
+    phase += _down;
+    start += phase/_up;
+    phase %= _up;
+  }
+
+  try {
+    output.resize(numOutputFrames*numChannels);
+  } catch(...) {
+    return false;
+  }
+
+  // (2) One output frame per step of M/L input frames ///////////////////////
+
+  for(std::size_t n = 0; n < numOutputFrames; n++) {
+    const std::size_t index = std::size_t(_phase*_numPhases/_up);
+    const float *coefficients = _coefficients.data() + index*_numTaps;
+
+    for(std::size_t c = 0; c < numChannels; c++) {
+      output[n*numChannels + c] = priv::saturate(_dot(coefficients, _channels[c].data() + _start, _numTaps));
+    }
+
+    _phase += _down;
+    _start += std::size_t(_phase/_up);
+    _phase %= _up;
+  }
+  _numOutputFrames += numOutputFrames;
+
+  // (3) Discard consumed input //////////////////////////////////////////////
+
+  for(std::vector<float>& channel : _channels) {
+    channel.erase(channel.begin(), channel.begin() + std::min(_start, channel.size()));
+  }
+  _start -= std::min(_start, numFrames);
+
+  return true;
+}
+
+bool Resampler::isSupported(const ResamplerKernel kernel)
+{
+  switch( kernel ) {
+  case ResamplerKernel::Auto:
+  case ResamplerKernel::Scalar:
+    return true;
+#ifdef HAVE_SSE2
+  case ResamplerKernel::SSE2:
+    return true;
+#endif
+#ifdef HAVE_AVX2
+  case ResamplerKernel::AVX2:
+    return __builtin_cpu_supports("avx2")  &&  __builtin_cpu_supports("fma");
+#endif
+  default:
+    break;
+  }
+  return false;
+}
+
+void Resampler::reset()
+{
+  // NOTE: The filter is centered on the first input frame.
+  for(std::vector<float>& channel : _channels) {
+    channel.assign(isPassThrough() ? 0 : _numTaps/2 - 1, 0);
+  }
+  _numInputFrames  = 0;
+  _numOutputFrames = 0;
+  _phase           = 0;
+  _start           = 0;
+}
@@ -0,0 +1,175 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cs/Text/PrintUtil.h>
+
+#include "ResamplingEncoder.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+ResamplingEncoder::ResamplingEncoder(AudioEncoderPtr encoder)
+  : _encoder(std::move(encoder))
+{
+}
+
+ResamplingEncoder::~ResamplingEncoder()
+{
+}
+
+unsigned int ResamplingEncoder::inputRate() const
+{
+  return _resampler.inputRate();
+}
+
+bool ResamplingEncoder::setInputRate(const unsigned int rate)
+{
+  if( !_is_initialized  ||  rate < 1 ) {
+    return false;
+  }
+
+  if( rate == _resampler.inputRate() ) {
+    return true;
+  }
+
+  return drain()  &&
+      _resampler.initialize(_format.numChannels, rate, _format.numSamplesPerSecond);
+}
+
+bool ResamplingEncoder::encode(const void *data, const std::size_t size)
+{
+  if( !_is_initialized  ||  !isValidData(data, size) ) {
+    return false;
+  }
+
+  if( _resampler.isPassThrough() ) {
+    return _encoder->encode(data, size);
+  }
+
+  const std::size_t numFrames = size/_format.numBytesPerPcmFrame();
+  if( numFrames*_format.numBytesPerPcmFrame() != size ) {
+    return false;
+  }
+
+  if( !_resampler.process(_output, reinterpret_cast<const int16_t*>(data), numFrames) ) {
+    return false;
+  }
+
+  return _output.empty()  ||
+      _encoder->encode(_output.data(), _output.size()*sizeof(int16_t));
+}
+
+bool ResamplingEncoder::flush()
+{
+  if( !_is_initialized ) {
+    return false;
+  }
+  return drain()  &&  _encoder->flush();
+}
+
+bool ResamplingEncoder::initialize(const AacFormat& format, const std::filesystem::path& outputFileName)
+{
+  if( !prepare(format) ) {
+    return false;
+  }
+
+  if( !_encoder->initialize(format, outputFileName) ) {
+    _is_initialized = false;
+    return false;
+  }
+
+  return true;
+}
+
+bool ResamplingEncoder::initialize(const AacFormat& format, IAccessUnitSink *sink)
+{
+  if( !prepare(format) ) {
+    return false;
+  }
+
+  if( !_encoder->initialize(format, sink) ) {
+    _is_initialized = false;
+    return false;
+  }
+
+  return true;
+}
+
+uint64_t ResamplingEncoder::numPcmFrames() const
+{
+  return _encoder->numPcmFrames();
+}
+
+std::filesystem::path ResamplingEncoder::outputSuffix(const AacFormat& format) const
+{
+  return _encoder->outputSuffix(format);
+}
+
+std::string ResamplingEncoder::settings() const
+{
+  const std::string encoderSettings = _encoder->settings();
+  return !encoderSettings.empty()
+      ? cs::sprint("ResamplingEncoder;taps=%;phases=%;", Resampler::baseNumTaps, Resampler::maxNumPhases) +
+        encoderSettings
+      : std::string();
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool ResamplingEncoder::drain()
+{
+  if( _resampler.isPassThrough() ) {
+    return true;
+  }
+
+  if( !_resampler.flush(_output) ) {
+    return false;
+  }
+
+  return _output.empty()  ||
+      _encoder->encode(_output.data(), _output.size()*sizeof(int16_t));
+}
+
+bool ResamplingEncoder::prepare(const AacFormat& format)
+{
+  if( !_encoder  ||  _is_initialized  ||  !format.isValid() ) {
+    return false;
+  }
+
+  if( !_resampler.initialize(format.numChannels,
+                             format.numSamplesPerSecond, format.numSamplesPerSecond) ) {
+    return false;
+  }
+
+  _format         = format;
+  _is_initialized = true;
+
+  return true;
+}
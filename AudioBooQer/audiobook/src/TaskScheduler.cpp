@@ -0,0 +1,219 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include "TaskScheduler.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  thread_local const TaskScheduler *currentScheduler = nullptr;
+  thread_local std::size_t          currentWorker    = 0;
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+TaskScheduler::TaskScheduler(const std::size_t numThreads) noexcept
+{
+  const std::size_t numWorkers = numThreads > 0
+      ? numThreads
+      : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+  try {
+    _workers.reserve(numWorkers);
+    for(std::size_t i = 0; i < numWorkers; i++) {
+      _workers.push_back(std::make_unique<Worker>());
+    }
+  } catch(...) {
+  }
+
+  // NOTE: Workers without thread are drained by stealing.
+  for(std::size_t i = 0; i < _workers.size(); i++) {
+    try {
+      _workers[i]->thread = std::thread(&TaskScheduler::run, this, i);
+      _numThreads++;
+    } catch(...) {
+      break;
+    }
+  }
+}
+
+TaskScheduler::~TaskScheduler() noexcept
+{
+  wait();
+
+  {
+    const std::lock_guard<std::mutex> lock(_sleepMutex);
+    _quit = true;
+  }
+  _sleepCond.notify_all();
+
+  for(WorkerPtr& worker : _workers) {
+    if( worker->thread.joinable() ) {
+      worker->thread.join();
+    }
+  }
+}
+
+bool TaskScheduler::isWorkerThread() const
+{
+  return priv::currentScheduler == this;
+}
+
+std::size_t TaskScheduler::numThreads() const
+{
+  return _numThreads;
+}
+
+uint64_t TaskScheduler::numSteals() const
+{
+  return _numSteals;
+}
+
+bool TaskScheduler::submit(Task&& task)
+{
+  if( !task ) {
+    return false;
+  }
+
+  // NOTE: Without a thread, execute task synchronously.
+  if( _numThreads < 1 ) {
+    execute(task);
+    return true;
+  }
+
+  // (1) Select worker ///////////////////////////////////////////////////////
+
+  Worker& worker = isWorkerThread()
+      ? *_workers[priv::currentWorker]
+      : *_workers[_nextWorker++ % _workers.size()];
+
+  // (2) Queue task //////////////////////////////////////////////////////////
+
+  _numPending++;
+  try {
+    const std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  } catch(...) {
+    if( --_numPending == 0 ) {
+      const std::lock_guard<std::mutex> lock(_idleMutex);
+      _idleCond.notify_all();
+    }
+    return false;
+  }
+
+  // (3) Wake up one sleeping worker /////////////////////////////////////////
+
+  {
+    const std::lock_guard<std::mutex> lock(_sleepMutex);
+    _numQueued++;
+  }
+  _sleepCond.notify_one();
+
+  return true;
+}
+
+void TaskScheduler::wait()
+{
+  std::unique_lock<std::mutex> lock(_idleMutex);
+  _idleCond.wait(lock, [this]() -> bool { return _numPending == 0; });
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void TaskScheduler::execute(Task& task)
+{
+  try {
+    task();
+  } catch(...) {
+  }
+}
+
+bool TaskScheduler::pop(const std::size_t index, Task *task)
+{
+  Worker& worker = *_workers[index];
+
+  const std::lock_guard<std::mutex> lock(worker.mutex);
+  if( worker.tasks.empty() ) {
+    return false;
+  }
+  *task = std::move(worker.tasks.back());
+  worker.tasks.pop_back();
+
+  return true;
+}
+
+void TaskScheduler::run(const std::size_t index)
+{
+  priv::currentScheduler = this;
+  priv::currentWorker    = index;
+
+  while( true ) {
+    Task task;
+    if( pop(index, &task)  ||  steal(index, &task) ) {
+      _numQueued--;
+      execute(task);
+      task = nullptr; // NOTE: Release captured state before signalling idle!
+
+      if( --_numPending == 0 ) {
+        const std::lock_guard<std::mutex> lock(_idleMutex);
+        _idleCond.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_sleepMutex);
+    _sleepCond.wait(lock, [this]() -> bool { return _quit  ||  _numQueued > 0; });
+    if( _quit  &&  _numQueued == 0 ) { // NOTE: Finish all pending tasks before quitting!
+      return;
+    }
+  }
+}
+
+bool TaskScheduler::steal(const std::size_t index, Task *task)
+{
+  for(std::size_t i = 1; i < _workers.size(); i++) {
+    Worker& victim = *_workers[(index + i) % _workers.size()];
+
+    const std::lock_guard<std::mutex> lock(victim.mutex);
+    if( !victim.tasks.empty() ) {
+      *task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      _numSteals++;
+      return true;
+    }
+  }
+
+  return false;
+}
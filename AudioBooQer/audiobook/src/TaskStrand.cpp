@@ -0,0 +1,120 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include "TaskStrand.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+TaskStrand::TaskStrand(TaskScheduler *scheduler) noexcept
+  : _scheduler(scheduler)
+{
+}
+
+TaskStrand::~TaskStrand() noexcept
+{
+  wait();
+}
+
+bool TaskStrand::isIdle() const
+{
+  const std::lock_guard<std::mutex> lock(_mutex);
+  return !_isRunning;
+}
+
+std::size_t TaskStrand::numQueued() const
+{
+  const std::lock_guard<std::mutex> lock(_mutex);
+  return _tasks.size();
+}
+
+bool TaskStrand::post(Task&& task)
+{
+  if( !task ) {
+    return false;
+  }
+
+  // (1) Queue task //////////////////////////////////////////////////////////
+
+  bool is_started = false;
+  {
+    const std::lock_guard<std::mutex> lock(_mutex);
+    try {
+      _tasks.push_back(std::move(task));
+    } catch(...) {
+      return false;
+    }
+    if( !_isRunning ) {
+      _isRunning = is_started = true;
+    }
+  }
+
+  // (2) Schedule draining of queue //////////////////////////////////////////
+
+  if( is_started ) {
+    // NOTE: Without a scheduler, drain queue synchronously.
+    if( _scheduler == nullptr  ||
+        !_scheduler->submit([this]() -> void { drain(); }) ) {
+      drain();
+    }
+  }
+
+  return true;
+}
+
+void TaskStrand::wait()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _cond.wait(lock, [this]() -> bool { return !_isRunning; });
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void TaskStrand::drain()
+{
+  while( true ) {
+    Task task;
+    {
+      const std::lock_guard<std::mutex> lock(_mutex);
+      if( _tasks.empty() ) {
+        _isRunning = false;
+        _cond.notify_all();
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+
+    try {
+      task();
+    } catch(...) {
+    }
+  }
+}
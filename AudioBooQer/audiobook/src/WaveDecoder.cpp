@@ -0,0 +1,227 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <bit>
+
+#include "WaveDecoder.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  inline constexpr uint16_t WAVE_FORMAT_PCM        = 0x0001;
+  inline constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+  inline constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+  inline uint16_t readLE16(const uint8_t *data)
+  {
+    return uint16_t(data[0]) | uint16_t(data[1]) << 8;
+  }
+
+  inline uint32_t readLE32(const uint8_t *data)
+  {
+    return uint32_t(data[0]) | uint32_t(data[1]) << 8 |
+        uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+  }
+
+  inline bool isFourCC(const uint8_t *data, const char *fourcc)
+  {
+    return std::equal(data, data + 4, fourcc);
+  }
+
+  bool sampleFormat(pcm::SampleFormat *format, const uint16_t tag, const std::size_t size)
+  {
+    if(        tag == WAVE_FORMAT_PCM  &&  size == 2 ) {
+      *format = pcm::SampleFormat::Int16;
+    } else if( tag == WAVE_FORMAT_PCM  &&  size == 3 ) {
+      *format = pcm::SampleFormat::Int24;
+    } else if( tag == WAVE_FORMAT_PCM  &&  size == 4 ) {
+      *format = pcm::SampleFormat::Int32;
+    } else if( tag == WAVE_FORMAT_IEEE_FLOAT  &&  size == 4 ) {
+      *format = pcm::SampleFormat::Float32;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+WaveDecoder::WaveDecoder()
+  : _file()
+{
+}
+
+WaveDecoder::~WaveDecoder()
+{
+}
+
+void WaveDecoder::close()
+{
+  _file.close();
+  _buffer.clear();
+  _dither       = pcm::Dither();
+  _format       = AacFormat();
+  _isSwapped    = false;
+  _offset       = 0;
+  _sampleFormat = pcm::SampleFormat::Int16;
+  _samples      = std::span<const uint8_t>();
+}
+
+AacFormat WaveDecoder::format() const
+{
+  return _format;
+}
+
+bool WaveDecoder::isAtEnd() const
+{
+  return _offset >= _samples.size();
+}
+
+bool WaveDecoder::open(const std::filesystem::path& inputFileName)
+{
+  close();
+
+  if( !_file.open(inputFileName)  ||  !parse() ) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+std::span<const uint8_t> WaveDecoder::read(const std::size_t maxSize)
+{
+  if( isConverting() ) {
+    const std::size_t numBytesPerFrame = pcm::sampleSize(_sampleFormat)*_format.numChannels;
+    const std::size_t numFrames = std::min(maxSize/_format.numBytesPerPcmFrame(),
+                                           (_samples.size() - std::min(_offset, _samples.size()))/numBytesPerFrame);
+    const std::size_t numSamples = numFrames*_format.numChannels;
+
+    try {
+      _buffer.resize(numFrames*_format.numBytesPerPcmFrame());
+    } catch(...) {
+      return std::span<const uint8_t>();
+    }
+
+    pcm::convertToInt16(_buffer.data(), _samples.data() + _offset, numSamples,
+                        _sampleFormat, _isSwapped, _isDithered ? &_dither : nullptr);
+    _offset += numFrames*numBytesPerFrame;
+
+    return std::span<const uint8_t>(_buffer.data(), _buffer.size());
+  }
+
+  const std::size_t size = std::min(maxSize, _samples.size() - std::min(_offset, _samples.size()));
+  const std::span<const uint8_t> result = _samples.subspan(_offset, size);
+  _offset += size;
+  return result;
+}
+
+bool WaveDecoder::isConverting() const
+{
+  return _sampleFormat != pcm::SampleFormat::Int16  ||  _isSwapped;
+}
+
+void WaveDecoder::setDither(const bool on)
+{
+  _isDithered = on;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool WaveDecoder::parse()
+{
+  const uint8_t *data = _file.data();
+  const std::size_t size = _file.size();
+
+  // (1) RIFF header /////////////////////////////////////////////////////////
+
+  if( size < 12  ||  !priv::isFourCC(data, "RIFF")  ||  !priv::isFourCC(data + 8, "WAVE") ) {
+    return false;
+  }
+
+  // (2) Chunks //////////////////////////////////////////////////////////////
+
+  bool haveFormat = false;
+  for(std::size_t pos = 12; pos + 8 <= size; ) {
+    const uint8_t   *id = data + pos;
+    const std::size_t len = priv::readLE32(data + pos + 4);
+    const uint8_t *chunk = data + pos + 8;
+    const std::size_t avail = size - pos - 8;
+
+    if(        priv::isFourCC(id, "fmt ") ) {
+      if( len < 16  ||  len > avail ) {
+        return false;
+      }
+
+      uint16_t tag = priv::readLE16(chunk);
+      if( tag == priv::WAVE_FORMAT_EXTENSIBLE  &&  len >= 40 ) {
+        tag = priv::readLE16(chunk + 24); // SubFormat GUID
+      }
+
+      // NOTE: The container's size, i.e. valid bits are left-justified!
+      const uint16_t blockAlign = priv::readLE16(chunk + 12);
+
+      _format.numChannels         = priv::readLE16(chunk + 2);
+      _format.numSamplesPerSecond = priv::readLE32(chunk + 4);
+      _format.numBitsPerChannel   = 16;
+      if( !_format.isValidPcm()  ||  blockAlign%_format.numChannels != 0  ||
+          !priv::sampleFormat(&_sampleFormat, tag, blockAlign/_format.numChannels) ) {
+        return false;
+      }
+
+      _isSwapped = std::endian::native != std::endian::little;
+
+      haveFormat = true;
+
+    } else if( priv::isFourCC(id, "data") ) {
+      if( !haveFormat ) {
+        return false;
+      }
+
+      // NOTE: Streaming writers may leave the size unset; clamp to file!
+      std::size_t numBytes = std::min(len, avail);
+      numBytes -= numBytes%(pcm::sampleSize(_sampleFormat)*_format.numChannels);
+
+      _samples = std::span<const uint8_t>(chunk, numBytes);
+
+      return !_samples.empty();
+    }
+
+    // Chunks are padded to even sizes!
+    pos += 8 + len + (len & 1);
+  }
+
+  return false;
+}
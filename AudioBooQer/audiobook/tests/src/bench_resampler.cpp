@@ -0,0 +1,77 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <vector>
+
+#include "Resampler.h"
+
+namespace {
+
+  const char *kernelName(const ResamplerKernel kernel)
+  {
+    switch( kernel ) {
+    case ResamplerKernel::Scalar:
+      return "Scalar";
+    case ResamplerKernel::SSE2:
+      return "SSE2";
+    case ResamplerKernel::AVX2:
+      return "AVX2";
+    default:
+      break;
+    }
+    return "Auto";
+  }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  constexpr unsigned int numChannels = 2;
+  constexpr std::size_t    blockSize = 4096;
+
+  const unsigned int  inputRate = argc > 1 ? unsigned(std::atoi(argv[1])) : 48000;
+  const unsigned int outputRate = argc > 2 ? unsigned(std::atoi(argv[2])) : 44100;
+  const unsigned int    seconds = argc > 3 ? unsigned(std::atoi(argv[3])) : 600;
+
+  // (1) Test signal /////////////////////////////////////////////////////////
+
+  const std::size_t numFrames = std::size_t(inputRate)*seconds;
+  std::vector<int16_t> input(numFrames*numChannels);
+  for(std::size_t i = 0; i < numFrames; i++) {
+    const double t = double(i)/double(inputRate);
+    input[i*numChannels]     = int16_t(8000*std::sin(2*3.14159265358979*440*t));
+    input[i*numChannels + 1] = int16_t(8000*std::sin(2*3.14159265358979*1000*t));
+  }
+
+  // (2) Throughput per kernel ///////////////////////////////////////////////
+
+  for(const ResamplerKernel kernel : {ResamplerKernel::Scalar, ResamplerKernel::SSE2, ResamplerKernel::AVX2}) {
+    Resampler resampler;
+    if( !resampler.initialize(numChannels, inputRate, outputRate, kernel) ) {
+      printf("%-6s: not supported\n", kernelName(kernel));
+      continue;
+    }
+
+    std::vector<int16_t> output;
+    std::size_t numOutputFrames = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < numFrames; i += blockSize) {
+      const std::size_t size = std::min(blockSize, numFrames - i);
+      resampler.process(output, input.data() + i*numChannels, size);
+      numOutputFrames += output.size()/numChannels;
+    }
+    resampler.flush(output);
+    numOutputFrames += output.size()/numChannels;
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    printf("%-6s: %uHz -> %uHz, %zu taps, %zu frames, %.3fs, %.1f MFrames/s, %.0fx realtime\n",
+           kernelName(kernel), inputRate, outputRate, resampler.numTaps(), numOutputFrames,
+           elapsed.count(), double(numFrames)/elapsed.count()/1e6,
+           double(seconds)/elapsed.count());
+  }
+
+  return EXIT_SUCCESS;
+}
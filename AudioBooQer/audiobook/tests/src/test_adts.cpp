@@ -1,15 +1,17 @@
 #include <cstdio>
 #include <cstdlib>
 
-#include <csUtil/csFileIO.h>
-
 #include "AdtsParser.h"
+#include "MappedFile.h"
 #include "Mpeg4Audio.h"
 
-int main(int /*argc*/, char **argv)
+int main(int argc, char **argv)
 {
-  AdtsParser::Buffer buf = csReadBinaryFile(argv[1]);
-  AdtsParser p(std::move(buf));
+  MappedFile file;
+  if( argc < 2  ||  !file.open(argv[1]) ) {
+    return EXIT_FAILURE;
+  }
+  AdtsParser p(file.span());
 
   uint32_t i = 0;
   while( p.hasFrame() ) {
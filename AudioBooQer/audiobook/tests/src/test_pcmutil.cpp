@@ -0,0 +1,307 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <vector>
+
+#include "PcmUtil.h"
+
+namespace {
+
+  // NOTE: Scalar reference of pcm::convertToInt16(), one sample at a time.
+
+  uint32_t nextRandom(uint32_t& state)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  uint32_t load32(const uint8_t *data, const bool swapBytes)
+  {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return swapBytes
+        ? (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24)
+        : value;
+  }
+
+  int32_t referenceSample(const uint8_t *data, const pcm::SampleFormat format, const bool swapBytes)
+  {
+    if(        format == pcm::SampleFormat::Int24 ) {
+      const bool isLittle = (std::endian::native == std::endian::little) != swapBytes;
+      const uint32_t value = isLittle
+          ? uint32_t(data[0])       | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16
+          : uint32_t(data[0]) << 16 | uint32_t(data[1]) << 8 | uint32_t(data[2]);
+      return int32_t(value << 8) >> 8;
+
+    } else if( format == pcm::SampleFormat::Int32 ) {
+      return int32_t(load32(data, swapBytes)) >> 8;
+
+    } else if( format == pcm::SampleFormat::Float32 ) {
+      const float value = std::bit_cast<float>(load32(data, swapBytes));
+      if( std::isnan(value) ) {
+        return int32_t(-2.0f*8388608.0f);
+      }
+      return int32_t(std::lrintf(std::clamp(value, -2.0f, 2.0f)*8388608.0f));
+    }
+
+    return 0;
+  }
+
+  void referenceConvert(int16_t *dest, const uint8_t *src, const std::size_t numSamples,
+                        const pcm::SampleFormat format, const bool swapBytes,
+                        pcm::Dither *dither)
+  {
+    if( format == pcm::SampleFormat::Int16 ) {
+      for(std::size_t i = 0; i < numSamples; i++) {
+        uint16_t value;
+        std::memcpy(&value, src + 2*i, sizeof(value));
+        dest[i] = int16_t(swapBytes
+                          ? uint16_t(value >> 8 | value << 8)
+                          : value);
+      }
+      return;
+    }
+
+    const std::size_t size = pcm::sampleSize(format);
+    for(std::size_t i = 0; i < numSamples; i++) {
+      int32_t noise = 0;
+      if( dither != nullptr ) {
+        const uint32_t random = nextRandom(dither->state[dither->lane]);
+        noise = int32_t(random & 0xFF) - int32_t((random >> 8) & 0xFF);
+        dither->lane = (dither->lane + 1) % 4;
+      }
+      const int32_t sample = referenceSample(src + i*size, format, swapBytes);
+      dest[i] = int16_t(std::clamp<int32_t>((sample + noise + 128) >> 8,
+                                            std::numeric_limits<int16_t>::min(),
+                                            std::numeric_limits<int16_t>::max()));
+    }
+  }
+
+  std::vector<uint8_t> makeInput(const std::size_t numSamples, const pcm::SampleFormat format)
+  {
+    const std::size_t size = pcm::sampleSize(format);
+    std::vector<uint8_t> result(numSamples*size);
+
+    uint32_t state = 0x12345678;
+    for(std::size_t i = 0; i < numSamples; i++) {
+      uint32_t value = nextRandom(state);
+      if( format == pcm::SampleFormat::Float32 ) {
+        // NOTE: Full scale is +/-1.0; also test clipping, NaN and infinity.
+        const float x = i % 97 == 0
+            ? std::numeric_limits<float>::quiet_NaN()
+            : i % 89 == 0
+              ? std::numeric_limits<float>::infinity()
+              : float(int32_t(value))/float(1 << 30);
+        value = std::bit_cast<uint32_t>(x);
+      }
+      std::memcpy(result.data() + i*size, &value, size);
+    }
+
+    return result;
+  }
+
+  const char *formatName(const pcm::SampleFormat format)
+  {
+    switch( format ) {
+    case pcm::SampleFormat::Int16:
+      return "Int16";
+    case pcm::SampleFormat::Int24:
+      return "Int24";
+    case pcm::SampleFormat::Int32:
+      return "Int32";
+    case pcm::SampleFormat::Float32:
+      return "Float32";
+    default:
+      break;
+    }
+    return "?";
+  }
+
+  bool testConvert(const pcm::SampleFormat format, const std::size_t numSamples,
+                   const bool swapBytes, const bool isDithered)
+  {
+    const std::size_t size = pcm::sampleSize(format);
+
+    // NOTE: Exactly sized; i.e. reading beyond the samples is caught by ASan.
+    const std::vector<uint8_t> input = makeInput(numSamples, format);
+
+    // (1) Reference /////////////////////////////////////////////////////////
+
+    pcm::Dither refDither(7);
+    std::vector<int16_t> expected(numSamples);
+    referenceConvert(expected.data(), input.data(), numSamples, format, swapBytes,
+                     isDithered ? &refDither : nullptr);
+
+    // (2) Out of place //////////////////////////////////////////////////////
+
+    pcm::Dither dither(7);
+    std::vector<int16_t> output(numSamples);
+    pcm::convertToInt16(output.data(), input.data(), numSamples, format, swapBytes,
+                        isDithered ? &dither : nullptr);
+    bool ok = output == expected;
+
+    // (3) In place //////////////////////////////////////////////////////////
+
+    pcm::Dither inPlaceDither(7);
+    std::vector<uint8_t> inPlace = input;
+    pcm::convertToInt16(inPlace.data(), inPlace.data(), numSamples, format, swapBytes,
+                        isDithered ? &inPlaceDither : nullptr);
+    ok = ok  &&  std::memcmp(inPlace.data(), expected.data(), numSamples*sizeof(int16_t)) == 0;
+
+    // (4) Odd blocks continue the dither lanes //////////////////////////////
+
+    pcm::Dither blockDither(7);
+    std::vector<int16_t> blocks(numSamples);
+    for(std::size_t i = 0, n = 1; i < numSamples; i += n, n += 2) {
+      n = std::min(n, numSamples - i);
+      const std::vector<uint8_t> block(input.begin() + i*size, input.begin() + (i + n)*size);
+      pcm::convertToInt16(blocks.data() + i, block.data(), n, format, swapBytes,
+                          isDithered ? &blockDither : nullptr);
+    }
+    ok = ok  &&  blocks == expected;
+
+    if( !ok ) {
+      printf("convertToInt16(%s, n=%zu, swap=%d, dither=%d): FAILED\n",
+             formatName(format), numSamples, int(swapBytes), int(isDithered));
+    }
+
+    return ok;
+  }
+
+  bool testDownmix(const std::size_t numFrames)
+  {
+    const std::vector<uint8_t> bytes = makeInput(2*numFrames, pcm::SampleFormat::Int16);
+    std::vector<int16_t> input(2*numFrames);
+    std::memcpy(input.data(), bytes.data(), bytes.size());
+
+    std::vector<int16_t> expected(numFrames);
+    for(std::size_t i = 0; i < numFrames; i++) {
+      expected[i] = int16_t((int32_t(input[2*i]) + int32_t(input[2*i + 1])) >> 1);
+    }
+
+    std::vector<int16_t> output(numFrames);
+    pcm::downmixStereo(output.data(), input.data(), numFrames);
+
+    // NOTE: In place, i.e. 'dest' == 'src', works as well.
+    pcm::downmixStereo(input.data(), input.data(), numFrames);
+    input.resize(numFrames);
+
+    const bool ok = output == expected  &&  input == expected;
+    if( !ok ) {
+      printf("downmixStereo(n=%zu): FAILED\n", numFrames);
+    }
+
+    return ok;
+  }
+
+  bool testStatistics(const std::size_t numFrames, const bool isDualMono)
+  {
+    const std::vector<uint8_t> bytes = makeInput(2*numFrames, pcm::SampleFormat::Int16);
+    std::vector<int16_t> input(2*numFrames);
+    std::memcpy(input.data(), bytes.data(), bytes.size());
+    for(std::size_t i = 0; i < numFrames; i++) {
+      if( i % 13 == 0 ) {
+        input[2*i] = std::numeric_limits<int16_t>::min();
+      }
+      if( isDualMono ) {
+        input[2*i + 1] = input[2*i];
+      }
+    }
+
+    // (1) Reference /////////////////////////////////////////////////////////
+
+    pcm::StereoStatistics expected;
+    for(std::size_t i = 0; i < numFrames; i++) {
+      const int32_t  left = int32_t(input[2*i]) >> 1;
+      const int32_t right = int32_t(input[2*i + 1]) >> 1;
+      expected.sumCross += int64_t(left*right);
+      expected.sumLeft  += uint64_t(left*left);
+      expected.sumRight += uint64_t(right*right);
+    }
+    expected.numFrames = numFrames;
+
+    // (2) At once and split into odd blocks /////////////////////////////////
+
+    pcm::StereoStatistics once;
+    once.accumulate(input.data(), numFrames);
+
+    pcm::StereoStatistics blocks;
+    for(std::size_t i = 0, n = 1; i < numFrames; i += n, n += 2) {
+      n = std::min(n, numFrames - i);
+      blocks.accumulate(input.data() + 2*i, n);
+    }
+
+    const auto isEqual = [&](const pcm::StereoStatistics& stats) -> bool {
+      return stats.sumCross  == expected.sumCross  &&
+          stats.sumLeft   == expected.sumLeft   &&
+          stats.sumRight  == expected.sumRight  &&
+          stats.numFrames == expected.numFrames;
+    };
+
+    bool ok = isEqual(once)  &&  isEqual(blocks);
+    if( numFrames > 0 ) {
+      ok = ok  &&  once.isDualMono(-40) == isDualMono;
+    }
+
+    if( !ok ) {
+      printf("StereoStatistics::accumulate(n=%zu, dualMono=%d): FAILED\n",
+             numFrames, int(isDualMono));
+    }
+
+    return ok;
+  }
+
+} // namespace
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+  const std::size_t lengths[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 1001, 4099};
+
+  bool ok = true;
+
+  // (1) Requantization //////////////////////////////////////////////////////
+
+  for(const pcm::SampleFormat format : {pcm::SampleFormat::Int24, pcm::SampleFormat::Int32,
+      pcm::SampleFormat::Float32}) {
+    for(const std::size_t numSamples : lengths) {
+      for(const bool swapBytes : {false, true}) {
+        for(const bool isDithered : {false, true}) {
+          ok = testConvert(format, numSamples, swapBytes, isDithered)  &&  ok;
+        }
+      }
+    }
+  }
+
+  // (2) Int16 is only byte swapped //////////////////////////////////////////
+
+  for(const std::size_t numSamples : lengths) {
+    for(const bool swapBytes : {false, true}) {
+      ok = testConvert(pcm::SampleFormat::Int16, numSamples, swapBytes, false)  &&  ok;
+    }
+  }
+
+  // (3) Stereo -> Mono //////////////////////////////////////////////////////
+
+  for(const std::size_t numFrames : lengths) {
+    ok = testDownmix(numFrames)  &&  ok;
+  }
+
+  // (4) Side level //////////////////////////////////////////////////////////
+
+  for(const std::size_t numFrames : lengths) {
+    for(const bool isDualMono : {false, true}) {
+      ok = testStatistics(numFrames, isDualMono)  &&  ok;
+    }
+  }
+
+  printf("%s\n", ok ? "OK" : "FAILED");
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,224 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <vector>
+
+#include "AdtsParser.h"
+
+namespace {
+
+  using size_type = AdtsParser::size_type;
+
+  // NOTE: Scalar reference of AdtsParser::resync(), one byte at a time.
+
+  // 0xFFF, layer 0
+  constexpr uint64_t syncMask = 0xFFF6000000000000;
+  constexpr uint64_t syncWord = 0xFFF0000000000000;
+
+  uint64_t headerAt(const std::vector<uint8_t>& data, const size_type offset)
+  {
+    uint64_t header = 0;
+    for(size_type i = 0; i < 8; i++) {
+      header = header << 8 | data[offset + i];
+    }
+    return header;
+  }
+
+  // NOTE: Valid frequency index; the length exceeds the header (w/ CRC: 9).
+  bool isValidHeader(const uint64_t header)
+  {
+    if( (header & syncMask) != syncWord  ||  ((header >> 42) & 0xF) >= 13 ) {
+      return false;
+    }
+
+    const size_type length = (header >> 21) & 0x1FFF;
+    return length > ((header >> 48) & 1 ? 7 : 9);
+  }
+
+  bool isCandidate(const std::vector<uint8_t>& data, const size_type offset,
+                   const bool isEndOfData)
+  {
+    if( offset + 8 > data.size() ) {
+      return !isEndOfData;
+    }
+    const uint64_t header = headerAt(data, offset);
+
+    if( !isValidHeader(header) ) {
+      return false;
+    }
+    const size_type length = (header >> 21) & 0x1FFF;
+
+    const size_type next = offset + length;
+    if( next > data.size() ) {
+      return !isEndOfData;
+    }
+    if( next + 8 > data.size() ) {
+      return true;
+    }
+
+    constexpr uint64_t fixedHeader = 0xFFFFFDC000000000;
+    return (headerAt(data, next) & fixedHeader) == (header & fixedHeader);
+  }
+
+  size_type referenceResync(const std::vector<uint8_t>& data, const bool isEndOfData)
+  {
+    const size_type size = data.size();
+
+    // (1) A frame at the start is kept //////////////////////////////////////
+
+    if( size >= 8 ) {
+      const uint64_t header = headerAt(data, 0);
+      if( isValidHeader(header)  &&  ((header >> 21) & 0x1FFF) <= size ) {
+        return 0;
+      }
+    }
+
+    // (2) Skip to the first candidate ///////////////////////////////////////
+
+    for(size_type pos = 0; pos < size; pos++) {
+      const bool isSync = pos + 1 < size
+          ? data[pos] == 0xFF  &&  (data[pos + 1] & 0xF6) == 0xF0
+          : data[pos] == 0xFF; // cf. findSync()
+      if( isSync  &&  isCandidate(data, pos, isEndOfData) ) {
+        return pos;
+      }
+    }
+
+    return size;
+  }
+
+  uint32_t nextRandom(uint32_t& state)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  // NOTE: MPEG-4 AAC LC, 44.1kHz, stereo, w/o CRC.
+  void putHeader(std::vector<uint8_t>& data, const size_type offset, const size_type length)
+  {
+    const uint8_t header[7] = {
+      0xFF, 0xF1, 0x50, uint8_t(0x80 | ((length >> 11) & 0x3)),
+      uint8_t(length >> 3), uint8_t(((length & 0x7) << 5) | 0x1F), 0xFC
+    };
+    for(size_type i = 0; i < 7  &&  offset + i < data.size(); i++) {
+      data[offset + i] = header[i];
+    }
+  }
+
+  std::vector<uint8_t> makeData(uint32_t& state, const size_type size)
+  {
+    std::vector<uint8_t> result(size);
+
+    // NOTE: Biased towards (partial) sync words.
+    for(uint8_t& byte : result) {
+      const uint32_t random = nextRandom(state);
+      byte = random % 4 == 0
+          ? 0xFF
+          : random % 4 == 1
+            ? uint8_t(0xF0 | ((random >> 8) & 0x0F))
+            : uint8_t(random >> 8);
+    }
+
+    // NOTE: Frames around the SSE2 and AVX2 block boundaries; some of them
+    //       with a corrupted length, i.e. not exceeding the header.
+    const uint32_t numFrames = nextRandom(state) % 4;
+    for(uint32_t i = 0; i < numFrames  &&  size > 0; i++) {
+      const size_type offset = nextRandom(state) % size;
+      const size_type length = nextRandom(state) % 8 == 0
+          ? nextRandom(state) % 8
+          : 8 + nextRandom(state) % 64;
+      putHeader(result, offset, length);
+      if( nextRandom(state) % 2 == 0 ) {
+        putHeader(result, offset + length, 8 + nextRandom(state) % 64);
+      }
+    }
+
+    return result;
+  }
+
+  /*
+   * NOTE:
+   * A corrupted length of at most the header's size must neither be passed
+   * on as a frame (frameSize() would underflow), nor stall nextFrame().
+   */
+  bool testCorruptedLength(const size_type length)
+  {
+    constexpr size_type frameLength = 32;
+
+    std::vector<uint8_t> data(7 + 3*frameLength, 0x00);
+    putHeader(data, 0, length);
+    for(size_type i = 0; i < 3; i++) {
+      putHeader(data, 7 + i*frameLength, frameLength);
+    }
+
+    AdtsParser parser(data.data(), data.size());
+    const bool isSkipped = !parser.hasFrame()  &&  parser.frameSize() == 0  &&
+        parser.frameData() == nullptr;
+
+    size_type numFrames = 0;
+    size_type numSkipped = 0;
+    for(size_type skipped = 0; parser.hasFrame()  ||  parser.resync(&skipped); parser.nextFrame()) {
+      numFrames++;
+      numSkipped += skipped;
+      skipped = 0;
+      if( parser.frameSize() != frameLength - 7  ||  numFrames > 3 ) {
+        break;
+      }
+    }
+
+    const bool ok = isSkipped  &&  numFrames == 3  &&  numSkipped == 7  &&
+        parser.offset() == data.size();
+    if( !ok ) {
+      printf("corrupted length %zu: frames %zu, skipped %zu\n",
+             std::size_t(length), std::size_t(numFrames), std::size_t(numSkipped));
+    }
+
+    return ok;
+  }
+
+} // namespace
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+  constexpr int numTests = 200000;
+
+  int numFailed = 0;
+
+  // (1) Corrupted lengths ///////////////////////////////////////////////////
+
+  for(size_type length = 0; length <= 7; length++) {
+    if( !testCorruptedLength(length) ) {
+      numFailed++;
+    }
+  }
+
+  // (2) Random data vs. reference ///////////////////////////////////////////
+
+  uint32_t state = 0x12345678;
+  for(int i = 0; i < numTests; i++) {
+    const size_type size = nextRandom(state) % 160;
+    const std::vector<uint8_t> data = makeData(state, size);
+
+    // NOTE: Exactly sized; i.e. reading beyond the data is caught by ASan.
+    for(const bool isEndOfData : {true, false}) {
+      AdtsParser parser(data.data(), data.size());
+      size_type numSkipped = 0;
+      const bool hasFrame = parser.resync(&numSkipped, isEndOfData);
+
+      const size_type expected = referenceResync(data, isEndOfData);
+      if( numSkipped != expected  ||  parser.offset() != expected  ||
+          hasFrame != parser.hasFrame() ) {
+        printf("resync(size=%zu, isEndOfData=%d): skipped %zu, expected %zu\n",
+               std::size_t(size), int(isEndOfData),
+               std::size_t(numSkipped), std::size_t(expected));
+        numFailed++;
+      }
+    }
+  }
+
+  printf("%s\n", numFailed == 0 ? "OK" : "FAILED");
+
+  return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,5 +1,5 @@
 /****************************************************************************
-** Copyright (c) 2019, Carsten Schmidt. All rights reserved.
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
 **
 ** Redistribution and use in source and binary forms, with or without
 ** modification, are permitted provided that the following conditions
@@ -29,45 +29,36 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
-#ifndef AUDIOJOB_H
-#define AUDIOJOB_H
 
-#include <QtMultimedia/QAudioDecoder>
+#ifndef CONSOLELOGGER_H
+#define CONSOLELOGGER_H
 
-#include "IAudioEncoder.h"
-#include "Job.h"
+#include <cstdio>
 
-class AudioJob : public QObject {
-  Q_OBJECT
-public:
-  AudioJob(const Job& job, QObject *parent = nullptr);
-  ~AudioJob();
+#include <mutex>
 
-  const IAudioEncoder *encoder() const;
+#include <cs/Logging/ILogger.h>
 
-  QString outputFilePath() const;
+/*
+ * NOTE:
+ * Messages are written to stderr, keeping stdout free for progress events.
+ * AudioJobs log from the TaskScheduler's workers; thus, output is serialized.
+ */
 
-  bool start();
+class ConsoleLogger : public cs::ILogger {
+public:
+  ConsoleLogger(std::FILE *file = stderr);
+  ~ConsoleLogger();
 
-private slots:
-  void decodingBufferReady();
-  void decodingError(QAudioDecoder::Error error);
-  void decodingFinished();
+  void logText(const std::u8string& msg) const override;
+  void logWarning(const std::u8string& msg) const override;
+  void logError(const std::u8string& msg) const override;
 
 private:
-  void appendInfoMessage(const QString& msg);
-  QString closeInput();
-  QString inputFileName() const;
-  bool startDecode();
-
-  QAudioDecoder _decoder;
-  AudioEncoderPtr _encoder;
-  Job _job;
-  QString _message;
-  QString _outputFilePath;
+  void print(const char *prefix, const std::u8string& msg) const;
 
-signals:
-  void done();
+  std::FILE *_file;
+  mutable std::mutex _mutex;
 };
 
-#endif // AUDIOJOB_H
+#endif // CONSOLELOGGER_H
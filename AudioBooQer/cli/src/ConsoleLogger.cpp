@@ -0,0 +1,72 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+#include "ConsoleLogger.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+ConsoleLogger::ConsoleLogger(std::FILE *file)
+  : _file(file)
+  , _mutex()
+{
+}
+
+ConsoleLogger::~ConsoleLogger()
+{
+}
+
+void ConsoleLogger::logText(const std::u8string& msg) const
+{
+  print("", msg);
+}
+
+void ConsoleLogger::logWarning(const std::u8string& msg) const
+{
+  print("WARNING: ", msg);
+}
+
+void ConsoleLogger::logError(const std::u8string& msg) const
+{
+  print("ERROR: ", msg);
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void ConsoleLogger::print(const char *prefix, const std::u8string& msg) const
+{
+  const char *text = reinterpret_cast<const char*>(msg.data());
+  const bool has_newline = !msg.empty()  &&  msg.back() == u8'\n';
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::fprintf(_file, has_newline ? "%s%s" : "%s%s\n", prefix, text);
+  std::fflush(_file);
+}
@@ -0,0 +1,526 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <vector>
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QRegExp>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+
+#include <cs/Core/QStringUtil.h>
+#include <cs/Logging/OutputContext.h>
+
+#include "ConsoleLogger.h"
+
+#include "BinderIO.h"
+#include "EncodeCache.h"
+#include "JobBuilder.h"
+#include "JobManifest.h"
+#include "JobRunner.h"
+#include "Mp4Tag.h"
+#include "Output.h"
+#include "ParallelAacEncoder.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  enum ExitCode : int {
+    Success = 0,
+    Failure = 1,
+    Usage   = 2
+  };
+
+  struct Options {
+    Options() = default;
+
+    QString     cacheDirPath{};
+    uint64_t    cacheSize{EncodeCache::defaultMaxSize};
+    bool        detectDualMono{false};
+    int         firstChapterNo{1};
+    AacFormat   format{};
+    QString     inputPath{};
+    QString     language{};
+    bool        nativeRate{false};
+    bool        numbered{false};
+    int         numThreads{1};
+    QString     outputFilename{};
+    bool        renameInput{false};
+    Mp4Tag      tag{};
+    bool        useCache{false};
+    JobVariants variants{};
+    int         widthChapterNo{2};
+    QString     workDirPath{};
+  };
+
+  struct Book {
+    Book() = default;
+
+    BookBinder binder{};
+    QString    filename{};
+    AacProfile profile{AacProfile::AAC_LC};
+  };
+
+  using Books = std::vector<Book>;
+
+  // NOTE: Progress is machine-readable; one JSON object per line on stdout.
+  void emitEvent(const QString& event, QJsonObject obj)
+  {
+    obj.insert(QStringLiteral("event"), event);
+    const QByteArray line = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    std::fprintf(stdout, "%s\n", line.constData());
+    std::fflush(stdout);
+  }
+
+  QString variantBookName(const QString& filename, const QString& name)
+  {
+    const QFileInfo info(filename);
+    return info.dir().absoluteFilePath(QStringLiteral("%1_%2.%3")
+                                       .arg(info.completeBaseName())
+                                       .arg(name)
+                                       .arg(info.suffix()));
+  }
+
+  bool parseProfile(AacProfile& profile, const QString& name)
+  {
+    if(        name == QStringLiteral("lc") ) {
+      profile = AacProfile::AAC_LC;
+    } else if( name == QStringLiteral("he") ) {
+      profile = AacProfile::HE_AAC;
+    } else if( name == QStringLiteral("hev2") ) {
+      profile = AacProfile::HE_AACv2;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  // NOTE: A variant is specified as "<name>:<channels>:<bit rate>[:<profile>]", e.g. "mono32k:1:32000:he".
+  bool parseVariant(JobVariants& variants, const QString& spec)
+  {
+    const QStringList parts = spec.split(QChar::fromLatin1(':'));
+    if( parts.size() != 3  &&  parts.size() != 4 ) {
+      return false;
+    }
+
+    JobVariant variant;
+    variant.name        = parts[0];
+    variant.numChannels = parts[1].toUInt();
+    variant.bitRate     = parts[2].toUInt();
+    if( parts.size() == 4  &&  !parseProfile(variant.profile, parts[3]) ) {
+      return false;
+    }
+
+    if( variant.name.isEmpty()  ||
+        variant.name.contains(QRegExp(QStringLiteral("[^-_0-9a-zA-Z]")))  ||
+        variant.numChannels < 1  ||  variant.numChannels > 2  ||  variant.bitRate < 1 ) {
+      return false;
+    }
+
+    for(const JobVariant& other : variants) {
+      if( other.name == variant.name ) {
+        return false;
+      }
+    }
+
+    variants.push_back(variant);
+
+    return true;
+  }
+
+  bool parseOptions(Options& opts, const QStringList& arguments)
+  {
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Headless audiobook conversion; progress is written to stdout as JSON lines."));
+    parser.addHelpOption();
+
+    parser.addPositionalArgument(QStringLiteral("input"),
+                                 QStringLiteral("Directory of audio files or binder XML."));
+    parser.addPositionalArgument(QStringLiteral("output"),
+                                 QStringLiteral("Audiobook (*.m4b) to create."));
+
+    const QCommandLineOption authorOption(QStringLiteral("author"),
+                                          QStringLiteral("Author's tag."), QStringLiteral("text"));
+    const QCommandLineOption bitRateOption(QStringLiteral("bitrate"),
+                                           QStringLiteral("Bit rate [bit/s] in CBR mode (default: 64000)."), QStringLiteral("bps"), QStringLiteral("64000"));
+    const QCommandLineOption cacheOption(QStringLiteral("cache"),
+                                         QStringLiteral("Reuse cached encodings and cache new ones."));
+    const QCommandLineOption cacheDirOption(QStringLiteral("cache-dir"),
+                                            QStringLiteral("Directory of the encode cache."), QStringLiteral("dir"));
+    const QCommandLineOption cacheSizeOption(QStringLiteral("cache-size"),
+                                             QStringLiteral("Size limit of the encode cache [MiB] (default: 2048)."), QStringLiteral("mib"), QStringLiteral("2048"));
+    const QCommandLineOption channelsOption(QStringLiteral("channels"),
+                                            QStringLiteral("Number of channels (default: 2)."), QStringLiteral("n"), QStringLiteral("2"));
+    const QCommandLineOption coverOption(QStringLiteral("cover"),
+                                         QStringLiteral("Cover image (*.jpg, *.png)."), QStringLiteral("file"));
+    const QCommandLineOption dualMonoOption(QStringLiteral("dual-mono"),
+                                            QStringLiteral("Encode the book as Mono, if all chapters are dual-mono."));
+    const QCommandLineOption firstOption(QStringLiteral("first-chapter"),
+                                         QStringLiteral("Number of the first chapter (default: 1)."), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption genreOption(QStringLiteral("genre"),
+                                         QStringLiteral("Genre's tag."), QStringLiteral("text"));
+    const QCommandLineOption languageOption(QStringLiteral("language"),
+                                            QStringLiteral("Chapters' language (ISO 639-2/T)."), QStringLiteral("code"));
+    const QCommandLineOption nativeRateOption(QStringLiteral("native-rate"),
+                                              QStringLiteral("Keep the inputs' sampling rate, if supported."));
+    const QCommandLineOption numberedOption(QStringLiteral("numbered"),
+                                            QStringLiteral("Prefix chapters' titles with their number."));
+    const QCommandLineOption profileOption(QStringLiteral("profile"),
+                                           QStringLiteral("AAC profile: lc, he, hev2 (default: lc)."), QStringLiteral("name"), QStringLiteral("lc"));
+    const QCommandLineOption rateOption(QStringLiteral("rate"),
+                                        QStringLiteral("Sampling rate [Hz] (default: 22050)."), QStringLiteral("hz"), QStringLiteral("22050"));
+    const QCommandLineOption renameOption(QStringLiteral("rename-input"),
+                                          QStringLiteral("Rename input files to *.done after encoding."));
+    const QCommandLineOption threadsOption({QStringLiteral("j"), QStringLiteral("threads")},
+                                           QStringLiteral("Number of threads (default: all cores)."), QStringLiteral("n"),
+                                           QString::number(std::max<int>(1, QThread::idealThreadCount())));
+    const QCommandLineOption titleOption(QStringLiteral("title"),
+                                         QStringLiteral("Title's tag."), QStringLiteral("text"));
+    const QCommandLineOption variantOption(QStringLiteral("variant"),
+                                           QStringLiteral("Additional quality level; one decode pass feeds all variants (repeatable)."),
+                                           QStringLiteral("name:channels:bitrate[:profile]"));
+    const QCommandLineOption vbrOption(QStringLiteral("vbr"),
+                                       QStringLiteral("VBR mode 1 (lowest) to 5 (highest); 0 selects CBR (default: 0)."), QStringLiteral("mode"), QStringLiteral("0"));
+    const QCommandLineOption widthOption(QStringLiteral("number-width"),
+                                         QStringLiteral("Width of chapters' numbers (default: 2)."), QStringLiteral("n"), QStringLiteral("2"));
+    const QCommandLineOption workDirOption(QStringLiteral("work-dir"),
+                                           QStringLiteral("Directory of encoded chapters (default: input directory)."), QStringLiteral("dir"));
+
+    parser.addOptions({authorOption, bitRateOption, cacheOption, cacheDirOption, cacheSizeOption,
+                       channelsOption, coverOption, dualMonoOption, firstOption, genreOption,
+                       languageOption, nativeRateOption, numberedOption, profileOption, rateOption,
+                       renameOption, threadsOption, titleOption, variantOption, vbrOption,
+                       widthOption, workDirOption});
+
+    parser.process(arguments);
+
+    const QStringList positional = parser.positionalArguments();
+    if( positional.size() != 2 ) {
+      std::fprintf(stderr, "%s", qPrintable(parser.helpText()));
+      return false;
+    }
+
+    opts.cacheDirPath   = parser.value(cacheDirOption);
+    opts.cacheSize      = parser.value(cacheSizeOption).toULongLong()*1024*1024;
+    opts.detectDualMono = parser.isSet(dualMonoOption);
+    opts.firstChapterNo = parser.value(firstOption).toInt();
+    opts.inputPath      = QFileInfo(positional[0]).absoluteFilePath();
+    opts.language       = parser.value(languageOption);
+    opts.nativeRate     = parser.isSet(nativeRateOption);
+    opts.numbered       = parser.isSet(numberedOption);
+    opts.numThreads     = std::max<int>(1, parser.value(threadsOption).toInt());
+    opts.outputFilename = QFileInfo(positional[1]).absoluteFilePath();
+    opts.renameInput    = parser.isSet(renameOption);
+    opts.useCache       = parser.isSet(cacheOption);
+    opts.widthChapterNo = std::max<int>(1, parser.value(widthOption).toInt());
+    opts.workDirPath    = parser.value(workDirOption);
+
+    opts.format.bitRate             = parser.value(bitRateOption).toUInt();
+    opts.format.bitRateMode         = parser.value(vbrOption).toUInt();
+    opts.format.numBitsPerChannel   = 16;
+    opts.format.numChannels         = parser.value(channelsOption).toUInt();
+    opts.format.numSamplesPerSecond = parser.value(rateOption).toUInt();
+
+    if( !parseProfile(opts.format.profile, parser.value(profileOption)) ) {
+      std::fprintf(stderr, "ERROR: Invalid profile \"%s\"!\n", qPrintable(parser.value(profileOption)));
+      return false;
+    }
+
+    opts.tag.title              = cs::toUtf8String(parser.value(titleOption));
+    opts.tag.author             = cs::toUtf8String(parser.value(authorOption));
+    opts.tag.genre              = cs::toUtf8String(parser.value(genreOption));
+    opts.tag.coverImageFilePath = cs::toPath(parser.value(coverOption));
+
+    for(const QString& spec : parser.values(variantOption)) {
+      if( !parseVariant(opts.variants, spec) ) {
+        std::fprintf(stderr, "ERROR: Invalid variant \"%s\"!\n", qPrintable(spec));
+        return false;
+      }
+    }
+
+    if( opts.cacheDirPath.isEmpty() ) {
+      opts.cacheDirPath = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+          .absoluteFilePath(QStringLiteral("encodes"));
+    }
+
+    return true;
+  }
+
+  Jobs buildJobs(const Options& opts, const QStringList& files)
+  {
+    Jobs jobs;
+
+    int position = opts.firstChapterNo;
+    for(const QStringList& chapter : groupByChapterName(files)) {
+      QString title = autoChapterName(chapter);
+      if( title.isEmpty() ) {
+        title = QStringLiteral("New Chapter");
+      }
+      if( opts.numbered ) {
+        title = numberedChapterTitle(title, position, opts.widthChapterNo);
+      }
+
+      jobs.push_back(buildJob(position, title, chapter));
+      position++;
+    }
+
+    return jobs;
+  }
+
+  BookBinder makeBinder(JobResults results, const int variant = -1)
+  {
+    std::sort(results.begin(), results.end());
+
+    BookBinder binder;
+    for(const JobResult& result : results) {
+      binder.emplace_back(cs::toUtf8String(result.title),
+                          cs::toPath(variant >= 0
+                                     ? result.variantFilePaths.value(variant)
+                                     : result.outputFilePath));
+    }
+    return binder;
+  }
+
+  bool hasTag(const Mp4Tag& tag)
+  {
+    return !tag.title.empty()  ||  !tag.author.empty()  ||  !tag.genre.empty()  ||
+        !tag.coverImageFilePath.empty();
+  }
+
+  bool encode(Books& books, const Options& opts, const ConsoleLogger& logger)
+  {
+    // (1) Build jobs from input directory ///////////////////////////////////
+
+    const Jobs built = buildJobs(opts, listAudioFiles(opts.inputPath));
+    if( built.isEmpty() ) {
+      logger.logError(u8"No audio files in \"" + cs::toUtf8String(opts.inputPath) + u8"\"!");
+      return false;
+    }
+
+    const QString workDirPath = !opts.workDirPath.isEmpty()
+        ? QFileInfo(opts.workDirPath).absoluteFilePath()
+        : opts.inputPath;
+    if( !QDir().mkpath(workDirPath) ) {
+      logger.logError(u8"Unable to create directory \"" + cs::toUtf8String(workDirPath) + u8"\"!");
+      return false;
+    }
+
+    // (2) Open cache and manifest ///////////////////////////////////////////
+
+    EncodeCache cache;
+    if( opts.useCache  &&  !cache.open(cs::toPath(opts.cacheDirPath), opts.cacheSize) ) {
+      logger.logWarning(u8"Unable to open encode cache!");
+    }
+
+    JobManifest manifest;
+    if( !manifest.open(workDirPath) ) {
+      logger.logWarning(u8"Unable to open job manifest!");
+    }
+
+    const AacFormat format = opts.nativeRate
+        ? negotiateNativeRate(opts.format, built)
+        : opts.format;
+    if( format.numSamplesPerSecond != opts.format.numSamplesPerSecond ) {
+      logger.logText(cs::toUtf8String(QStringLiteral("INFO: Encoding at the inputs' rate of %1Hz.")
+                                      .arg(format.numSamplesPerSecond)));
+    }
+
+    Jobs jobs = built;
+    for(Job& job : jobs) {
+      job.cache         = cache.isOpen() ? &cache : nullptr;
+      job.format        = format;
+      job.logger        = &logger;
+      job.manifest      = manifest.isOpen() ? &manifest : nullptr;
+      job.outputDirPath = workDirPath;
+      job.renameInput   = opts.renameInput;
+      job.variants      = opts.variants;
+    }
+
+    if( opts.detectDualMono  &&  negotiateDualMono(jobs) ) {
+      logger.logText(u8"INFO: All chapters are dual-mono; encoding as Mono.");
+    }
+
+    // (3) Execute jobs //////////////////////////////////////////////////////
+
+    ParallelAacEncoder::setMaxThreadCount(std::size_t(opts.numThreads));
+
+    JobResults results;
+    JobRunner runner(std::size_t(opts.numThreads));
+    QObject::connect(&runner, &JobRunner::jobFinished, [&](const JobResult& result) -> void {
+      results.push_back(result);
+      emitEvent(QStringLiteral("chapter"), {
+                  {QStringLiteral("done"),     results.size()},
+                  {QStringLiteral("total"),    jobs.size()},
+                  {QStringLiteral("ok"),       result.isValid()},
+                  {QStringLiteral("mono"),     result.isDownmixed},
+                  {QStringLiteral("position"), result.position},
+                  {QStringLiteral("title"),    result.title},
+                  {QStringLiteral("output"),   result.outputFilePath}
+                });
+    });
+
+    emitEvent(QStringLiteral("encode"), {{QStringLiteral("total"), jobs.size()}});
+    if( !runner.start(jobs) ) {
+      return false;
+    }
+    runner.waitForFinished();
+
+    // (4) All chapters are required for binding /////////////////////////////
+
+    const bool ok = results.size() == jobs.size()  &&
+        std::all_of(results.cbegin(), results.cend(), [](const JobResult& result) -> bool {
+      return result.isValid();
+    });
+    if( !ok ) {
+      logger.logError(u8"Encoding failed!");
+      return false;
+    }
+
+    // (5) One audiobook per variant /////////////////////////////////////////
+
+    try {
+      if( opts.variants.isEmpty() ) {
+        books.push_back(Book());
+        books.back().binder   = makeBinder(results);
+        books.back().filename = opts.outputFilename;
+        books.back().profile  = opts.format.profile;
+      }
+
+      for(int i = 0; i < opts.variants.size(); i++) {
+        books.push_back(Book());
+        books.back().binder   = makeBinder(results, i);
+        books.back().filename = variantBookName(opts.outputFilename, opts.variants[i].name);
+        books.back().profile  = opts.variants[i].profile;
+      }
+    } catch(...) {
+      logger.logError(u8"Unable to create binders!");
+      return false;
+    }
+
+    return true;
+  }
+
+} // namespace priv
+
+////// Main //////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  QCoreApplication qapp(argc, argv);
+
+  priv::Options opts;
+  if( !priv::parseOptions(opts, qapp.arguments()) ) {
+    return priv::Usage;
+  }
+
+  if( !opts.format.isValid() ) {
+    std::fprintf(stderr, "ERROR: Invalid audio format! HE-AAC requires 16000 to 48000 Hz, HE-AACv2 also stereo.\n");
+    return priv::Usage;
+  }
+
+  const ConsoleLogger logger;
+  const cs::OutputContext ctx(&logger, true, nullptr, false);
+
+  // (1) Encode chapters or open binder //////////////////////////////////////
+
+  priv::Books books;
+  if( QFileInfo(opts.inputPath).isDir() ) {
+    if( !priv::encode(books, opts, logger) ) {
+      priv::emitEvent(QStringLiteral("finished"), {{QStringLiteral("ok"), false}});
+      return priv::Failure;
+    }
+  } else {
+    priv::Book book;
+    book.binder   = openBinder(opts.inputPath);
+    book.filename = opts.outputFilename;
+    book.profile  = opts.format.profile;
+    if( book.binder.empty() ) {
+      logger.logError(u8"Unable to open binder \"" + cs::toUtf8String(opts.inputPath) + u8"\"!");
+      priv::emitEvent(QStringLiteral("finished"), {{QStringLiteral("ok"), false}});
+      return priv::Failure;
+    }
+    books.push_back(std::move(book));
+  }
+
+  for(const priv::Book& book : books) {
+    // (2) Bind audiobook ////////////////////////////////////////////////////
+
+    // NOTE: Indexed chapters (e.g. of the EncodeCache) are not scanned again.
+    const auto outputBinder = isAdtsBinderIndexed(book.binder)
+        ? outputAdtsBinder
+        : outputAdtsBinderStreaming;
+
+    const bool is_bound = outputBinder(cs::toPath(book.filename), book.binder, ctx,
+                                       cs::toUtf8String(opts.language), book.profile);
+    priv::emitEvent(QStringLiteral("bind"), {
+                      {QStringLiteral("ok"),       is_bound},
+                      {QStringLiteral("chapters"), int(book.binder.size())},
+                      {QStringLiteral("output"),   book.filename}
+                    });
+    if( !is_bound ) {
+      priv::emitEvent(QStringLiteral("finished"), {{QStringLiteral("ok"), false}});
+      return priv::Failure;
+    }
+
+    // (3) Tag audiobook /////////////////////////////////////////////////////
+
+    if( priv::hasTag(opts.tag) ) {
+      Mp4Tag tag = opts.tag;
+      tag.filename = cs::toPath(book.filename);
+
+      const bool is_tagged = tag.write();
+      priv::emitEvent(QStringLiteral("tag"), {
+                        {QStringLiteral("ok"),     is_tagged},
+                        {QStringLiteral("output"), book.filename}
+                      });
+      if( !is_tagged ) {
+        logger.logError(u8"Unable to write tag!");
+        priv::emitEvent(QStringLiteral("finished"), {{QStringLiteral("ok"), false}});
+        return priv::Failure;
+      }
+    }
+  }
+
+  priv::emitEvent(QStringLiteral("finished"), {{QStringLiteral("ok"), true}});
+
+  return priv::Success;
+}
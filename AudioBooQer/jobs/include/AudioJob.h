@@ -0,0 +1,138 @@
+/****************************************************************************
+** Copyright (c) 2019, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef AUDIOJOB_H
+#define AUDIOJOB_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QtMultimedia/QAudioDecoder>
+
+#include "EncodeCache.h"
+#include "IAudioDecoder.h"
+#include "IAudioEncoder.h"
+#include "Job.h"
+#include "TaskStrand.h"
+
+class CacheStagingSink;
+class ResamplingEncoder;
+
+/*
+ * NOTE:
+ * AudioJob lives in the GUI thread, which also receives QAudioDecoder's
+ * signals. Encoding, flushing and muxing are posted to a TaskStrand; thus,
+ * the encoder is only ever accessed by one worker at a time.
+ * With an EncodeCache, a chapter is restored instead of decoded and encoded,
+ * if its input files, format and encoder's settings match a cached one.
+ * With Job::writer, access units are streamed to the chapter's sink.
+ * With a JobManifest, a chapter completed by a previous run is skipped, if
+ * its output file is verified; inputs are renamed only after completion.
+ * With Job::variants, one decode pass feeds a FanOutEncoder, which writes
+ * one output file per variant.
+ * With Job::downmix, a DualMonoEncoder encodes the chapter as Mono; this is
+ * decided for the whole book beforehand (cf. negotiateDualMono()).
+ * Inputs are decoded at their native sampling rate (cf. probe), which is
+ * converted by a ResamplingEncoder, if it differs from the job's format.
+ */
+
+class AudioJob : public QObject {
+  Q_OBJECT
+public:
+  static constexpr int maxQueuedBuffers = 16;
+
+  AudioJob(const Job& job, TaskScheduler *scheduler, QObject *parent = nullptr);
+  ~AudioJob();
+
+  bool isDone() const;
+  JobResult result() const;
+
+  void start();
+
+private slots:
+  void decodingBufferReady();
+  void decodingError(QAudioDecoder::Error error);
+  void decodingFinished();
+
+private:
+  void appendInfoMessage(const QString& msg);
+  void complete();
+  std::unique_ptr<QAudioDecoder> createDecoder(const QString& filename) const;
+  void decodeNative(const QString& filename);
+  void encodeBuffer(const QAudioBuffer& buffer);
+  void fail(const std::u8string& error);
+  void finish();
+  QString inputFileName() const;
+  bool isNativeCandidate(const QString& filename) const;
+  void lookup();
+  bool lookupCache();
+  bool lookupManifest();
+  void prefetchNext();
+  void readBuffers(const bool all);
+  void recordManifest();
+  void renameInputs();
+  void resumeDecode();
+  bool setInputRate(const unsigned int rate);
+  void startDecode();
+  void startEncode();
+  void startQtDecode(const QString& filename);
+
+  EncodeCache::Key _cacheKey;
+  std::unique_ptr<QAudioDecoder> _decoder;
+  std::atomic<bool> _done;
+  AudioEncoderPtr _encoder;
+  std::atomic<bool> _failed;
+  bool _finishing;
+  bool _hasCacheKey;
+  unsigned int _inputRate;
+  bool _isResumed;
+  Job _job;
+  QString _manifestSettings;
+  QString _message;
+  AudioDecoderPtr _nativeDecoder;
+  std::unique_ptr<QAudioDecoder> _nextDecoder;
+  int _nextInput;
+  uint64_t _numCachedFrames;
+  std::atomic<int> _numQueuedBuffers;
+  QString _outputFilePath;
+  ResamplingEncoder *_resampling;
+  JobResult _result;
+  std::vector<std::unique_ptr<QAudioDecoder>> _retiredDecoders;
+  std::unique_ptr<CacheStagingSink> _staging;
+  QString _stagingFilePath;
+  TaskStrand _strand;
+
+signals:
+  void done();
+};
+
+#endif // AUDIOJOB_H
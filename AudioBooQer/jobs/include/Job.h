@@ -31,6 +31,8 @@
 
 #pragma once
 
+#include <limits>
+
 #include <QtCore/QByteArray>
 #include <QtCore/QList>
 #include <QtCore/QStringList>
@@ -40,20 +42,42 @@
 namespace cs {
   class ILogger;
 }
+class EncodeCache;
 class IAudioEncoder;
+class JobManifest;
+class Mp4ChapterWriter;
+
+struct JobVariant {
+  JobVariant() = default;
+
+  unsigned int bitRate{};
+  unsigned int numChannels{};
+  AacProfile profile{AacProfile::AAC_LC};
+  QString name{}; // sub-directory of Job::outputDirPath
+};
+
+using JobVariants = QList<JobVariant>;
 
 struct Job {
   Job() = default;
 
+  double estimateCost() const;
   QString outputFilePath(IAudioEncoder *encoder) const;
 
+  EncodeCache *cache{nullptr};
+  double cost{}; // estimated duration [s], cf. estimateCost()
+  bool downmix{false}; // encode stereo as Mono, cf. negotiateDualMono()
   AacFormat format{};
   QStringList inputFiles{};
   const cs::ILogger *logger{nullptr};
+  JobManifest *manifest{nullptr};
   QString outputDirPath{};
   int position{};
   bool renameInput{false};
+  double sideLevel{std::numeric_limits<double>::quiet_NaN()}; // [dB], cf. negotiateDualMono()
   QString title{};
+  JobVariants variants{}; // fan-out; one decode pass feeds all variants
+  Mp4ChapterWriter *writer{nullptr};
 };
 
 using Jobs = QList<Job>;
@@ -61,10 +85,12 @@ using Jobs = QList<Job>;
 struct JobResult {
   JobResult() = default;
 
+  bool isDownmixed{false}; // cf. Job::downmix
   uint64_t numPcmFrames{};
   QString outputFilePath{};
   int position{};
   QString title{};
+  QStringList variantFilePaths{}; // cf. Job::variants
 
   bool isValid() const;
 
@@ -72,5 +98,3 @@ struct JobResult {
 };
 
 using JobResults = QList<JobResult>;
-
-JobResult executeJob(const Job& job);
@@ -0,0 +1,68 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef JOBBUILDER_H
+#define JOBBUILDER_H
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include "Job.h"
+
+/*
+ * NOTE:
+ * Rules shared by ChapterModel and the command line interface:
+ * - Input files are the directory's MP3 and WAV files, sorted by name.
+ * - A chapter's title is derived from its first file's name, without
+ *   leading "CD", track numbers and separators (cf. autoChapterName()).
+ * - The command line interface groups consecutive files with the same
+ *   title into one chapter (cf. groupByChapterName()); in ChapterModel,
+ *   the user groups them.
+ * - A numbered title is "<no> - <title>", with a zero-padded number.
+ * - The native rate is used, if all inputs share one, which is supported
+ *   by the format (e.g. its profile); otherwise the format is unchanged.
+ * - All chapters share one AudioSpecificConfig and thus one number of
+ *   channels: a book is downmixed to Mono, only if the leading seconds of
+ *   every chapter are dual-mono (cf. negotiateDualMono()); each chapter's
+ *   side level is reported regardless.
+ */
+
+QString autoChapterName(const QStringList& files);
+Job buildJob(const int position, const QString& title, const QStringList& files);
+QList<QStringList> groupByChapterName(const QStringList& files);
+QStringList listAudioFiles(const QString& dirPath);
+bool negotiateDualMono(Jobs& jobs, const int threshold = -40,
+                       const unsigned int analysisSeconds = 30);
+AacFormat negotiateNativeRate(const AacFormat& format, const Jobs& jobs);
+QString numberedChapterTitle(const QString& title, const int number, const int width);
+
+#endif // JOBBUILDER_H
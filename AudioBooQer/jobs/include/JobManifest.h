@@ -0,0 +1,96 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+#ifndef JOBMANIFEST_H
+#define JOBMANIFEST_H
+
+#include <cstdint>
+
+#include <map>
+#include <mutex>
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include "Job.h"
+
+/*
+ * NOTE:
+ * JobManifest records each completed chapter of an output directory; thus,
+ * a restarted run skips chapters, whose inputs, settings and output file
+ * are unchanged. An output file is verified by its size and checksum.
+ * The manifest is saved atomically after each record.
+ */
+
+struct JobManifestEntry {
+  JobManifestEntry() = default;
+
+  QStringList inputFiles{};
+  QList<qint64> inputSizes{};
+  uint64_t numPcmFrames{};
+  uint64_t outputChecksum{};
+  QString outputFileName{};
+  qint64 outputSize{};
+  QString settings{};
+  QString title{};
+};
+
+class JobManifest {
+public:
+  JobManifest();
+  ~JobManifest();
+
+  bool isOpen() const;
+  bool open(const QString& outputDirPath);
+
+  bool lookup(const Job& job, const QString& settings, const QString& outputFilePath,
+              uint64_t *numPcmFrames) const;
+  bool record(const Job& job, const QString& settings, const JobResult& result);
+
+  static QString fileName();
+
+private:
+  JobManifest(const JobManifest&) noexcept = delete;
+  JobManifest& operator=(const JobManifest&) noexcept = delete;
+
+  JobManifest(JobManifest&&) noexcept = delete;
+  JobManifest& operator=(JobManifest&&) noexcept = delete;
+
+  bool save() const;
+
+  std::map<QString,JobManifestEntry> _entries;
+  QString _filename;
+  mutable std::mutex _mutex;
+};
+
+#endif // JOBMANIFEST_H
@@ -0,0 +1,99 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef JOBRUNNER_H
+#define JOBRUNNER_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QFuture>
+#include <QtCore/QFutureInterface>
+#include <QtCore/QObject>
+
+#include "Job.h"
+#include "TaskScheduler.h"
+
+class AudioJob;
+
+/*
+ * NOTE:
+ * JobRunner drives AudioJobs from the GUI thread's event loop and executes
+ * their tasks on a dedicated TaskScheduler. Progress and results are
+ * reported through a QFuture.
+ *
+ * Jobs are dispatched longest (i.e. highest Job::cost) first; thus, a long
+ * chapter does not extend the run, while all other workers are idle.
+ * With Job::writer, chapters are muxed in order; jobs are then dispatched in
+ * chapter order and at most maxActive() chapters ahead of the first one not
+ * done, which bounds the number of chapters spilled by Mp4ChapterWriter.
+ * Results are reported in completion order, both through the QFuture and
+ * the jobFinished() signal.
+ */
+
+class JobRunner : public QObject {
+  Q_OBJECT
+public:
+  JobRunner(const std::size_t numThreads, QObject *parent = nullptr);
+  ~JobRunner();
+
+  QFuture<JobResult> future();
+  bool isFinished() const;
+  bool start(const Jobs& jobs);
+  void waitForFinished();
+
+private slots:
+  void jobDone();
+
+private:
+  using ActiveJob = std::pair<int,std::unique_ptr<AudioJob>>;
+
+  std::size_t maxActive() const;
+  void setDone(const int index);
+  void startJobs();
+
+  std::vector<ActiveJob> _active;
+  int _firstNotDone;
+  QFutureInterface<JobResult> _future;
+  std::vector<bool> _isDone;
+  Jobs _jobs;
+  int _numDone;
+  int _numStarted;
+  std::vector<int> _order;
+  TaskScheduler _scheduler;
+
+signals:
+  void finished();
+  void jobFinished(const JobResult& result);
+};
+
+#endif // JOBRUNNER_H
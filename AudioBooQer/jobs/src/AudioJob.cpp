@@ -0,0 +1,859 @@
+/****************************************************************************
+** Copyright (c) 2019, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cmath>
+
+#include <QtCore/QFile>
+
+#include <cs/Core/QStringUtil.h>
+#include <cs/Logging/ILogger.h>
+
+#include "AudioJob.h"
+
+#include "AdtsFileSink.h"
+#include "AudioProbe.h"
+#include "DualMonoEncoder.h"
+#include "FanOutEncoder.h"
+#include "JobManifest.h"
+#include "MappedFile.h"
+#include "Mp4ChapterWriter.h"
+#include "ResamplingEncoder.h"
+#include "WaveDecoder.h"
+
+#define HAVE_AAC
+
+#ifdef HAVE_AAC
+# include "AacEncoder.h"
+# include "ParallelAacEncoder.h"
+#else
+# include "RawEncoder.h"
+#endif
+
+////// Private ///////////////////////////////////////////////////////////////
+
+/*
+ * NOTE:
+ * CacheStagingSink passes access units to the chapter's sink and copies them
+ * to an ADTS file, which is then stored in EncodeCache. Failing to write the
+ * copy does not fail the chapter; it is just not stored.
+ */
+
+class CacheStagingSink : public IAccessUnitSink {
+public:
+  CacheStagingSink(IAccessUnitSink *sink) noexcept
+    : _adts()
+    , _isStaged(false)
+    , _sink(sink)
+  {
+  }
+
+  ~CacheStagingSink() noexcept
+  {
+  }
+
+  bool close()
+  {
+    return _adts.close()  &&  _isStaged;
+  }
+
+  bool open(const std::filesystem::path& filename)
+  {
+    _isStaged = _adts.open(filename);
+    return _isStaged;
+  }
+
+  bool setAudioSpecificConfig(const uint8_t *asc, const std::size_t size)
+  {
+    _isStaged = _isStaged  &&  _adts.setAudioSpecificConfig(asc, size);
+    return _sink->setAudioSpecificConfig(asc, size);
+  }
+
+  bool writeAccessUnit(const uint8_t *data, const std::size_t size)
+  {
+    _isStaged = _isStaged  &&  _adts.writeAccessUnit(data, size);
+    return _sink->writeAccessUnit(data, size);
+  }
+
+private:
+  AdtsFileSink _adts;
+  bool _isStaged;
+  IAccessUnitSink *_sink;
+};
+
+namespace priv {
+
+  QAudioFormat convert(const AacFormat& fmt)
+  {
+    if( !fmt.isValid() ) {
+      return QAudioFormat();
+    }
+
+    QAudioFormat result;
+    result.setByteOrder(static_cast<QAudioFormat::Endian>(QSysInfo::ByteOrder));
+    result.setChannelCount(static_cast<int>(fmt.numChannels));
+    result.setCodec(QStringLiteral("audio/pcm"));
+    result.setSampleRate(static_cast<int>(fmt.numSamplesPerSecond));
+    result.setSampleSize(static_cast<int>(fmt.numBitsPerChannel));
+    result.setSampleType(QAudioFormat::SignedInt);
+
+    return result;
+  }
+
+  AudioEncoderPtr createEncoder()
+  {
+    AudioEncoderPtr result;
+    try {
+#ifdef HAVE_AAC
+      // NOTE: If more than one thread may be used, split long chapters into segments.
+      if( ParallelAacEncoder::maxThreadCount() > 1 ) {
+        result = std::make_unique<ParallelAacEncoder>();
+      } else {
+        result = std::make_unique<AacEncoder>();
+      }
+#else
+      result = std::make_unique<RawEncoder>();
+#endif
+    } catch(...) {
+      return AudioEncoderPtr();
+    }
+
+    return result;
+  }
+
+  AudioEncoderPtr createDualMonoEncoder()
+  {
+    AudioEncoderPtr encoder = createEncoder();
+    if( !encoder ) {
+      return AudioEncoderPtr();
+    }
+
+    AudioEncoderPtr result;
+    try {
+      result = std::make_unique<DualMonoEncoder>(std::move(encoder));
+    } catch(...) {
+      return AudioEncoderPtr();
+    }
+
+    return result;
+  }
+
+  AudioEncoderPtr createFanOutEncoder(const AacFormat& format, const JobVariants& variants)
+  {
+    std::unique_ptr<FanOutEncoder> result;
+    try {
+      result = std::make_unique<FanOutEncoder>();
+    } catch(...) {
+      return AudioEncoderPtr();
+    }
+
+    for(const JobVariant& variant : variants) {
+      AacFormat variantFormat = format;
+      variantFormat.numChannels = variant.numChannels;
+      variantFormat.profile     = variant.profile;
+      if( variant.bitRate > 0 ) {
+        variantFormat.bitRate = variant.bitRate;
+      }
+
+      if( !result->addVariant(createEncoder(), variantFormat, cs::toPath(variant.name)) ) {
+        return AudioEncoderPtr();
+      }
+    }
+
+    return result;
+  }
+
+  std::unique_ptr<ResamplingEncoder> createResamplingEncoder(AudioEncoderPtr encoder)
+  {
+    if( !encoder ) {
+      return std::unique_ptr<ResamplingEncoder>();
+    }
+
+    std::unique_ptr<ResamplingEncoder> result;
+    try {
+      result = std::make_unique<ResamplingEncoder>(std::move(encoder));
+    } catch(...) {
+      return std::unique_ptr<ResamplingEncoder>();
+    }
+
+    return result;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+AudioJob::AudioJob(const Job& job, TaskScheduler *scheduler, QObject *parent)
+  : QObject(parent)
+  , _cacheKey(0)
+  , _decoder()
+  , _done(false)
+  , _encoder()
+  , _failed(false)
+  , _finishing(false)
+  , _hasCacheKey(false)
+  , _inputRate(0)
+  , _isResumed(false)
+  , _job(job)
+  , _manifestSettings()
+  , _message()
+  , _nativeDecoder()
+  , _nextDecoder()
+  , _nextInput(0)
+  , _numCachedFrames(0)
+  , _numQueuedBuffers(0)
+  , _outputFilePath()
+  , _resampling(nullptr)
+  , _result()
+  , _retiredDecoders()
+  , _staging()
+  , _stagingFilePath()
+  , _strand(scheduler)
+{
+}
+
+AudioJob::~AudioJob()
+{
+  // NOTE: Posted tasks refer to this job!
+  _strand.wait();
+}
+
+bool AudioJob::isDone() const
+{
+  return _done;
+}
+
+JobResult AudioJob::result() const
+{
+  return _result;
+}
+
+void AudioJob::start()
+{
+  // (1) Validate decoder's format ///////////////////////////////////////////
+
+  if( !createDecoder(QString()) ) {
+    _failed = true;
+    finish();
+    return;
+  }
+
+  // (2) Initialize encoder //////////////////////////////////////////////////
+
+  if( !_job.variants.isEmpty() ) {
+    if( _job.writer != nullptr ) {
+      fail(u8"Variants require output files!");
+      return;
+    }
+
+    // NOTE: EncodeCache and JobManifest track one output file per chapter.
+    _job.cache    = nullptr;
+    _job.manifest = nullptr;
+  }
+
+  // NOTE: Variants define their number of channels explicitly.
+  AudioEncoderPtr encoder;
+  if(        !_job.variants.isEmpty() ) {
+    encoder = priv::createFanOutEncoder(_job.format, _job.variants);
+  } else if( _job.downmix ) {
+    encoder = priv::createDualMonoEncoder();
+  } else {
+    encoder = priv::createEncoder();
+  }
+
+  // NOTE: Inputs are decoded at their native rate and resampled, if required.
+  std::unique_ptr<ResamplingEncoder> resampling = priv::createResamplingEncoder(std::move(encoder));
+  _resampling = resampling.get();
+  _encoder = std::move(resampling);
+  if( !_encoder ) {
+    fail(u8"IAudioEncoder is <nullptr>!");
+    return;
+  }
+
+  _outputFilePath = _job.writer != nullptr
+      ? cs::toQString(_job.writer->filename())
+      : _job.outputFilePath(_encoder.get());
+
+  // (3) Look up previous runs; hashing files is off-loaded to the strand ////
+
+  if( _job.manifest != nullptr ) {
+    _manifestSettings = QStringLiteral("%1;%2;%3;%4;%5;%6;%7")
+        .arg(_job.format.numChannels)
+        .arg(_job.format.numSamplesPerSecond)
+        .arg(_job.format.numBitsPerChannel)
+        .arg(static_cast<unsigned int>(_job.format.profile))
+        .arg(_job.format.bitRate)
+        .arg(_job.format.bitRateMode)
+        .arg(cs::toQString(_encoder->settings()));
+  }
+
+  if( _job.cache != nullptr  ||  _job.manifest != nullptr ) {
+    if( !_strand.post([this]() -> void { lookup(); }) ) {
+      fail(u8"TaskStrand::post() failed!");
+    }
+    return;
+  }
+
+  startEncode();
+}
+
+////// private slots /////////////////////////////////////////////////////////
+
+void AudioJob::decodingBufferReady()
+{
+  readBuffers(false);
+}
+
+void AudioJob::decodingError(QAudioDecoder::Error /*error*/)
+{
+  if( _finishing ) {
+    return;
+  }
+  fail(cs::toUtf8String(_decoder->errorString()));
+}
+
+void AudioJob::decodingFinished()
+{
+  if( _finishing ) {
+    return;
+  }
+
+  readBuffers(true);
+  if( _finishing ) {
+    return;
+  }
+
+  _decoder->stop();
+  const QString filename = inputFileName();
+  if( !_strand.post([this, filename]() -> void {
+                      if( !_failed ) {
+                        appendInfoMessage(QStringLiteral("+ %1").arg(filename));
+                      }
+                    }) ) {
+    fail(u8"TaskStrand::post() failed!");
+    return;
+  }
+
+  // NOTE: Do not destroy a decoder, that may still be emitting a signal!
+  try {
+    _retiredDecoders.push_back(std::move(_decoder));
+  } catch(...) {
+    _decoder.release()->deleteLater();
+  }
+
+  startDecode();
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void AudioJob::appendInfoMessage(const QString& msg)
+{
+  _message.append(QStringLiteral("INFO: %1\n").arg(msg));
+}
+
+void AudioJob::complete()
+{
+  const bool is_cached = _numCachedFrames > 0;
+
+  // (1) Flush encoder; closes output file ///////////////////////////////////
+
+  uint64_t numPcmFrames = _numCachedFrames;
+  if( !_failed  &&  !is_cached ) {
+    if( !_encoder->flush() ) {
+      _job.logger->logError(u8"IAudioEncoder::flush() failed!");
+      _failed = true;
+    } else {
+      numPcmFrames = _encoder->numPcmFrames();
+    }
+
+    _resampling = nullptr;
+    _encoder.reset();
+  }
+
+  // (2) Store encoded chapter in cache //////////////////////////////////////
+
+  bool is_staged = false;
+  if( _staging ) {
+    is_staged = _staging->close();
+    _staging.reset();
+  }
+
+  if( !_failed  &&  !is_cached  &&  _hasCacheKey ) {
+    const bool is_stored = _job.writer != nullptr
+        ? is_staged  &&  _job.cache->store(_cacheKey, cs::toPath(_stagingFilePath), numPcmFrames)
+        : _job.cache->store(_cacheKey, cs::toPath(_outputFilePath), numPcmFrames);
+    if( !is_stored ) {
+      _job.logger->logWarning(u8"Unable to store chapter \"" + cs::toUtf8String(_job.title) +
+                              u8"\" in cache!");
+    }
+  }
+
+  if( !_stagingFilePath.isEmpty() ) {
+    QFile::remove(_stagingFilePath);
+  }
+
+  if( !_failed ) {
+    _result.isDownmixed    = _job.downmix;
+    _result.numPcmFrames   = numPcmFrames;
+    _result.outputFilePath = _outputFilePath;
+    _result.position       = _job.position;
+    _result.title          = _job.title;
+
+    for(const JobVariant& variant : _job.variants) {
+      _result.variantFilePaths.push_back(
+            cs::toQString(FanOutEncoder::variantFileName(cs::toPath(_outputFilePath),
+                                                         cs::toPath(variant.name))));
+    }
+
+    if( !std::isnan(_job.sideLevel) ) {
+      appendInfoMessage(QStringLiteral("~ Side %1 dB; encoded as %2")
+                        .arg(_job.sideLevel, 0, 'f', 1)
+                        .arg(_job.downmix ? QStringLiteral("Mono") : QStringLiteral("Stereo")));
+    }
+
+    if(        _isResumed ) {
+      appendInfoMessage(QStringLiteral("= %1 (resumed)").arg(_outputFilePath));
+    } else if( is_cached ) {
+      appendInfoMessage(QStringLiteral("= %1 (cached)").arg(_outputFilePath));
+    } else if( !_result.variantFilePaths.isEmpty() ) {
+      for(const QString& filename : _result.variantFilePaths) {
+        appendInfoMessage(QStringLiteral("= %1").arg(filename));
+      }
+    } else {
+      appendInfoMessage(QStringLiteral("= %1").arg(_outputFilePath));
+    }
+    _job.logger->logText(cs::toUtf8String(_message));
+  }
+
+  // (3) Record chapter in manifest //////////////////////////////////////////
+
+  if( !_failed  &&  !_isResumed  &&  _job.manifest != nullptr ) {
+    recordManifest();
+  }
+
+  // (4) Mux chapter /////////////////////////////////////////////////////////
+
+  if( _job.writer != nullptr ) {
+    if( !_job.writer->commit(_job.position, cs::toUtf8String(_job.title), !_failed) ) {
+      _result.numPcmFrames = 0;
+    }
+  }
+
+  // (5) Inputs are renamed only after completion ////////////////////////////
+
+  if( _result.isValid() ) {
+    renameInputs();
+  }
+
+  _done = true;
+  emit done();
+}
+
+std::unique_ptr<QAudioDecoder> AudioJob::createDecoder(const QString& filename) const
+{
+  std::unique_ptr<QAudioDecoder> decoder;
+  try {
+    decoder = std::make_unique<QAudioDecoder>();
+  } catch(...) {
+    _job.logger->logError(u8"Unable to create QAudioDecoder!");
+    return std::unique_ptr<QAudioDecoder>();
+  }
+
+  // NOTE: Decode at the native rate; cf. setInputRate()
+  QAudioFormat format = priv::convert(_job.format);
+  unsigned int rate = 0;
+  if( !filename.isEmpty()  &&  probe::samplingRate(cs::toPath(filename), &rate) ) {
+    format.setSampleRate(static_cast<int>(rate));
+  }
+
+  decoder->setAudioFormat(format);
+  if( decoder->error() != QAudioDecoder::NoError ) {
+    _job.logger->logError(cs::toUtf8String(decoder->errorString()));
+    return std::unique_ptr<QAudioDecoder>();
+  }
+
+  if( !filename.isEmpty() ) {
+    decoder->setSourceFilename(filename);
+    decoder->start();
+  }
+
+  return decoder;
+}
+
+void AudioJob::decodeNative(const QString& filename)
+{
+  // (1) Fall back to QAudioDecoder, if the format does not match ////////////
+
+  if( !_failed  &&
+      ( !_nativeDecoder->open(cs::toPath(filename))  ||
+        _nativeDecoder->format().numBitsPerChannel != _job.format.numBitsPerChannel  ||
+        _nativeDecoder->format().numChannels       != _job.format.numChannels ) ) {
+    _nativeDecoder->close();
+    QMetaObject::invokeMethod(this, [this, filename]() -> void {
+      startQtDecode(filename);
+    }, Qt::QueuedConnection);
+    return;
+  }
+
+  // (2) PCM is passed to the encoder without copying ////////////////////////
+
+  if( !_failed ) {
+    const bool ok = setInputRate(_nativeDecoder->format().numSamplesPerSecond)  &&
+        _nativeDecoder->encode(_encoder.get());
+    _nativeDecoder->close();
+
+    if( !ok ) {
+      _job.logger->logError(u8"IAudioEncoder::encode() failed!");
+      _failed = true;
+    } else {
+      appendInfoMessage(QStringLiteral("+ %1").arg(filename));
+    }
+  }
+
+  QMetaObject::invokeMethod(this, [this]() -> void {
+    startDecode();
+  }, Qt::QueuedConnection);
+}
+
+void AudioJob::encodeBuffer(const QAudioBuffer& buffer)
+{
+  if( !_failed  &&
+      ( !setInputRate(static_cast<unsigned int>(buffer.format().sampleRate()))  ||
+        !_encoder->encode(buffer.constData(), std::size_t(buffer.byteCount())) ) ) {
+    _job.logger->logError(u8"IAudioEncoder::encode() failed!");
+    _failed = true;
+  }
+
+  // NOTE: Resume reading, if the queue was full.
+  if( _numQueuedBuffers-- == maxQueuedBuffers ) {
+    QMetaObject::invokeMethod(this, [this]() -> void {
+      readBuffers(false);
+    }, Qt::QueuedConnection);
+  }
+}
+
+void AudioJob::fail(const std::u8string& error)
+{
+  _job.logger->logError(error);
+  _failed = true;
+  finish();
+}
+
+void AudioJob::finish()
+{
+  if( _finishing ) {
+    return;
+  }
+  _finishing = true;
+
+  if( _decoder ) {
+    _decoder->stop();
+  }
+
+  if( !_strand.post([this]() -> void { complete(); }) ) {
+    _strand.wait();
+    complete();
+  }
+}
+
+bool AudioJob::isNativeCandidate(const QString& filename) const
+{
+  return _nativeDecoder  &&  filename.endsWith(QStringLiteral(".wav"), Qt::CaseInsensitive);
+}
+
+QString AudioJob::inputFileName() const
+{
+  return _decoder->sourceFilename();
+}
+
+void AudioJob::lookup()
+{
+  if( !lookupManifest()  &&  !lookupCache() ) {
+    QMetaObject::invokeMethod(this, [this]() -> void {
+      startEncode();
+    }, Qt::QueuedConnection);
+    return;
+  }
+
+  for(const QString& filename : _job.inputFiles) {
+    appendInfoMessage(QStringLiteral("+ %1").arg(filename));
+  }
+
+  complete();
+}
+
+bool AudioJob::lookupCache()
+{
+  if( _job.cache == nullptr ) {
+    return false;
+  }
+
+  // (1) Compute key from input files, format and encoder's settings /////////
+
+  std::vector<std::filesystem::path> inputFileNames;
+  try {
+    for(const QString& filename : _job.inputFiles) {
+      inputFileNames.push_back(cs::toPath(filename));
+    }
+  } catch(...) {
+    inputFileNames.clear();
+  }
+
+  _hasCacheKey = EncodeCache::computeKey(&_cacheKey, inputFileNames,
+                                         _job.format, _encoder->settings());
+
+  // (2) Restore cached chapter or encode it /////////////////////////////////
+
+  const bool is_restored = _hasCacheKey  &&
+      _job.cache->lookup(_cacheKey, &_numCachedFrames)  &&
+      ( _job.writer != nullptr
+        ? _job.cache->restore(_cacheKey, _job.writer->sink(_job.position), _job.format.profile)
+        : _job.cache->restore(_cacheKey, cs::toPath(_outputFilePath)) );
+  if( !is_restored ) {
+    _numCachedFrames = 0;
+  }
+
+  return is_restored;
+}
+
+bool AudioJob::lookupManifest()
+{
+  if( _job.manifest == nullptr ) {
+    return false;
+  }
+
+  _isResumed = _job.manifest->lookup(_job, _manifestSettings, _outputFilePath,
+                                     &_numCachedFrames);
+  if( !_isResumed ) {
+    _numCachedFrames = 0;
+  }
+
+  return _isResumed;
+}
+
+void AudioJob::prefetchNext()
+{
+  if( _nextInput >= _job.inputFiles.size() ) {
+    return;
+  }
+  const QString filename = _job.inputFiles[_nextInput];
+
+  // (1) Warm operating system's cache ///////////////////////////////////////
+
+  MappedFile::prefetchAsync(cs::toPath(filename));
+
+  // (2) Pre-start decoding; output is buffered by QAudioDecoder until read //
+
+  if( !isNativeCandidate(filename) ) {
+    _nextDecoder = createDecoder(filename);
+  }
+}
+
+void AudioJob::readBuffers(const bool all)
+{
+  while( !_finishing  &&  _decoder  &&  _decoder->bufferAvailable() ) {
+    if( _failed ) {
+      finish();
+      return;
+    }
+
+    // NOTE: Unread buffers throttle QAudioDecoder.
+    if( !all  &&  _numQueuedBuffers >= maxQueuedBuffers ) {
+      return;
+    }
+
+    const QAudioBuffer buffer = _decoder->read();
+    _numQueuedBuffers++;
+    if( !_strand.post([this, buffer]() -> void { encodeBuffer(buffer); }) ) {
+      _numQueuedBuffers--;
+      fail(u8"TaskStrand::post() failed!");
+      return;
+    }
+  }
+}
+
+void AudioJob::recordManifest()
+{
+  if( !_job.manifest->record(_job, _manifestSettings, _result) ) {
+    _job.logger->logWarning(u8"Unable to record chapter \"" + cs::toUtf8String(_job.title) +
+                            u8"\" in manifest!");
+  }
+}
+
+void AudioJob::renameInputs()
+{
+  if( !_job.renameInput ) {
+    return;
+  }
+
+  for(const QString& filename : _job.inputFiles) {
+    QFile::rename(filename, filename + QStringLiteral(".done"));
+  }
+}
+
+void AudioJob::resumeDecode()
+{
+  connect(_decoder.get(), &QAudioDecoder::bufferReady,
+          this, &AudioJob::decodingBufferReady, Qt::DirectConnection);
+  connect(_decoder.get(), QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+          this, &AudioJob::decodingError, Qt::DirectConnection);
+  connect(_decoder.get(), &QAudioDecoder::finished,
+          this, &AudioJob::decodingFinished, Qt::DirectConnection);
+
+  // NOTE: A pre-started decoder may have signalled before being connected!
+
+  if( _decoder->error() != QAudioDecoder::NoError ) {
+    decodingError(_decoder->error());
+    return;
+  }
+
+  readBuffers(false);
+
+  if( !_finishing  &&  _decoder->state() == QAudioDecoder::StoppedState ) {
+    decodingFinished();
+  }
+}
+
+bool AudioJob::setInputRate(const unsigned int rate)
+{
+  // NOTE: All inputs of a chapter are expected to share one sampling rate.
+  if( _inputRate != 0  &&  rate != _inputRate ) {
+    _job.logger->logWarning(u8"Chapter \"" + cs::toUtf8String(_job.title) +
+                            u8"\" mixes sampling rates!");
+  }
+  _inputRate = rate;
+
+  if( rate == _resampling->inputRate() ) {
+    return true;
+  }
+
+  if( rate != _job.format.numSamplesPerSecond ) {
+    appendInfoMessage(QStringLiteral("~ Resampling %1Hz to %2Hz")
+                      .arg(rate).arg(_job.format.numSamplesPerSecond));
+  }
+
+  return _resampling->setInputRate(rate);
+}
+
+void AudioJob::startDecode()
+{
+  if( _failed  ||  _nextInput >= _job.inputFiles.size() ) {
+    finish();
+    return;
+  }
+
+  const QString filename = _job.inputFiles[_nextInput++];
+
+  std::unique_ptr<QAudioDecoder> decoder = std::move(_nextDecoder);
+  if( decoder  &&  decoder->sourceFilename() != filename ) {
+    decoder.reset();
+  }
+
+  prefetchNext();
+
+  // (1) Native decoding; resumes in startDecode() ///////////////////////////
+
+  if( isNativeCandidate(filename) ) {
+    if( !_strand.post([this, filename]() -> void { decodeNative(filename); }) ) {
+      fail(u8"TaskStrand::post() failed!");
+    }
+    return;
+  }
+
+  // (2) Decoding using QAudioDecoder; resumes in decodingFinished() /////////
+
+  if( decoder ) {
+    _decoder = std::move(decoder);
+    resumeDecode();
+  } else {
+    startQtDecode(filename);
+  }
+}
+
+void AudioJob::startEncode()
+{
+  // (1) Initialize encoder //////////////////////////////////////////////////
+
+  if( _job.writer != nullptr ) {
+    IAccessUnitSink *sink = _job.writer->sink(_job.position);
+
+    // NOTE: Access units are streamed to the writer; the cache needs a copy.
+    if( _hasCacheKey ) {
+      try {
+        _staging = std::make_unique<CacheStagingSink>(sink);
+        _stagingFilePath = QStringLiteral("%1.%2.aac").arg(_outputFilePath).arg(_job.position);
+      } catch(...) {
+        _staging.reset();
+      }
+      if( _staging  &&  _staging->open(cs::toPath(_stagingFilePath)) ) {
+        sink = _staging.get();
+      }
+    }
+
+    if( sink == nullptr  ||  !_encoder->initialize(_job.format, sink) ) {
+      fail(u8"IAudioEncoder::initialize() failed!");
+      return;
+    }
+  } else {
+    // NOTE: The output file may be a hard link into EncodeCache!
+    QFile::remove(_outputFilePath);
+
+    if( !_encoder->initialize(_job.format, cs::toUtf8String(_outputFilePath)) ) {
+      fail(u8"IAudioEncoder::initialize() failed!");
+      return;
+    }
+  }
+
+  // (2) Initialize native decoder ///////////////////////////////////////////
+
+  try {
+    auto decoder = std::make_unique<WaveDecoder>();
+    decoder->setDither(true);
+    _nativeDecoder = std::move(decoder);
+  } catch(...) {
+    _nativeDecoder.reset();
+  }
+
+  // (3) Decode -> Encode ////////////////////////////////////////////////////
+
+  startDecode();
+}
+
+void AudioJob::startQtDecode(const QString& filename)
+{
+  _decoder = createDecoder(filename);
+  if( !_decoder ) {
+    _failed = true;
+    finish();
+    return;
+  }
+
+  resumeDecode();
+}
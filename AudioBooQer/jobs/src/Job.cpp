@@ -30,17 +30,47 @@
 *****************************************************************************/
 
 #include <QtCore/QDir>
-#include <QtCore/QEventLoop>
+#include <QtCore/QFileInfo>
 
 #include <cs/Core/QStringUtil.h>
-#include <cs/Logging/ILogger.h>
 
 #include "Job.h"
 
-#include "AudioJob.h"
+#include "IAudioEncoder.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  /*
+   * NOTE:
+   * Without decoding, the duration of an input file is estimated from its
+   * size, assuming CD quality for WAV and a typical bit rate for compressed
+   * audio. Only the ratio of the estimates matters for scheduling.
+   */
+  double bytesPerSecond(const QString& filename)
+  {
+    constexpr double compressedBitsPerSecond = 128000;
+    constexpr double pcmBitsPerSecond = 44100*2*16;
+
+    return filename.endsWith(QStringLiteral(".wav"), Qt::CaseInsensitive)
+        ? pcmBitsPerSecond/8
+        : compressedBitsPerSecond/8;
+  }
+
+} // namespace priv
 
 ////// Job - public //////////////////////////////////////////////////////////
 
+double Job::estimateCost() const
+{
+  double result = 0;
+  for(const QString& filename : inputFiles) {
+    result += double(QFileInfo(filename).size())/priv::bytesPerSecond(filename);
+  }
+  return result;
+}
+
 QString Job::outputFilePath(IAudioEncoder *encoder) const
 {
   const QString suffix = cs::toQString(encoder->outputSuffix(format));
@@ -63,33 +93,3 @@ bool JobResult::operator<(const JobResult& other) const
 {
   return position < other.position;
 }
-
-////// Public ////////////////////////////////////////////////////////////////
-
-JobResult executeJob(const Job& job)
-{
-  JobResult result;
-
-  std::unique_ptr<AudioJob> audio;
-  try {
-    audio = std::make_unique<AudioJob>(job);
-  } catch(...) {
-    audio.reset();
-    job.logger->logError(u8"ERROR: AudioJob is <nullptr>!\n");
-    return result;
-  }
-
-  QEventLoop loop;
-  QObject::connect(audio.get(), &AudioJob::done, &loop, &QEventLoop::quit);
-
-  if( audio->start() ) {
-    loop.exec();
-
-    result.numPcmFrames   = audio->encoder()->numPcmFrames();
-    result.outputFilePath = audio->outputFilePath();
-    result.position       = job.position;
-    result.title          = job.title;
-  }
-
-  return result;
-}
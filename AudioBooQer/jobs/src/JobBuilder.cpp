@@ -0,0 +1,273 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include <QtCore/QDir>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegExp>
+#include <QtMultimedia/QAudioDecoder>
+
+#include <cs/Core/QStringUtil.h>
+
+#include "JobBuilder.h"
+
+#include "AudioProbe.h"
+#include "PcmUtil.h"
+#include "WaveDecoder.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  // NOTE: Accumulates up to 'maxFrames' frames of 'filename' as 16bit stereo.
+  bool sampleWave(pcm::StereoStatistics *stats, const QString& filename,
+                  const uint64_t maxFrames)
+  {
+    constexpr std::size_t frameSize = 2*sizeof(int16_t);
+
+    WaveDecoder decoder;
+    if( !decoder.open(cs::toPath(filename))  ||  decoder.format().numChannels != 2 ) {
+      return false;
+    }
+
+    while( stats->numFrames < maxFrames  &&  !decoder.isAtEnd() ) {
+      const std::span<const uint8_t> data =
+          decoder.read(std::size_t(maxFrames - stats->numFrames)*frameSize);
+      if( data.size() < frameSize ) {
+        return false;
+      }
+      stats->accumulate(reinterpret_cast<const int16_t*>(data.data()), data.size()/frameSize);
+    }
+
+    return true;
+  }
+
+  bool sampleStereo(pcm::StereoStatistics *stats, const QString& filename,
+                    const AacFormat& format, const uint64_t maxFrames)
+  {
+    // (1) WAV is read natively //////////////////////////////////////////////
+
+    if( filename.endsWith(QStringLiteral(".wav"), Qt::CaseInsensitive) ) {
+      return sampleWave(stats, filename, maxFrames);
+    }
+
+    // (2) Everything else is decoded by Qt at the native rate ///////////////
+
+    unsigned int rate = format.numSamplesPerSecond;
+    probe::samplingRate(cs::toPath(filename), &rate);
+
+    QAudioFormat pcmFormat;
+    pcmFormat.setByteOrder(static_cast<QAudioFormat::Endian>(QSysInfo::ByteOrder));
+    pcmFormat.setChannelCount(2);
+    pcmFormat.setCodec(QStringLiteral("audio/pcm"));
+    pcmFormat.setSampleRate(static_cast<int>(rate));
+    pcmFormat.setSampleSize(16);
+    pcmFormat.setSampleType(QAudioFormat::SignedInt);
+
+    QAudioDecoder decoder;
+    decoder.setAudioFormat(pcmFormat);
+    decoder.setSourceFilename(filename);
+
+    bool is_done = false;
+    bool ok = true;
+    QEventLoop loop;
+    const auto done = [&](const bool success) -> void {
+      decoder.stop();
+      is_done = true;
+      ok = ok  &&  success;
+      loop.quit();
+    };
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, [&]() -> void {
+      while( !is_done  &&  decoder.bufferAvailable() ) {
+        const QAudioBuffer buffer = decoder.read();
+        if( buffer.format().channelCount() != 2  ||  buffer.format().sampleSize() != 16 ) {
+          done(false);
+          return;
+        }
+
+        const uint64_t numFrames = std::min<uint64_t>(uint64_t(buffer.frameCount()),
+                                                      maxFrames - stats->numFrames);
+        stats->accumulate(buffer.constData<int16_t>(), std::size_t(numFrames));
+        if( stats->numFrames >= maxFrames ) {
+          done(true);
+        }
+      }
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, [&]() -> void {
+      done(true);
+    });
+    QObject::connect(&decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+                     [&]() -> void {
+      done(false);
+    });
+
+    decoder.start();
+    if( !is_done  &&  decoder.error() == QAudioDecoder::NoError ) {
+      loop.exec();
+    }
+
+    return ok  &&  decoder.error() == QAudioDecoder::NoError;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+QString autoChapterName(const QStringList& files)
+{
+  if( files.isEmpty() ) {
+    return QString();
+  }
+  QString name = QFileInfo(files.front()).completeBaseName();
+  name.remove(QRegExp(QStringLiteral("^\\s*"), Qt::CaseInsensitive));
+  name.remove(QRegExp(QStringLiteral("^cd\\s*"), Qt::CaseInsensitive));
+  name.remove(QRegExp(QStringLiteral("^\\d+\\s*"), Qt::CaseInsensitive));
+  name.remove(QRegExp(QStringLiteral("^[-_]+\\s*"), Qt::CaseInsensitive));
+  return name.trimmed();
+}
+
+Job buildJob(const int position, const QString& title, const QStringList& files)
+{
+  Job job;
+  job.position   = position;
+  job.inputFiles = files;
+  job.title      = title;
+
+  if( !files.isEmpty() ) {
+    job.outputDirPath = QFileInfo(files.front()).absolutePath();
+  }
+
+  job.cost = job.estimateCost();
+
+  return job;
+}
+
+QList<QStringList> groupByChapterName(const QStringList& files)
+{
+  QList<QStringList> result;
+
+  QString prevName;
+  for(const QString& filename : files) {
+    const QString name = autoChapterName(QStringList(filename));
+    if( result.isEmpty()  ||  name.isEmpty()  ||  name != prevName ) {
+      result.push_back(QStringList());
+    }
+    result.back().push_back(filename);
+    prevName = name;
+  }
+
+  return result;
+}
+
+QStringList listAudioFiles(const QString& dirPath)
+{
+  const QDir dir(dirPath);
+  const QList<QFileInfo> audioFiles =
+      dir.entryInfoList({QStringLiteral("*.mp3"), QStringLiteral("*.wav")},
+                        QDir::Files, QDir::Name);
+
+  QStringList fileNames;
+  for(const QFileInfo& fileInfo : audioFiles) {
+    fileNames.push_back(fileInfo.absoluteFilePath());
+  }
+
+  return fileNames;
+}
+
+AacFormat negotiateNativeRate(const AacFormat& format, const Jobs& jobs)
+{
+  unsigned int nativeRate = 0;
+  for(const Job& job : jobs) {
+    for(const QString& filename : job.inputFiles) {
+      unsigned int rate = 0;
+      if( !probe::samplingRate(cs::toPath(filename), &rate)  ||
+          (nativeRate != 0  &&  rate != nativeRate) ) {
+        return format;
+      }
+      nativeRate = rate;
+    }
+  }
+
+  AacFormat result = format;
+  result.numSamplesPerSecond = nativeRate;
+
+  return result.isValid()
+      ? result
+      : format;
+}
+
+bool negotiateDualMono(Jobs& jobs, const int threshold, const unsigned int analysisSeconds)
+{
+  bool is_dualMono = !jobs.isEmpty();
+  for(Job& job : jobs) {
+    job.downmix   = false;
+    job.sideLevel = std::numeric_limits<double>::quiet_NaN();
+
+    const AacFormat& format = job.format;
+    if( !job.variants.isEmpty()  ||  format.numChannels != 2  ||
+        format.numBitsPerChannel != 16  ||  format.profile == AacProfile::HE_AACv2 ) {
+      is_dualMono = false;
+      continue;
+    }
+
+    // NOTE: A chapter's leading seconds may span several input files.
+    const uint64_t maxFrames = uint64_t(analysisSeconds)*format.numSamplesPerSecond;
+    pcm::StereoStatistics stats;
+    bool ok = true;
+    for(const QString& filename : job.inputFiles) {
+      if( !ok  ||  stats.numFrames >= maxFrames ) {
+        break;
+      }
+      ok = priv::sampleStereo(&stats, filename, format, maxFrames);
+    }
+
+    if( ok  &&  stats.numFrames > 0 ) {
+      job.sideLevel = stats.sideLevel();
+    }
+    is_dualMono = is_dualMono  &&  ok  &&  stats.numFrames > 0  &&  stats.isDualMono(threshold);
+  }
+
+  for(Job& job : jobs) {
+    job.downmix = is_dualMono;
+  }
+
+  return is_dualMono;
+}
+
+QString numberedChapterTitle(const QString& title, const int number, const int width)
+{
+  return QStringLiteral("%1 - %2")
+      .arg(number, width, 10, QChar::fromLatin1('0'))
+      .arg(title);
+}
@@ -0,0 +1,303 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QXmlStreamReader>
+#include <QtCore/QXmlStreamWriter>
+
+#include <cs/Core/QStringUtil.h>
+
+#include "JobManifest.h"
+
+#include "Checksum.h"
+
+#define XML_CHAPTER   QStringLiteral("chapter")
+#define XML_CHECKSUM  QStringLiteral("checksum")
+#define XML_FRAMES    QStringLiteral("frames")
+#define XML_INPUT     QStringLiteral("input")
+#define XML_MANIFEST  QStringLiteral("manifest")
+#define XML_OUTPUT    QStringLiteral("output")
+#define XML_SETTINGS  QStringLiteral("settings")
+#define XML_SIZE      QStringLiteral("size")
+#define XML_TITLE     QStringLiteral("title")
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  using Entries = std::map<QString,JobManifestEntry>;
+
+  void readChapter(QXmlStreamReader& xml, Entries& entries)
+  {
+    JobManifestEntry entry;
+    while( xml.readNextStartElement() ) {
+      if(        xml.name() == XML_TITLE ) {
+        entry.title = xml.readElementText();
+      } else if( xml.name() == XML_SETTINGS ) {
+        entry.settings = xml.readElementText();
+      } else if( xml.name() == XML_INPUT ) {
+        entry.inputSizes.push_back(xml.attributes().value(XML_SIZE).toLongLong());
+        entry.inputFiles.push_back(xml.readElementText());
+      } else if( xml.name() == XML_OUTPUT ) {
+        entry.outputChecksum = xml.attributes().value(XML_CHECKSUM).toULongLong(nullptr, 16);
+        entry.numPcmFrames   = xml.attributes().value(XML_FRAMES).toULongLong();
+        entry.outputSize     = xml.attributes().value(XML_SIZE).toLongLong();
+        entry.outputFileName = xml.readElementText();
+      } else {
+        xml.skipCurrentElement();
+      }
+    }
+
+    if( entry.inputFiles.isEmpty()  ||  entry.outputFileName.isEmpty()  ||
+        entry.numPcmFrames < 1 ) {
+      return;
+    }
+
+    entries[entry.outputFileName] = entry;
+  }
+
+  void readManifest(QXmlStreamReader& xml, Entries& entries)
+  {
+    while( xml.readNextStartElement() ) {
+      if( xml.name() == XML_CHAPTER ) {
+        readChapter(xml, entries);
+      } else {
+        xml.skipCurrentElement();
+      }
+    }
+  }
+
+  qint64 fileSize(const QString& filename)
+  {
+    const QFileInfo info(filename);
+    return info.isFile()
+        ? info.size()
+        : -1;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+JobManifest::JobManifest()
+  : _entries()
+  , _filename()
+  , _mutex()
+{
+}
+
+JobManifest::~JobManifest()
+{
+}
+
+bool JobManifest::isOpen() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return !_filename.isEmpty();
+}
+
+bool JobManifest::open(const QString& outputDirPath)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if( !_filename.isEmpty()  ||  !QFileInfo(outputDirPath).isDir() ) {
+    return false;
+  }
+
+  _entries.clear();
+  _filename = QDir(outputDirPath).absoluteFilePath(fileName());
+
+  // NOTE: A missing or damaged manifest yields an empty one.
+
+  QFile file(_filename);
+  if( !file.open(QIODevice::ReadOnly) ) {
+    return true;
+  }
+
+  QXmlStreamReader xml(&file);
+
+  while( xml.readNextStartElement() ) {
+    if( xml.name() == XML_MANIFEST ) {
+      priv::readManifest(xml, _entries);
+    } else {
+      xml.skipCurrentElement();
+    }
+  }
+
+  return true;
+}
+
+bool JobManifest::lookup(const Job& job, const QString& settings, const QString& outputFilePath,
+                         uint64_t *numPcmFrames) const
+{
+  if( numPcmFrames == nullptr ) {
+    return false;
+  }
+
+  // (1) Find entry //////////////////////////////////////////////////////////
+
+  JobManifestEntry entry;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const auto iter = _entries.find(QFileInfo(outputFilePath).fileName());
+    if( iter == _entries.cend() ) {
+      return false;
+    }
+    entry = iter->second;
+  }
+
+  // (2) Compare job's title, settings and input files ///////////////////////
+
+  if( entry.title != job.title  ||  entry.settings != settings  ||
+      entry.inputFiles != job.inputFiles ) {
+    return false;
+  }
+
+  for(int i = 0; i < entry.inputFiles.size(); i++) {
+    if( priv::fileSize(entry.inputFiles[i]) != entry.inputSizes.value(i, -1) ) {
+      return false;
+    }
+  }
+
+  // (3) Verify output file //////////////////////////////////////////////////
+
+  if( priv::fileSize(outputFilePath) != entry.outputSize ) {
+    return false;
+  }
+
+  uint64_t checksum = 0;
+  if( !checksum::xxh64(cs::toPath(outputFilePath), &checksum)  ||
+      checksum != entry.outputChecksum ) {
+    return false;
+  }
+
+  *numPcmFrames = entry.numPcmFrames;
+
+  return true;
+}
+
+bool JobManifest::record(const Job& job, const QString& settings, const JobResult& result)
+{
+  if( !result.isValid() ) {
+    return false;
+  }
+
+  // (1) Create entry; the output file is hashed outside of the lock /////////
+
+  JobManifestEntry entry;
+  entry.inputFiles     = job.inputFiles;
+  entry.numPcmFrames   = result.numPcmFrames;
+  entry.outputFileName = QFileInfo(result.outputFilePath).fileName();
+  entry.settings       = settings;
+  entry.title          = job.title;
+
+  for(const QString& filename : job.inputFiles) {
+    entry.inputSizes.push_back(priv::fileSize(filename));
+  }
+
+  uint64_t size = 0;
+  if( !checksum::xxh64(cs::toPath(result.outputFilePath), &entry.outputChecksum, &size) ) {
+    return false;
+  }
+  entry.outputSize = qint64(size);
+
+  // (2) Store entry & save manifest /////////////////////////////////////////
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if( _filename.isEmpty() ) {
+    return false;
+  }
+
+  try {
+    _entries[entry.outputFileName] = entry;
+  } catch(...) {
+    return false;
+  }
+
+  return save();
+}
+
+QString JobManifest::fileName()
+{
+  return QStringLiteral("AudioBooQer.manifest");
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool JobManifest::save() const
+{
+  QSaveFile file(_filename);
+  if( !file.open(QIODevice::WriteOnly) ) {
+    return false;
+  }
+
+  QXmlStreamWriter xml(&file);
+  xml.setAutoFormatting(true);
+  xml.setAutoFormattingIndent(2);
+  xml.writeStartDocument();
+
+  xml.writeStartElement(XML_MANIFEST); // Begin Manifest /////////////////////
+
+  for(const auto& [name, entry] : _entries) {
+    xml.writeStartElement(XML_CHAPTER); // Begin Chapter /////////////////////
+
+    xml.writeTextElement(XML_TITLE,    entry.title);
+    xml.writeTextElement(XML_SETTINGS, entry.settings);
+
+    for(int i = 0; i < entry.inputFiles.size(); i++) {
+      xml.writeStartElement(XML_INPUT);
+      xml.writeAttribute(XML_SIZE, QString::number(entry.inputSizes.value(i, -1)));
+      xml.writeCharacters(entry.inputFiles[i]);
+      xml.writeEndElement();
+    }
+
+    xml.writeStartElement(XML_OUTPUT);
+    xml.writeAttribute(XML_CHECKSUM, QString::number(entry.outputChecksum, 16));
+    xml.writeAttribute(XML_FRAMES,   QString::number(entry.numPcmFrames));
+    xml.writeAttribute(XML_SIZE,     QString::number(entry.outputSize));
+    xml.writeCharacters(name);
+    xml.writeEndElement();
+
+    xml.writeEndElement(); // End Chapter ////////////////////////////////////
+  }
+
+  xml.writeEndElement(); // End Manifest /////////////////////////////////////
+
+  xml.writeEndDocument();
+
+  return !xml.hasError()  &&  file.commit();
+}
@@ -0,0 +1,224 @@
+/****************************************************************************
+** Copyright (c) 2020, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <numeric>
+
+#include <QtCore/QEventLoop>
+
+#include <cs/Logging/ILogger.h>
+
+#include "JobRunner.h"
+
+#include "AudioJob.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  std::vector<int> dispatchOrder(const Jobs& jobs)
+  {
+    // NOTE: Chapters written by Mp4ChapterWriter are dispatched in order.
+    if( jobs.isEmpty()  ||  jobs.front().writer != nullptr ) {
+      return std::vector<int>();
+    }
+
+    std::vector<int> order;
+    try {
+      order.resize(std::size_t(jobs.size()));
+    } catch(...) {
+      return std::vector<int>();
+    }
+
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) -> bool {
+      return jobs[a].cost > jobs[b].cost;
+    });
+
+    return order;
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+JobRunner::JobRunner(const std::size_t numThreads, QObject *parent)
+  : QObject(parent)
+  , _active()
+  , _firstNotDone(0)
+  , _future()
+  , _isDone()
+  , _jobs()
+  , _numDone(0)
+  , _numStarted(0)
+  , _order()
+  , _scheduler(numThreads)
+{
+}
+
+JobRunner::~JobRunner()
+{
+  // NOTE: Jobs' tasks are executed by the scheduler!
+  _active.clear();
+}
+
+QFuture<JobResult> JobRunner::future()
+{
+  return _future.future();
+}
+
+bool JobRunner::isFinished() const
+{
+  return _active.empty();
+}
+
+bool JobRunner::start(const Jobs& jobs)
+{
+  if( !isFinished() ) {
+    return false;
+  }
+
+  try {
+    _isDone.assign(std::size_t(jobs.size()), false);
+  } catch(...) {
+    return false;
+  }
+
+  _firstNotDone = 0;
+  _jobs         = jobs;
+  _numDone      = 0;
+  _numStarted   = 0;
+  _order        = priv::dispatchOrder(_jobs);
+
+  _future = QFutureInterface<JobResult>();
+  _future.reportStarted();
+  _future.setProgressRange(0, _jobs.size());
+  _future.setProgressValue(0);
+
+  startJobs();
+
+  return true;
+}
+
+void JobRunner::waitForFinished()
+{
+  if( isFinished() ) {
+    return;
+  }
+
+  QEventLoop loop;
+  connect(this, &JobRunner::finished, &loop, &QEventLoop::quit);
+  loop.exec();
+}
+
+////// private slots /////////////////////////////////////////////////////////
+
+void JobRunner::jobDone()
+{
+  const AudioJob *job = qobject_cast<const AudioJob*>(sender());
+
+  JobResult result;
+  for(auto iter = _active.begin(); iter != _active.end(); ++iter) {
+    if( iter->second.get() == job ) {
+      result = iter->second->result();
+      setDone(iter->first);
+      _active.erase(iter);
+      break;
+    }
+  }
+  _future.reportResult(result);
+  _future.setProgressValue(++_numDone);
+  emit jobFinished(result);
+
+  startJobs();
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+std::size_t JobRunner::maxActive() const
+{
+  /*
+   * NOTE:
+   * Keep more jobs in flight than there are workers; while one job waits for
+   * its decoder, the workers encode and mux the others' buffers.
+   */
+  return 2*_scheduler.numThreads();
+}
+
+void JobRunner::setDone(const int index)
+{
+  _isDone[std::size_t(index)] = true;
+  while( _firstNotDone < _jobs.size()  &&  _isDone[std::size_t(_firstNotDone)] ) {
+    _firstNotDone++;
+  }
+}
+
+void JobRunner::startJobs()
+{
+  while( _numStarted < _jobs.size()  &&  _active.size() < maxActive()  &&
+         !_future.isCanceled() ) {
+    // NOTE: Without order, dispatch jobs in chapter order.
+    const int index = !_order.empty()
+        ? _order[std::size_t(_numStarted)]
+        : _numStarted;
+
+    // NOTE: Do not run ahead of the chapter, that Mp4ChapterWriter waits for.
+    if( _jobs[index].writer != nullptr  &&
+        std::size_t(index - _firstNotDone) >= maxActive() ) {
+      break;
+    }
+    _numStarted++;
+
+    const Job& job = _jobs[index];
+
+    AudioJob *audio = nullptr;
+    try {
+      _active.emplace_back(index, std::make_unique<AudioJob>(job, &_scheduler));
+      audio = _active.back().second.get();
+    } catch(...) {
+      job.logger->logError(u8"ERROR: AudioJob is <nullptr>!\n");
+      setDone(index);
+      _future.reportResult(JobResult());
+      _future.setProgressValue(++_numDone);
+      emit jobFinished(JobResult());
+      continue;
+    }
+
+    connect(audio, &AudioJob::done,
+            this, &JobRunner::jobDone, Qt::QueuedConnection);
+    audio->start();
+  }
+
+  if( _active.empty()  &&  !_future.isFinished() ) {
+    _future.reportFinished();
+    emit finished();
+  }
+}
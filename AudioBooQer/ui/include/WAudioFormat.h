@@ -47,6 +47,7 @@ public:
   ~WAudioFormat();
 
   AacFormat format() const;
+  bool isNativeRate() const;
 
 private:
   Ui::WAudioFormat *ui;
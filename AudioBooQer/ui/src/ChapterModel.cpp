@@ -38,25 +38,7 @@
 #include "ChapterModel.h"
 
 #include "Chapter.h"
-
-////// Private ///////////////////////////////////////////////////////////////
-
-namespace priv {
-
-  QString autoChapterName(const QStringList& files)
-  {
-    if( files.isEmpty() ) {
-      return QString();
-    }
-    QString name = QFileInfo(files.front()).completeBaseName();
-    name.remove(QRegExp(QStringLiteral("^\\s*"), Qt::CaseInsensitive));
-    name.remove(QRegExp(QStringLiteral("^cd\\s*"), Qt::CaseInsensitive));
-    name.remove(QRegExp(QStringLiteral("^\\d+\\s*"), Qt::CaseInsensitive));
-    name.remove(QRegExp(QStringLiteral("^[-_]+\\s*"), Qt::CaseInsensitive));
-    return name.trimmed();
-  }
-
-} // namespace priv
+#include "JobBuilder.h"
 
 ////// public ////////////////////////////////////////////////////////////////
 
@@ -102,7 +84,7 @@ QModelIndex ChapterModel::createNewChapter(const QModelIndex& index)
   ChapterNode *newNode = new ChapterNode(root);
   root->insert(newNode);
   if( _autoChapterName ) {
-    const QString title = priv::autoChapterName(files);
+    const QString title = autoChapterName(files);
     if( !title.isEmpty() ) {
       newNode->setTitle(title);
     }
@@ -159,22 +141,17 @@ Jobs ChapterModel::buildJobs() const
   for(int cntNode = 0; cntNode < rowCount(QModelIndex()) - 1; cntNode++) {
     const QModelIndex nodeIndex = index(cntNode, 0, QModelIndex());
 
-    Job job;
-    job.position = nodeIndex.row() + _firstChapterNo;
-
+    QStringList inputFiles;
     for(int cntFile = 0; cntFile < rowCount(nodeIndex); cntFile++) {
       const QModelIndex fileIndex = index(cntFile, 0, nodeIndex);
 
       ChapterFile *file = dynamic_cast<ChapterFile*>(cs::treeItem(fileIndex));
-      job.inputFiles.push_back(file->fileName());
+      inputFiles.push_back(file->fileName());
     } // File
 
     ChapterNode *node = dynamic_cast<ChapterNode*>(cs::treeItem(nodeIndex));
-    job.title = chapterTitle(node);
-
-    job.outputDirPath = QFileInfo(job.inputFiles.front()).absolutePath();
 
-    jobs.push_back(job);
+    jobs.push_back(buildJob(nodeIndex.row() + _firstChapterNo, chapterTitle(node), inputFiles));
   } // Node
 
   return jobs;
@@ -420,9 +397,7 @@ void ChapterModel::setPlayingFileName(const QString& fileName)
 QString ChapterModel::chapterTitle(const class ChapterNode *node) const
 {
   if( _showChapterNo ) {
-    return QStringLiteral("%1 - %2")
-        .arg(_firstChapterNo + node->row(), _widthChapterNo, 10, cs::L1C('0'))
-        .arg(node->title());
+    return numberedChapterTitle(node->title(), _firstChapterNo + node->row(), _widthChapterNo);
   }
   return node->title();
 }
@@ -64,6 +64,38 @@ WAudioFormat::WAudioFormat(QWidget *parent, Qt::WindowFlags f)
   ui->bitsCombo->addItem(QStringLiteral("8"),  static_cast<unsigned int>(8));
   ui->bitsCombo->addItem(QStringLiteral("16"), static_cast<unsigned int>(16));
   ui->bitsCombo->setCurrentText(QStringLiteral("16"));
+
+  // Profile /////////////////////////////////////////////////////////////////
+
+  ui->profileCombo->clear();
+  ui->profileCombo->addItem(QStringLiteral("AAC-LC"),   static_cast<unsigned int>(AacProfile::AAC_LC));
+  ui->profileCombo->addItem(QStringLiteral("HE-AAC"),   static_cast<unsigned int>(AacProfile::HE_AAC));
+  ui->profileCombo->addItem(QStringLiteral("HE-AACv2"), static_cast<unsigned int>(AacProfile::HE_AACv2));
+  ui->profileCombo->setCurrentText(QStringLiteral("AAC-LC"));
+
+  // Bitrate /////////////////////////////////////////////////////////////////
+
+  ui->bitRateCombo->clear();
+  for(const unsigned int kbps : {24, 32, 48, 64, 96, 128}) {
+    ui->bitRateCombo->addItem(QString::number(kbps) + QStringLiteral("kbit/s"), kbps*1000);
+  }
+  ui->bitRateCombo->setCurrentText(QString::number(AacFormat::defaultBitRate/1000) +
+                                   QStringLiteral("kbit/s"));
+
+  // Mode ////////////////////////////////////////////////////////////////////
+
+  ui->modeCombo->clear();
+  ui->modeCombo->addItem(QStringLiteral("CBR"), static_cast<unsigned int>(0));
+  for(unsigned int mode = 1; mode <= AacFormat::maxBitRateMode; mode++) {
+    ui->modeCombo->addItem(QStringLiteral("VBR %1").arg(mode), mode);
+  }
+  ui->modeCombo->setCurrentText(QStringLiteral("CBR"));
+
+  // NOTE: The bitrate is ignored by VBR.
+  connect(ui->modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+          this, [this](int) -> void {
+    ui->bitRateCombo->setEnabled(ui->modeCombo->currentData().toUInt() == 0);
+  });
 }
 
 WAudioFormat::~WAudioFormat()
@@ -77,6 +109,14 @@ AacFormat WAudioFormat::format() const
   result.numBitsPerChannel     = ui->bitsCombo->currentData().toUInt();
   result.numChannels           = ui->channelsCombo->currentData().toUInt();
   result.numSamplesPerSecond   = ui->rateCombo->currentData().toUInt();
+  result.bitRate               = ui->bitRateCombo->currentData().toUInt();
+  result.bitRateMode           = ui->modeCombo->currentData().toUInt();
+  result.profile               = static_cast<AacProfile>(ui->profileCombo->currentData().toUInt());
 
   return result;
 }
+
+bool WAudioFormat::isNativeRate() const
+{
+  return ui->nativeCheck->isChecked();
+}
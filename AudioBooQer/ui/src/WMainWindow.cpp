@@ -29,27 +29,36 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
-#include <QtConcurrent/QtConcurrentMap>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QSettings>
-#include <QtCore/QThreadPool>
+#include <QtCore/QStandardPaths>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMessageBox>
 
 #include <cs/Core/QStringUtil.h>
+#include <cs/Logging/ILogger.h>
 #include <cs/Logging/OutputContext.h>
 #include <cs/Logging/WProgressLogger.h>
 
 #include "WMainWindow.h"
 #include "ui_WMainWindow.h"
 
+#include "AacEncoder.h"
 #include "BinderIO.h"
+#include "BufferedFileWriter.h"
 #include "Chapter.h"
 #include "ChapterModel.h"
+#include "EncodeCache.h"
+#include "JobBuilder.h"
+#include "JobManifest.h"
+#include "JobRunner.h"
+#include "Mp4ChapterWriter.h"
 #include "Mpeg4Audio.h"
 #include "Output.h"
+#include "ParallelAacEncoder.h"
 #include "Settings.h"
 #include "WBookBinder.h"
 #include "WTagEditor.h"
@@ -58,14 +67,37 @@
 
 namespace priv {
 
-  void complementJobs(Jobs& jobs, const cs::ILogger *logger, const QString& outputDirPath,
-                      const Ui::WMainWindow *ui)
+  void complementJobs(Jobs& jobs, const AacFormat& format, const cs::ILogger *logger,
+                      const QString& outputDirPath, Mp4ChapterWriter *writer,
+                      EncodeCache *cache, JobManifest *manifest, const Ui::WMainWindow *ui)
   {
     for(Job& job : jobs) {
-      job.format        = ui->formatWidget->format();
+      job.cache         = cache;
+      job.format        = format;
       job.logger        = logger;
+      job.manifest      = manifest;
       job.outputDirPath = outputDirPath;
       job.renameInput   = ui->renameCheck->isChecked();
+      job.writer        = writer;
+    }
+  }
+
+  void logStatistics(const cs::ILogger *logger)
+  {
+    const uint64_t numWrites = BufferedFileWriter::totalNumWrites();
+    if( numWrites > 0 ) {
+      logger->logText(cs::toUtf8String(QStringLiteral("INFO: Wrote %1 KiB in %2 writes.")
+                                       .arg(BufferedFileWriter::totalNumBytes()/1024)
+                                       .arg(numWrites)));
+    }
+
+    const AacEncoderPoolStatistics stats = AacEncoder::poolStatistics();
+    if( stats.numReused > 0 ) {
+      logger->logText(cs::toUtf8String(QStringLiteral("INFO: Reused %1 of %2 AAC encoders; "
+                                                      "saved %3s setup.")
+                                       .arg(stats.numReused)
+                                       .arg(stats.numReused + stats.numCreated)
+                                       .arg(stats.numSecondsSaved(), 0, 'f', 3)));
     }
   }
 
@@ -210,9 +242,15 @@ void WMainWindow::bindBook()
   dialog.setWindowTitle(QStringLiteral("Binding book..."));
   const cs::OutputContext ctx(dialog.logger(), true, dialog.progress(), true);
 
+  // NOTE: Indexed chapters (e.g. of the EncodeCache) are not scanned again.
+  const auto outputBinder = isAdtsBinderIndexed(binder)
+      ? outputAdtsBinder
+      : outputAdtsBinderStreaming;
+
   dialog.show();
-  outputAdtsBinder(cs::toUtf8String(filename), binder, ctx,
-                   cs::toUtf8String(ui->languageCombo->currentData().toString()));
+  outputBinder(cs::toUtf8String(filename), binder, ctx,
+               cs::toUtf8String(ui->languageCombo->currentData().toString()),
+               ui->formatWidget->format().profile);
   dialog.exec();
 }
 
@@ -272,15 +310,7 @@ void WMainWindow::openDirectory()
 
   ui->playerWidget->reset();
 
-  const QDir dir(dirPath);
-  const QList<QFileInfo> audioFiles =
-      dir.entryInfoList({QStringLiteral("*.mp3"), QStringLiteral("*.wav")},
-                        QDir::Files, QDir::Name);
-
-  QStringList fileNames;
-  foreach(const QFileInfo& fileInfo, audioFiles) {
-    fileNames.push_back(fileInfo.absoluteFilePath());
-  }
+  const QStringList fileNames = listAudioFiles(dirPath);
 
   ChapterRoot *root = new ChapterRoot();
   ChapterNode *sources = new ChapterNode(root, true);
@@ -303,17 +333,35 @@ void WMainWindow::processJobs()
   // (1) Sanity check UI /////////////////////////////////////////////////////
 
   if( !ui->formatWidget->format().isValid() ) {
+    QMessageBox::critical(this, tr("Error"),
+                          tr("Invalid format! HE-AAC requires a rate of %1Hz to %2Hz; "
+                             "HE-AACv2 also requires Stereo.")
+                          .arg(AacFormat::minSbrRate).arg(AacFormat::maxSbrRate));
     return;
   }
 
-  // (2) Query destination folder ////////////////////////////////////////////
+  const bool isDirect = ui->directCheck->isChecked();
 
-  const QString outputDirPath =
-      QFileDialog::getExistingDirectory(this,
-                                        tr("Open Directory"),
-                                        QDir::currentPath());
-  if( outputDirPath.isEmpty() ) {
-    return;
+  // (2) Query destination folder or audiobook ///////////////////////////////
+
+  QString outputDirPath;
+  QString bookFilename;
+  if( isDirect ) {
+    bookFilename =
+        QFileDialog::getSaveFileName(this, tr("Save"),
+                                     QDir::currentPath(), tr("Audiobooks (*.m4b)"));
+    if( bookFilename.isEmpty() ) {
+      return;
+    }
+    outputDirPath = QFileInfo(bookFilename).absolutePath();
+  } else {
+    outputDirPath =
+        QFileDialog::getExistingDirectory(this,
+                                          tr("Open Directory"),
+                                          QDir::currentPath());
+    if( outputDirPath.isEmpty() ) {
+      return;
+    }
   }
 
   // (3) Build jobs from ChapterModel ////////////////////////////////////////
@@ -329,30 +377,87 @@ void WMainWindow::processJobs()
   }
   model->deleteJobs();
 
-  // (4) Maintain state of audio player //////////////////////////////////////
+  // (4) Encode at the inputs' native rate, if possible //////////////////////
+
+  const AacFormat format = ui->formatWidget->isNativeRate()
+      ? negotiateNativeRate(ui->formatWidget->format(), jobs)
+      : ui->formatWidget->format();
+
+  // (5) Maintain state of audio player //////////////////////////////////////
 
   ui->playerWidget->stop();
   ui->playerWidget->setFiles(model->files());
 
-  // (5) Execute jobs ////////////////////////////////////////////////////////
+  // (6) Execute jobs ////////////////////////////////////////////////////////
 
-  QThreadPool::globalInstance()->setMaxThreadCount(ui->threadSpin->value());
+  ParallelAacEncoder::setMaxThreadCount(std::size_t(ui->threadSpin->value()));
 
   cs::WProgressLogger dialog(this);
   dialog.setWindowTitle(QStringLiteral("Executing jobs..."));
 
-  priv::complementJobs(jobs, dialog.logger(), outputDirPath, ui);
+  const cs::OutputContext ctx(dialog.logger(), true, dialog.progress(), true);
+
+  Mp4ChapterWriter writer(ctx);
+  if( isDirect  &&
+      !writer.open(cs::toPath(bookFilename), format.numSamplesPerSecond,
+                   jobs.front().position, int(jobs.size())) ) {
+    QMessageBox::critical(this, tr("Error"),
+                          tr("Unable to create audiobook \"%1\"!").arg(bookFilename));
+    return;
+  }
+
+  EncodeCache cache;
+  if( ui->cacheCheck->isChecked()  &&
+      !cache.open(cs::toPath(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+                             .absoluteFilePath(QStringLiteral("encodes")))) ) {
+    dialog.logger()->logWarning(u8"Unable to open encode cache!");
+  }
+
+  // NOTE: An audiobook is written as a whole; thus, it cannot be resumed.
+  JobManifest manifest;
+  if( !isDirect  &&  !manifest.open(outputDirPath) ) {
+    dialog.logger()->logWarning(u8"Unable to open job manifest!");
+  }
+
+  if( format.numSamplesPerSecond != ui->formatWidget->format().numSamplesPerSecond ) {
+    dialog.logger()->logText(cs::toUtf8String(QStringLiteral("INFO: Encoding at the inputs' rate of %1Hz.")
+                                              .arg(format.numSamplesPerSecond)));
+  }
+
+  priv::complementJobs(jobs, format, dialog.logger(), outputDirPath,
+                       isDirect ? &writer : nullptr, cache.isOpen() ? &cache : nullptr,
+                       manifest.isOpen() ? &manifest : nullptr, ui);
+  if( ui->dualMonoCheck->isChecked()  &&  negotiateDualMono(jobs) ) {
+    dialog.logger()->logText(u8"INFO: All chapters are dual-mono; encoding as Mono.");
+  }
 
   QFutureWatcher<JobResult> watcher;
   dialog.setFutureWatcher(&watcher);
 
-  QFuture<JobResult> future = QtConcurrent::mapped(jobs, executeJob);
+  AacEncoder::resetPoolStatistics();
+  BufferedFileWriter::resetTotals();
+  connect(&watcher, &QFutureWatcher<JobResult>::finished, [&]() -> void {
+    priv::logStatistics(dialog.logger());
+  });
+
+  JobRunner runner(std::size_t(ui->threadSpin->value()));
+  runner.start(jobs);
+
+  QFuture<JobResult> future = runner.future();
   watcher.setFuture(future);
 
   dialog.exec();
-  future.waitForFinished();
+  runner.waitForFinished();
+
+  // (7) Finish audiobook or (optionally) save to binder /////////////////////
 
-  // (6) (Optionally) Save to binder /////////////////////////////////////////
+  if( isDirect ) {
+    if( !writer.close(cs::toUtf8String(ui->languageCombo->currentData().toString())) ) {
+      QMessageBox::critical(this, tr("Error"),
+                            tr("Error writing audiobook \"%1\"!").arg(bookFilename));
+    }
+    return;
+  }
 
   if( QMessageBox::question(this, tr("Question"), tr("Create binder?"),
                             QMessageBox::Yes | QMessageBox::No,
@@ -378,6 +483,12 @@ void WMainWindow::loadSettings()
 
   Settings::load(settings, ui->threadSpin,
                  QStringLiteral("global/num_threads"), numThreads);
+  Settings::load(settings, ui->directCheck,
+                 QStringLiteral("global/direct_output"), false);
+  Settings::load(settings, ui->cacheCheck,
+                 QStringLiteral("global/encode_cache"), false);
+  Settings::load(settings, ui->dualMonoCheck,
+                 QStringLiteral("global/dual_mono"), false);
 }
 
 void WMainWindow::saveSettings() const
@@ -387,6 +498,9 @@ void WMainWindow::saveSettings() const
 
   settings.beginGroup(QStringLiteral("global"));
   settings.setValue(QStringLiteral("num_threads"), ui->threadSpin->value());
+  settings.setValue(QStringLiteral("direct_output"), ui->directCheck->isChecked());
+  settings.setValue(QStringLiteral("encode_cache"), ui->cacheCheck->isChecked());
+  settings.setValue(QStringLiteral("dual_mono"), ui->dualMonoCheck->isChecked());
   settings.endGroup();
 
   settings.sync();